@@ -0,0 +1,93 @@
+// Preprocessor Directives
+#ifndef AGENTS_HPP
+#define AGENTS_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <jobs.hpp>
+#include <maze.hpp>
+#include <pathfinding.hpp>
+#include <shader.hpp>
+#include <spatial_hash.hpp>
+
+const float AGENT_RADIUS = 0.2f;
+const float AGENT_SPEED = 1.4f; // cells per second
+
+enum AgentState : uint8_t {
+    AGENT_WALKING,
+    AGENT_PAUSED,
+};
+
+// NPCs wandering the corridors, stored as structure of arrays: every pass
+// over the agents streams through just the fields it needs, and the plain
+// arithmetic passes vectorize. Owned by the simulation thread.
+struct AgentSystem {
+    JobSystem* jobs = nullptr; // null = update on the calling thread
+    MazeBits walls;
+    int count = 0;
+
+    std::vector<float> posX, posZ;
+    std::vector<float> velX, velZ;
+    std::vector<float> nextX, nextZ; // scratch: positions before collision
+    std::vector<float> timer;        // seconds left in the current state
+    std::vector<float> heading;      // radians around +y, kept while paused
+    std::vector<uint8_t> state;
+    std::vector<uint32_t> rng; // xorshift32 per agent, so updates are order independent
+
+    SpatialHash nearby; // positions after the last update, for proximity queries
+
+    // The first `seekers` agents walk to goals of their own, planned with
+    // D* Lite, instead of wandering. Their planners are repaired in place
+    // when walls change, at the start of the next update.
+    int seekers = 0;
+    std::vector<PathPlanner> planners;
+    std::vector<int> changedCells; // row * cols + col, since the last update
+};
+
+// Scatter `count` agents over the open cells of `bits`; the same seed gives
+// the same agents
+void initAgents(AgentSystem& agents, const MazeBits& bits, int count, uint32_t seed, JobSystem* jobs = nullptr);
+
+// Make the first `count` agents seekers; their planners start empty and
+// plan at each agent's next turn
+void setAgentSeekers(AgentSystem& agents, int count);
+
+// The wall at (row, col) of agents.walls changed (already set there)
+void agentWallChanged(AgentSystem& agents, int row, int col);
+
+// Advance every agent by `dt` seconds, in parallel batches when the system
+// has jobs
+void updateAgents(AgentSystem& agents, float dt);
+
+// Per agent (x, z, heading, tint) for instanced drawing
+void writeAgentInstances(const AgentSystem& agents, std::vector<glm::vec4>& instances);
+
+// GPU side: one box per instance, built in shaders/agent.glsl from
+// gl_VertexID, so the only vertex data is the per-instance buffer
+struct AgentInstances {
+    ShaderProgram program;
+    ShaderProgram depthProgram; // for the sun's dynamic shadow map
+    GLuint vao = 0;
+    GLuint instanceBuffer = 0;
+    GLsizei count = 0;
+};
+
+bool initAgentInstances(AgentInstances& instances);
+
+// Replace the instance data (buffer orphaned, so no stall on the last frame)
+void uploadAgentInstances(AgentInstances& instances, const std::vector<glm::vec4>& data);
+
+// Expects the scene uniforms to be set on instances.program by the caller
+void drawAgentInstances(const AgentInstances& instances);
+
+void drawAgentShadows(const AgentInstances& instances, const glm::mat4& lightMatrix);
+
+void deleteAgentInstances(AgentInstances& instances);
+
+#endif //~ AGENTS_HPP
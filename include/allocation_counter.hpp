@@ -0,0 +1,17 @@
+// Preprocessor Directives
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+#pragma once
+
+// System Headers
+#include <cstdint>
+
+// Development builds replace the global operator new to count heap
+// allocations per thread, so a steady-state frame can be checked for any.
+// Release builds keep the standard operator new and count nothing.
+bool allocationCountingAvailable();
+
+// Allocations made by the calling thread so far
+uint64_t threadAllocationCount();
+
+#endif //~ ALLOCATION_COUNTER_HPP
@@ -0,0 +1,13 @@
+// Preprocessor Directives
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+#pragma once
+
+// System Headers
+#include <string>
+
+// Micro-benchmarks run from the command line with --bench NAME, before any
+// window or GL context exists. Returns false for an unknown name.
+bool runBenchmark(const std::string& name);
+
+#endif //~ BENCHMARKS_HPP
@@ -0,0 +1,103 @@
+// Preprocessor Directives
+#ifndef CHUNK_STREAMING_HPP
+#define CHUNK_STREAMING_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <jobs.hpp>
+#include <maze_mesh.hpp>
+
+// Staging ring shared by all uploads, and the default number of bytes it may
+// hand to the GPU per frame
+const GLsizeiptr STAGING_RING_BYTES = 4 << 20;
+const GLsizeiptr DEFAULT_UPLOAD_BUDGET = 256 << 10;
+
+using MazeGrid = std::vector<std::vector<int>>;
+
+struct MeshedChunk {
+    int chunk = 0;
+    uint64_t version = 0;
+    ChunkGeometry geometry;
+};
+
+// One frame's worth of copies out of the staging ring; the ring space up to
+// `end` is reusable once `fence` has signalled
+struct StagingBatch {
+    GLintptr end = 0;
+    GLsync fence = nullptr;
+};
+
+struct StreamingStats {
+    int meshing = 0;      // jobs still running
+    int waiting = 0;      // meshed, held back by the budget or a full ring
+    int uploaded = 0;     // chunks uploaded last frame
+    GLsizeiptr bytes = 0; // bytes uploaded last frame
+};
+
+// Chunks are meshed on the job system and uploaded by the render thread
+// through a fenced staging ring, at most `uploadBudget` bytes per frame.
+struct ChunkStreamer {
+    JobSystem* jobs = nullptr;
+    GLsizeiptr uploadBudget = DEFAULT_UPLOAD_BUDGET;
+    int chunksX = 0;
+
+    // shared with the meshing jobs
+    std::mutex mutex;
+    std::shared_ptr<const MazeGrid> maze; // latest requested from, for re-meshing evicted chunks
+    std::vector<MeshedChunk> finished;
+    std::vector<uint64_t> latestVersion; // per chunk; older results are dropped
+    uint64_t nextVersion = 0;
+    std::vector<JobHandle> running;
+    std::atomic<int> meshing{0};
+
+    // render thread only
+    std::vector<MeshedChunk> waiting;
+    GLuint stagingBuffer = 0;
+    GLintptr head = 0, tail = 0; // free space is [head, tail) modulo the ring
+    std::deque<StagingBatch> batches;
+    std::vector<int> uploadedChunks; // chunks changed by the last upload call
+    std::vector<uint64_t> appliedVersion; // per chunk; behind latestVersion while in flight
+    int64_t residencyKey = -1;     // camera chunk of the last residency pass
+    bool residencyDirty = true;    // chunks changed since
+    std::vector<int> residencyRequests;
+    StreamingStats stats;
+};
+
+// `jobs` may be null, in which case requests are meshed right away on the
+// calling thread (uploads still go through the ring and the budget)
+void initChunkStreamer(ChunkStreamer& streamer, const MazeMesh& mesh, JobSystem* jobs,
+                       GLsizeiptr uploadBudget = DEFAULT_UPLOAD_BUDGET);
+
+// Queue chunks for (re)meshing from `maze`, which must not change afterwards
+// (and is kept for chunks re-meshed after an eviction). Safe to call from any
+// thread.
+void requestChunkMeshes(ChunkStreamer& streamer, std::shared_ptr<const MazeGrid> maze,
+                        const std::vector<int>& chunks);
+
+// Upload finished chunks within the budget. Call once per frame on the thread
+// that owns the GL context; returns how many chunks changed (listed in
+// streamer.uploadedChunks). A chunk with walls that finds no free slot is
+// dropped; the next residency pass asks for it again if it is still wanted.
+int streamChunkUploads(ChunkStreamer& streamer, MazeMesh& mesh);
+
+// When the mesh has fewer slots than chunks: keep the chunks nearest to the
+// camera resident, evict the rest and request meshes for wanted chunks that
+// are missing. Cheap unless the camera entered another chunk or chunks
+// changed. Call before streamChunkUploads; returns how many were evicted.
+int updateChunkResidency(ChunkStreamer& streamer, MazeMesh& mesh, const glm::vec3& cameraPosition);
+
+// Waits for meshing jobs still in flight
+void deleteChunkStreamer(ChunkStreamer& streamer);
+
+#endif //~ CHUNK_STREAMING_HPP
@@ -0,0 +1,65 @@
+// Preprocessor Directives
+#ifndef CULLING_HPP
+#define CULLING_HPP
+#pragma once
+
+// System Headers
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// View frustum as six inward-facing planes (xyz = normal, w = distance)
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// Gribb/Hartmann plane extraction from a projection * view matrix
+Frustum extractFrustum(const glm::mat4& viewProjection);
+
+// Conservative AABB test: false only if the box is entirely outside one plane
+bool aabbInFrustum(const Frustum& frustum, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+// Per-frame culling counters, shown in the window title
+struct CullStats {
+    int chunks = 0;          // non-empty chunks considered
+    int frustumRejected = 0;
+    int occlusionRejected = 0;
+    int drawn = 0;
+    int impostors = 0;       // far chunks drawn as heightmap impostors
+};
+
+// Distance-based level of detail. Chunks whose horizontal distance to the
+// camera crosses [impostorStart, impostorEnd] are dither-faded from the full
+// mesh to a ray-marched impostor of the bit grid. Fog reaches fogColor at
+// fogEnd, which is also used as the far plane.
+struct LodSettings {
+    bool impostors = true;
+    float impostorStart = 24.0f;
+    float impostorEnd = 32.0f;
+    float fogStart = 30.0f;
+    float fogEnd = 60.0f;
+    glm::vec3 fogColor = glm::vec3(1.0f);
+};
+
+// Nearest and farthest horizontal (xz) distance from `point` to a box
+void aabbDistanceRangeXZ(const glm::vec3& point, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                         float& nearest, float& farthest);
+
+// CPU copy of one Hi-Z pyramid level: the farthest depth in each texel, plus
+// the matrix the depth was rendered with.
+struct OcclusionBuffer {
+    std::vector<float> depth;
+    int width = 0, height = 0;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    bool valid = false;
+};
+
+// Project a box to window space [0,1]^2 and its nearest depth in [0,1].
+// Returns false when the box crosses the near plane (treat as visible).
+bool projectAabb(const glm::mat4& viewProjection, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                 glm::vec2& rectMin, glm::vec2& rectMax, float& nearestDepth);
+
+// True when the box is behind everything recorded in `occlusion`
+bool aabbOccluded(const OcclusionBuffer& occlusion, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+#endif //~ CULLING_HPP
@@ -0,0 +1,198 @@
+// Preprocessor Directives
+#ifndef FIXED_MAZE_HPP
+#define FIXED_MAZE_HPP
+#pragma once
+
+// System Headers
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <maze.hpp>
+#include <pathfinding.hpp>
+
+// A maze whose size is part of its type, for the handful of sizes levels
+// ship in. The bits are laid out exactly as in MazeBits (rows padded to
+// whole 32-bit words), but in a std::array, so the row stride, the word
+// count and every bounds check are compile-time constants. The kernels
+// below are templates over either kind: given a Maze<W, H>, their loops
+// have constant trip counts and unroll; given MazeBits, the same code runs
+// on any size.
+template <int W, int H>
+struct Maze {
+    static_assert(W > 0 && H > 0, "a maze needs cells");
+    static constexpr int cols = W, rows = H;
+    static constexpr int wordsPerRow = (W + 31) / 32;
+    std::array<uint32_t, H * wordsPerRow> words{};
+
+    constexpr bool isWall(int row, int col) const {
+        return (words[row * wordsPerRow + (col >> 5)] >> (col & 31)) & 1u;
+    }
+    constexpr void setWall(int row, int col, bool wall) {
+        uint32_t& word = words[row * wordsPerRow + (col >> 5)];
+        word = wall ? word | (1u << (col & 31)) : word & ~(1u << (col & 31));
+    }
+};
+
+// Recursive backtracking like generateMaze (rooms on the odd cells, walls
+// knocked out between them), with an explicit stack and its own generator so
+// it can run at compile time:
+//     constexpr Maze<19, 19> level = generateFixedMaze<19, 19>(7u);
+// The same seed gives a different maze than generateMaze.
+template <int W, int H>
+constexpr Maze<W, H> generateFixedMaze(uint32_t seed) {
+    static_assert(W % 2 == 1 && H % 2 == 1 && W >= 3 && H >= 3, "rooms sit on odd cells inside an odd-sized border");
+    const int steps[4][2] = {{0, 2}, {2, 0}, {0, -2}, {-2, 0}}; // (drow, dcol)
+    Maze<W, H> maze{};
+    for (int row = 0; row < H; ++row)
+        for (int col = 0; col < W; ++col)
+            maze.setWall(row, col, true);
+
+    std::array<int, (W / 2) * (H / 2)> stack{};
+    int depth = 0;
+    uint32_t state = seed | 1u;
+    maze.setWall(1, 1, false);
+    stack[depth++] = 1 * W + 1;
+    while (depth > 0) {
+        int row = stack[depth - 1] / W, col = stack[depth - 1] % W;
+        int options[4] = {};
+        int count = 0;
+        for (int d = 0; d < 4; ++d) {
+            int r = row + steps[d][0], c = col + steps[d][1];
+            if (r > 0 && r < H - 1 && c > 0 && c < W - 1 && maze.isWall(r, c))
+                options[count++] = d;
+        }
+        if (count == 0) {
+            --depth; // dead end: back up
+            continue;
+        }
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        int d = options[state % count];
+        int r = row + steps[d][0], c = col + steps[d][1];
+        maze.setWall(row + steps[d][0] / 2, col + steps[d][1] / 2, false);
+        maze.setWall(r, c, false);
+        stack[depth++] = r * W + c;
+    }
+    return maze;
+}
+
+// Copy `bits` when it is W x H; false (and `maze` untouched) otherwise
+template <int W, int H>
+bool loadFixedMaze(const MazeBits& bits, Maze<W, H>& maze) {
+    if (bits.rows != H || bits.cols != W)
+        return false;
+    std::copy(bits.words.begin(), bits.words.end(), maze.words.begin());
+    return true;
+}
+
+template <int W, int H>
+void toMazeBits(const Maze<W, H>& maze, MazeBits& bits) {
+    bits.rows = H;
+    bits.cols = W;
+    bits.wordsPerRow = Maze<W, H>::wordsPerRow;
+    bits.words.assign(maze.words.begin(), maze.words.end());
+}
+
+// -- kernels over MazeBits or Maze<W, H> --
+
+// Whether a circle of `radius` (at most half a cell) around the world-space
+// point (x, z) overlaps a wall; a point inside a wall cell always does.
+// Cells are unit squares around mazeCellPosition(); outside the grid is open.
+template <typename Bits>
+bool circleHitsWall(const Bits& bits, float x, float z, float radius) {
+    float cellX = x + static_cast<float>(bits.cols / 2), cellZ = z + static_cast<float>(bits.rows / 2);
+    int col = static_cast<int>(std::floor(cellX + 0.5f)), row = static_cast<int>(std::floor(cellZ + 0.5f));
+    float radius2 = radius * radius;
+    // all nine cells without early outs: random positions make those
+    // branches unpredictable, and a fixed 3x3 body unrolls completely
+    bool hit = false;
+    for (int dr = -1; dr <= 1; ++dr) {
+        for (int dc = -1; dc <= 1; ++dc) {
+            int r = row + dr, c = col + dc;
+            bool wall = r >= 0 && c >= 0 && r < bits.rows && c < bits.cols && bits.isWall(r, c);
+            float dx = cellX - std::clamp(cellX, c - 0.5f, c + 0.5f);
+            float dz = cellZ - std::clamp(cellZ, r - 0.5f, r + 0.5f);
+            hit |= wall & ((dr == 0 && dc == 0) | (dx * dx + dz * dz < radius2));
+        }
+    }
+    return hit;
+}
+
+// Rows of bits shaped like `Bits`'s: arrays on the stack for a Maze<W, H>,
+// vectors (sized on first use, reused after) for MazeBits
+template <typename Bits>
+struct WavefrontScratch {
+    decltype(Bits::words) reached, frontier, next;
+};
+
+inline void clearRows(std::vector<uint32_t>& rows, size_t count) {
+    rows.assign(count, 0u);
+}
+
+template <size_t N>
+void clearRows(std::array<uint32_t, N>& rows, size_t) {
+    rows.fill(0u);
+}
+
+// Steps on the shortest path between two cells, or PATH_UNREACHABLE. A
+// breadth-first search run on whole rows at once: each step spreads the
+// frontier one cell in every direction with shifts and ors, 32 cells per
+// word op, and masks it with the open cells not reached yet.
+template <typename Bits>
+int wavefrontSteps(const Bits& bits, int fromRow, int fromCol, int toRow, int toCol, WavefrontScratch<Bits>& scratch) {
+    const int rows = bits.rows, words = bits.wordsPerRow;
+    auto inside = [&bits](int row, int col) { return row >= 0 && col >= 0 && row < bits.rows && col < bits.cols; };
+    if (!inside(fromRow, fromCol) || !inside(toRow, toCol) || bits.isWall(fromRow, fromCol) ||
+        bits.isWall(toRow, toCol))
+        return PATH_UNREACHABLE;
+
+    size_t count = static_cast<size_t>(rows) * words;
+    clearRows(scratch.reached, count);
+    clearRows(scratch.frontier, count);
+    clearRows(scratch.next, count);
+    uint32_t* reached = scratch.reached.data();
+    uint32_t* frontier = scratch.frontier.data();
+    uint32_t* next = scratch.next.data();
+    // the padding past the last column reads as open; keep the wave out of it
+    const uint32_t lastMask = bits.cols % 32 ? (1u << (bits.cols % 32)) - 1u : ~0u;
+
+    size_t from = static_cast<size_t>(fromRow) * words + (fromCol >> 5);
+    reached[from] = frontier[from] = 1u << (fromCol & 31);
+    size_t target = static_cast<size_t>(toRow) * words + (toCol >> 5);
+    uint32_t targetBit = 1u << (toCol & 31);
+    for (int steps = 0;; ++steps) {
+        if (reached[target] & targetBit)
+            return steps;
+        uint32_t grew = 0;
+        for (int row = 0; row < rows; ++row) {
+            for (int w = 0; w < words; ++w) {
+                size_t i = static_cast<size_t>(row) * words + w;
+                uint32_t f = frontier[i];
+                uint32_t spread = f << 1 | f >> 1;
+                if (w > 0)
+                    spread |= frontier[i - 1] >> 31;
+                if (w + 1 < words)
+                    spread |= frontier[i + 1] << 31;
+                if (row > 0)
+                    spread |= frontier[i - words];
+                if (row + 1 < rows)
+                    spread |= frontier[i + words];
+                uint32_t open = ~bits.words[i] & (w + 1 == words ? lastMask : ~0u);
+                next[i] = spread & open & ~reached[i];
+                grew |= next[i];
+            }
+        }
+        if (!grew)
+            return PATH_UNREACHABLE;
+        for (size_t i = 0; i < count; ++i)
+            reached[i] |= next[i];
+        std::swap(frontier, next);
+    }
+}
+
+#endif //~ FIXED_MAZE_HPP
@@ -0,0 +1,90 @@
+// Preprocessor Directives
+#include <memory_stats.hpp>
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+#pragma once
+
+// System Headers
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bytes each thread's arena starts with
+const size_t DEFAULT_FRAME_ARENA_BYTES = 1 << 20;
+
+// The main block starts on a page, so any alignment up to this is honoured
+// inside it; stricter requests get a heap block of their own
+const size_t FRAME_ARENA_ALIGNMENT = 4096;
+
+// Frees the main block the way it was allocated
+struct FrameArenaBlockFree {
+    void operator()(unsigned char* block) const;
+};
+
+// Bump allocator for data that dies with the frame: allocation is a pointer
+// bump and nothing is freed individually; resetFrameArena() drops it all at
+// once. An allocation that does not fit goes to a separate heap block, and
+// the next reset grows the main block to the peak, so a frame that
+// overflowed once will not do so again.
+struct FrameArena {
+    std::unique_ptr<unsigned char[], FrameArenaBlockFree> memory;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t peak = 0;               // bytes requested since the last reset, overflow included
+    std::vector<void*> overflow;   // heap blocks, freed on reset
+};
+
+// Position to rewind to, for scratch space released before the frame ends
+struct ArenaMark {
+    size_t used = 0;
+    size_t overflowBlocks = 0;
+};
+
+void initFrameArena(FrameArena& arena, size_t capacity = DEFAULT_FRAME_ARENA_BYTES);
+
+void* arenaAllocate(FrameArena& arena, size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+// Call at a frame boundary of the owning thread; everything allocated since
+// the last reset becomes invalid
+void resetFrameArena(FrameArena& arena);
+
+ArenaMark arenaMark(const FrameArena& arena);
+void arenaRewind(FrameArena& arena, const ArenaMark& mark);
+
+void deleteFrameArena(FrameArena& arena);
+
+// The calling thread's arena, created on first use
+FrameArena& threadFrameArena();
+
+// Standard allocator over an arena, for containers of per-frame data.
+// Deallocation is a no-op; the memory comes back with the reset.
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+    FrameArena* arena;
+
+    explicit ArenaAllocator(FrameArena& arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arenaAllocate(*arena, n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+// An empty FrameVector on `arena` (the calling thread's by default)
+template <typename T>
+FrameVector<T> makeFrameVector(FrameArena& arena = threadFrameArena()) {
+    return FrameVector<T>(ArenaAllocator<T>(arena));
+}
+
+#endif //~ FRAME_ARENA_HPP
@@ -0,0 +1,95 @@
+// Preprocessor Directives
+#ifndef FRAME_CAPTURE_HPP
+#define FRAME_CAPTURE_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Continuous capture of the finished frames to a file, without the render
+// thread waiting on the GPU or the disk: each frame is read into the next
+// pixel buffer of a ring, behind a fence. A few frames later the buffer is
+// mapped and handed to a writer thread, which encodes it straight out of the
+// mapping and appends it to the file. A frame whose ring slot is still busy
+// is dropped (and counted) instead of stalling.
+const int CAPTURE_RING_SLOTS = 4;
+
+enum CaptureEncoding : uint32_t {
+    CAPTURE_RAW,   // width * height pixels
+    CAPTURE_DELTA, // runs against the previous frame in the file, see below
+};
+
+// The file is a sequence of frames, each this header (little-endian, 32
+// bytes) followed by `bytes` of payload. Pixels are RGBA8, bottom row first
+// as GL reads them. A CAPTURE_DELTA payload is a list of runs of uint32:
+// unchanged pixels to keep, a count n, then n new pixels.
+struct CaptureFrameHeader {
+    char magic[4] = {'L', 'B', 'Y', 'F'};
+    uint32_t encoding = CAPTURE_RAW;
+    uint32_t width = 0, height = 0;
+    uint64_t frame = 0; // offered frames, so dropped ones leave gaps
+    uint64_t bytes = 0;
+};
+
+enum CaptureSlotState : int {
+    CAPTURE_SLOT_FREE,
+    CAPTURE_SLOT_READING, // readback queued, fence pending
+    CAPTURE_SLOT_MAPPED,  // the writer thread reads the mapping
+    CAPTURE_SLOT_WRITTEN, // the writer is done; unmap on the GL thread
+};
+
+struct CaptureSlot {
+    GLuint buffer = 0; // GL_PIXEL_PACK_BUFFER
+    GLsync fence = nullptr;
+    const uint8_t* pixels = nullptr; // while mapped
+    int width = 0, height = 0;
+    uint64_t frame = 0;
+    std::atomic<int> state{CAPTURE_SLOT_FREE};
+};
+
+struct FrameCapture {
+    bool active = false;
+    bool compress = true;       // CAPTURE_DELTA between key frames
+    int keyframeInterval = 60;  // every this many written frames is raw
+
+    // GL thread
+    CaptureSlot slots[CAPTURE_RING_SLOTS];
+    GLsizeiptr slotBytes = 0;
+    int next = 0; // the oldest slot, and the next to read into
+    uint64_t offered = 0, dropped = 0;
+    double readbackMs = 0.0; // time spent in captureFrame
+
+    // writer thread
+    std::string path;
+    std::FILE* file = nullptr;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::vector<uint32_t> previous, encoded;
+    std::atomic<uint64_t> written{0}, bytesWritten{0};
+};
+
+// Opens the file and starts the writer; GL objects are created by the first
+// captureFrame. False when the file cannot be opened.
+bool startFrameCapture(FrameCapture& capture, const std::string& path, bool compress = true);
+
+// Queue a readback of `framebuffer` (0 = the back buffer, before the swap)
+// and pass on the frames whose readback finished. Call once per frame on the
+// thread that owns the GL context.
+void captureFrame(FrameCapture& capture, GLuint framebuffer, int width, int height);
+
+// Writes out every frame still in flight, then releases everything; needs the
+// GL context current
+void stopFrameCapture(FrameCapture& capture);
+
+#endif //~ FRAME_CAPTURE_HPP
@@ -0,0 +1,57 @@
+// Preprocessor Directives
+#ifndef GPU_CULLING_HPP
+#define GPU_CULLING_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <hiz.hpp>
+#include <impostors.hpp>
+#include <maze_mesh.hpp>
+#include <shader.hpp>
+
+const int CULL_STATS_SLOTS = 3;
+
+// GL 4.3 GPU-driven path: chunk bounds live in an SSBO, a compute shader culls
+// them and writes one indirect command per chunk (plus the far-chunk impostor
+// list), and the whole maze is submitted with a single
+// glMultiDrawElementsIndirect.
+struct GpuCuller {
+    ShaderProgram program;
+    GLuint chunkBuffer = 0;   // ChunkInfo[] (std430)
+    GLuint commandBuffer = 0; // DrawElementsIndirectCommand[]
+    GLsizei chunkCount = 0;
+    int nonEmptyChunks = 0;
+
+    // rejection counters written by the shader, read back a few frames late
+    GLuint statsBuffers[CULL_STATS_SLOTS] = {};
+    GLsync statsFences[CULL_STATS_SLOTS] = {};
+    int statsWrite = 0, statsRead = 0;
+};
+
+// Compute shaders, SSBOs and multi-draw indirect are all core in 4.3
+bool gpuCullingSupported();
+
+bool initGpuCuller(GpuCuller& culler, const MazeMesh& mesh);
+
+// Re-upload chunk bounds after the mesh was rebuilt
+void updateGpuCullerChunks(GpuCuller& culler, const MazeMesh& mesh);
+
+// Cull every chunk on the GPU: frustum, Hi-Z when `hiz` is valid, then the
+// LOD split. With `impostors` the far chunks are appended to its instance
+// list and indirect command for drawChunkImpostorsIndirect.
+void dispatchGpuCulling(GpuCuller& culler, const Frustum& frustum, const HiZPyramid* hiz, const LodSettings& lod,
+                        const glm::vec3& cameraPosition, ChunkImpostors* impostors);
+
+// Draw the full-detail chunks chosen by the last dispatch with one
+// glMultiDrawElementsIndirect; the caller binds the drawing program
+void drawGpuCulledChunks(GpuCuller& culler, const MazeMesh& mesh);
+
+// Counters of an earlier dispatch, if one became available (no stall)
+void readGpuCullStats(GpuCuller& culler, CullStats& stats);
+
+void deleteGpuCuller(GpuCuller& culler);
+
+#endif //~ GPU_CULLING_HPP
@@ -0,0 +1,27 @@
+// Preprocessor Directives
+#ifndef HASH_HPP
+#define HASH_HPP
+#pragma once
+
+// System Headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+// FNV-1a; good enough for cache keys, not for anything adversarial
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline uint64_t hashBytes(const std::string& data, uint64_t hash = FNV_OFFSET_BASIS) {
+    return hashBytes(data.data(), data.size(), hash);
+}
+
+#endif //~ HASH_HPP
@@ -0,0 +1,38 @@
+// Preprocessor Directives
+#ifndef HEADLESS_HPP
+#define HEADLESS_HPP
+#pragma once
+
+// System Headers
+#include <cstdint>
+#include <string>
+
+#include <renderer.hpp>
+
+// A regression run without a visible window: a fixed-seed maze, a fixed
+// camera path through it, per-frame timings and, optionally, a comparison of
+// every frame against reference images. Walls are drawn by the GL renderer
+// in an offscreen context (EGL surfaceless or OSMesa, so Mesa's software
+// rasterizer works on machines without a GPU) or by the CPU raycaster.
+struct HeadlessSettings {
+    int frames = 0;
+    int width = 1920, height = 1080;
+    uint32_t seed = 1; // of the maze
+    int mazeSize = 19;
+    int agentCount = 1000;
+    bool osmesa = false; // GL context through OSMesa instead of EGL
+
+    std::string outputDirectory;    // frame_NNNN.png per frame when set
+    std::string referenceDirectory; // compare against its frame_NNNN.png when set
+    int pixelTolerance = 8;         // per channel, for rasterizer differences
+    float maxDifferentPixels = 0.001f; // fraction of the frame beyond the tolerance
+    std::string timingsFile;        // CSV: frame,ms
+    float maxAverageMs = 0.0f;      // frame-time regression limit; 0 = none
+};
+
+// Renders settings.frames frames (see above). Returns the process exit code:
+// non-zero when a context could not be created, an image failed to write or
+// differed from its reference, or frames were slower than allowed.
+int runHeadless(const HeadlessSettings& settings, const RenderSettings& renderSettings, int jobWorkers);
+
+#endif //~ HEADLESS_HPP
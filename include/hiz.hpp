@@ -0,0 +1,61 @@
+// Preprocessor Directives
+#ifndef HIZ_HPP
+#define HIZ_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <culling.hpp>
+#include <render_target.hpp>
+#include <shader.hpp>
+
+// Async copy of one coarse pyramid level for CPU-side occlusion tests
+struct HiZReadback {
+    GLuint pbo = 0;
+    GLsync fence = nullptr;
+    int width = 0, height = 0;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+};
+
+const int HIZ_READBACK_SLOTS = 3;
+
+// Hierarchical-Z pyramid built from the previous frame's depth buffer. Each
+// level stores the farthest depth of the 2x2 (3x3 at odd edges) texels below
+// it, so one or four fetches bound the depth behind any screen rectangle.
+struct HiZPyramid {
+    GLuint texture = 0; // GL_R32F, full mip chain
+    GLuint fbo = 0;
+    GLuint emptyVao = 0;
+    int width = 0, height = 0, levels = 0;
+    glm::mat4 viewProjection = glm::mat4(1.0f); // matrix the depth was rendered with
+    bool valid = false;
+
+    ShaderProgram copyProgram;
+    ShaderProgram downsampleProgram;
+
+    // GL 3.3 path: a level no wider than HIZ_READBACK_WIDTH is read back
+    // through a ring of PBOs, a frame or two behind the GPU
+    int readbackLevel = 0;
+    int readbackWrite = 0, readbackRead = 0;
+    HiZReadback readbacks[HIZ_READBACK_SLOTS];
+};
+
+const int HIZ_READBACK_WIDTH = 160;
+
+bool initHiZ(HiZPyramid& hiz);
+
+// Rebuild the pyramid from `scene`'s depth attachment, which was rendered
+// with `viewProjection`. Leaves the scene framebuffer unbound.
+void buildHiZ(HiZPyramid& hiz, const RenderTarget& scene, const glm::mat4& viewProjection);
+
+// Queue an asynchronous copy of the readback level (no stall)
+void requestHiZReadback(HiZPyramid& hiz);
+
+// Move the newest completed readback into `occlusion`, if any finished
+void pollHiZReadback(HiZPyramid& hiz, OcclusionBuffer& occlusion);
+
+void deleteHiZ(HiZPyramid& hiz);
+
+#endif //~ HIZ_HPP
@@ -0,0 +1,13 @@
+// Preprocessor Directives
+#ifndef IMAGE_WRITE_HPP
+#define IMAGE_WRITE_HPP
+#pragma once
+
+// System Headers
+#include <string>
+
+// Write `width` x `height` RGBA8 pixels, top row first (or bottom row first
+// with `bottomUp`, as glReadPixels returns them), to a PNG file
+bool writePng(const std::string& path, int width, int height, const void* rgba, bool bottomUp = false);
+
+#endif //~ IMAGE_WRITE_HPP
@@ -0,0 +1,46 @@
+// Preprocessor Directives
+#ifndef IMPOSTORS_HPP
+#define IMPOSTORS_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include <culling.hpp>
+#include <maze.hpp>
+#include <maze_mesh.hpp>
+#include <shader.hpp>
+
+// Far chunks drawn as their bounding box with the bit grid ray-marched inside
+// (shaders/impostor.*): one instanced draw for all of them, 36 vertices each,
+// and no per-wall geometry.
+struct ChunkImpostors {
+    ShaderProgram program;
+    GLuint vao = 0;
+    GLuint instanceBuffer = 0; // one GLuint chunk index per impostor
+    GLuint indirectBuffer = 0; // DrawArraysIndirectCommand, written by cull_chunks.comp
+    GLsizei capacity = 0;
+};
+
+const GLuint IMPOSTOR_VERTICES = 36;
+
+bool initChunkImpostors(ChunkImpostors& impostors, const MazeMesh& mesh);
+
+// GL 3.3 path: draw the chunks listed by cullMazeChunks
+void drawChunkImpostors(ChunkImpostors& impostors, const MazeMesh& mesh, const std::vector<GLuint>& chunks,
+                        GLuint bitsTexture, const MazeBits& bits);
+
+// GL 4.3 path: instance list and count were produced on the GPU
+void drawChunkImpostorsIndirect(ChunkImpostors& impostors, const MazeMesh& mesh, GLuint bitsTexture,
+                                const MazeBits& bits);
+
+// Fog and LOD fade uniforms from shaders/lod.glsl. Without `fade` the
+// full-detail side never fades out (for paths that have no impostors).
+void setLodUniforms(GLuint program, const LodSettings& lod, const glm::vec3& cameraPosition, bool fade);
+
+void deleteChunkImpostors(ChunkImpostors& impostors);
+
+#endif //~ IMPOSTORS_HPP
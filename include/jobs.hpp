@@ -0,0 +1,105 @@
+// Preprocessor Directives
+#ifndef JOBS_HPP
+#define JOBS_HPP
+#pragma once
+
+// System Headers
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A unit of work. A job counts as finished once its function and all of its
+// children have run; its continuations are queued at that point.
+struct Job {
+    std::function<void()> function;
+    std::shared_ptr<Job> parent;
+    std::atomic<int> unfinished{1}; // itself + unfinished children
+
+    std::mutex continuationMutex;
+    std::vector<std::shared_ptr<Job>> continuations;
+    bool finished = false; // guarded by continuationMutex
+};
+using JobHandle = std::shared_ptr<Job>;
+
+// Owner pushes and pops at the back, thieves take from the front, so an idle
+// worker steals the oldest (usually largest) piece of work. A ring that only
+// ever grows, so a queue that reached its working size no longer allocates.
+struct JobQueue {
+    std::mutex mutex;
+    std::vector<JobHandle> ring;
+    size_t head = 0, size = 0;
+};
+
+// Per-queue counters; readable while the system runs
+struct JobCounters {
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> idleMicroseconds{0};
+};
+
+// Queue 0 is shared by every thread that is not a worker (main, render);
+// queues 1..workers belong to the worker threads.
+struct JobSystem {
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<JobQueue>> queues;
+    std::vector<std::unique_ptr<JobCounters>> counters;
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<int> queuedJobs{0};
+    std::atomic<bool> stopping{false};
+};
+
+struct JobSystemStats {
+    int threads = 0;
+    uint64_t executed = 0;
+    uint64_t steals = 0;
+    double idleSeconds = 0.0; // summed over the workers
+};
+
+// Half-open cell range [rowBegin, rowEnd) x [colBegin, colEnd)
+struct GridRange {
+    int rowBegin = 0, rowEnd = 0;
+    int colBegin = 0, colEnd = 0;
+};
+
+// workerCount 0 = one worker per hardware thread, minus the calling thread
+void initJobSystem(JobSystem& jobs, int workerCount = 0);
+
+// `parent` (optional) is not finished until this job is. Job records are
+// recycled, so creating jobs at a steady rate does not touch the heap (as
+// long as `function` fits std::function's inline storage).
+JobHandle createJob(std::function<void()> function, const JobHandle& parent = nullptr);
+
+// Queue `next` once `job` has finished (immediately if it already has).
+// `next` must not be passed to runJob as well.
+void addContinuation(JobSystem& jobs, const JobHandle& job, const JobHandle& next);
+
+void runJob(JobSystem& jobs, const JobHandle& job);
+
+// Runs other queued jobs until `job` has finished, so waiting never idles a
+// thread (and nested waits inside jobs cannot deadlock)
+void waitForJob(JobSystem& jobs, const JobHandle& job);
+
+bool jobFinished(const JobHandle& job);
+
+// Split `range` into tiles of at most grain x grain cells and run `function`
+// on each tile in parallel; returns when all tiles are done
+void parallelFor(JobSystem& jobs, const GridRange& range, int grain,
+                 const std::function<void(const GridRange&)>& function);
+
+// One-dimensional variant over [begin, end) in blocks of `grain`
+void parallelFor(JobSystem& jobs, int begin, int end, int grain, const std::function<void(int, int)>& function);
+
+JobSystemStats readJobSystemStats(const JobSystem& jobs);
+void printJobSystemStats(const JobSystem& jobs);
+
+// Waits for the workers to drain their queues and joins them
+void deleteJobSystem(JobSystem& jobs);
+
+#endif //~ JOBS_HPP
@@ -0,0 +1,78 @@
+// Preprocessor Directives
+#ifndef LIGHTS_HPP
+#define LIGHTS_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <jobs.hpp>
+#include <maze.hpp>
+
+// Fragments never loop over more lights than this, however many reach a cell
+const int MAX_LIGHTS_PER_CELL = 32;
+
+struct PointLight {
+    glm::vec3 position;
+    float radius;
+    glm::vec3 color;
+    float intensity;
+};
+
+// Lights binned per maze cell: a light is listed for a cell when its radius
+// reaches the cell and a straight line from the light's cell to it crosses
+// no wall, so light never leaks through into the next corridor.
+struct LightGrid {
+    int rows = 0, cols = 0;
+    std::vector<uint32_t> cells;   // (first, count) into `indices` per cell
+    std::vector<uint32_t> indices; // light indices
+    int maxPerCell = 0;
+    int reach = 0;             // cells between a light's cell and the farthest it can light
+    size_t unusedIndices = 0;  // left behind by rebinLightsAround
+};
+
+// GPU copy of the lights and their grid, read by shaders/lighting.glsl
+struct LightBuffers {
+    GLuint lightBuffer = 0, lightTexture = 0; // 2 RGBA32F texels per light
+    GLuint indexBuffer = 0, indexTexture = 0; // R32UI light indices
+    GLuint cellTexture = 0;                   // RG32UI (first, count) per cell
+    size_t indexCapacity = 0;                 // indices the index buffer has room for
+    int lightCount = 0;
+    int rows = 0, cols = 0;
+};
+
+// Mount up to `count` torches on corridor walls, at most one per open cell;
+// the same seed gives the same torches
+void placeTorches(const MazeBits& bits, int count, uint32_t seed, std::vector<PointLight>& lights);
+
+// Bin `lights` into the cells of `bits`; rows are binned in parallel on
+// `jobs` when given
+void binLights(const MazeBits& bits, const std::vector<PointLight>& lights, LightGrid& grid,
+               JobSystem* jobs = nullptr);
+
+// After the wall at (row, col) changed: re-bin just the cells whose lists it
+// can change, those within grid.reach of it (a line of sight through the
+// cell ends no farther away). Their new lists are appended to grid.indices;
+// the old ones stay behind, counted in unusedIndices, until the next full
+// binLights. Returns the re-binned cells.
+CellRect rebinLightsAround(const MazeBits& bits, const std::vector<PointLight>& lights, LightGrid& grid, int row,
+                           int col);
+
+// Uploads everything, leaving room in the index buffer for re-binned lists
+void uploadLights(LightBuffers& buffers, const std::vector<PointLight>& lights, const LightGrid& grid);
+
+// Upload the cells of `rect` and the indices appended from `firstIndex` on;
+// a full upload when the index buffer has no room left for them
+void updateLightCells(LightBuffers& buffers, const std::vector<PointLight>& lights, const LightGrid& grid,
+                      const CellRect& rect, size_t firstIndex);
+
+// Bind to units firstUnit..firstUnit + 2 and set the lighting uniforms
+void bindLights(GLuint program, const LightBuffers& buffers, int firstUnit, float time);
+
+void deleteLights(LightBuffers& buffers);
+
+#endif //~ LIGHTS_HPP
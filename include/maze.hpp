@@ -0,0 +1,51 @@
+// Preprocessor Directives
+#ifndef MAZE_HPP
+#define MAZE_HPP
+#pragma once
+
+// System Headers
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Fill `maze` with walls (1) and carve corridors (0) by recursive backtracking
+void generateMaze(std::vector<std::vector<int>>& maze, int rows, int cols);
+
+// The same maze every time for the same seed and size
+void generateMaze(std::vector<std::vector<int>>& maze, int rows, int cols, uint32_t seed);
+
+// One bit per cell (1 = wall), rows padded to whole 32-bit words. The word
+// size matches a GL_R32UI texel so the grid can be uploaded as-is.
+struct MazeBits {
+    int rows = 0, cols = 0;
+    int wordsPerRow = 0;
+    std::vector<uint32_t> words;
+
+    bool isWall(int row, int col) const {
+        return (words[row * wordsPerRow + (col >> 5)] >> (col & 31)) & 1u;
+    }
+    void setWall(int row, int col, bool wall) {
+        uint32_t& word = words[row * wordsPerRow + (col >> 5)];
+        word = wall ? word | (1u << (col & 31)) : word & ~(1u << (col & 31));
+    }
+};
+
+void packMaze(const std::vector<std::vector<int>>& maze, MazeBits& bits);
+
+// Cells [rowBegin, rowEnd) x [colBegin, colEnd)
+struct CellRect {
+    int rowBegin = 0, rowEnd = 0;
+    int colBegin = 0, colEnd = 0;
+
+    bool empty() const { return rowBegin >= rowEnd || colBegin >= colEnd; }
+};
+
+// World-space position of a cell's centre; the maze is centred on the origin.
+// Signed arithmetic on purpose: `j - maze[0].size() / 2` wraps for the left
+// and top halves of the grid.
+inline glm::vec3 mazeCellPosition(int row, int col, int rows, int cols, float y = 0.0f) {
+    return glm::vec3(static_cast<float>(col - cols / 2), y, static_cast<float>(row - rows / 2));
+}
+
+#endif //~ MAZE_HPP
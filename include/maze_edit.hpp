@@ -0,0 +1,44 @@
+// Preprocessor Directives
+#ifndef MAZE_EDIT_HPP
+#define MAZE_EDIT_HPP
+#pragma once
+
+// System Headers
+#include <mutex>
+#include <vector>
+
+#include <maze.hpp>
+
+// Walls put up or knocked down at runtime (doors, destructible walls, level
+// editing). The simulation applies an edit to its own state right away and
+// queues it for the renderer, which updates only what the cell touches: the
+// bit texture texel, the chunks meshed from it, and the light lists around it.
+struct MazeEdit {
+    int row = 0, col = 0;
+    bool wall = false;
+};
+
+// Edits on their way from the simulation to the renderer; any thread may
+// queue, the renderer takes them once per frame
+struct MazeEditQueue {
+    std::mutex mutex;
+    std::vector<MazeEdit> edits;
+};
+
+void queueMazeEdit(MazeEditQueue& queue, const MazeEdit& edit);
+
+// Swap the queued edits into `edits`; both vectors keep their capacity, so
+// taking edits every frame does not allocate
+void takeMazeEdits(MazeEditQueue& queue, std::vector<MazeEdit>& edits);
+
+// Set the cell in both the grid and its bits. False (and nothing changed)
+// when the cell is outside the grid or already that way.
+bool applyMazeEdit(std::vector<std::vector<int>>& maze, MazeBits& bits, const MazeEdit& edit);
+
+// Chunks whose mesh reads cell (row, col) of a rows x cols maze. A wall's
+// faces and their ambient occlusion look one cell around (see
+// meshMazeChunk), so a cell on a chunk border touches up to four chunks.
+// Appended to `chunks` unless already listed.
+void chunksTouchingCell(int rows, int cols, int row, int col, std::vector<int>& chunks);
+
+#endif //~ MAZE_EDIT_HPP
@@ -0,0 +1,119 @@
+// Preprocessor Directives
+#ifndef MAZE_MESH_HPP
+#define MAZE_MESH_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <culling.hpp>
+
+// Walls are merged into square chunks of CHUNK_SIZE x CHUNK_SIZE cells so that
+// culling and drawing work per chunk instead of per wall.
+const int CHUNK_SIZE = 8;
+
+// Vertical extent of every wall
+const float WALL_BOTTOM = -1.4f;
+const float WALL_TOP = 4.5f;
+
+// Mesh vertices are position + baked ambient occlusion (attribute 1)
+const int MESH_VERTEX_FLOATS = 4;
+
+enum ChunkState : uint8_t {
+    CHUNK_UNMESHED, // nothing known yet
+    CHUNK_EMPTY,    // meshed, no walls; needs no slot
+    CHUNK_RESIDENT, // walls in its slot of the buffers
+    CHUNK_EVICTED,  // has walls, but gave its slot up (see evictMazeChunk)
+};
+
+struct MazeChunk {
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    GLuint firstIndex; // offset into the shared element buffer, in indices
+    GLuint indexCount; // 0 unless resident
+    GLint baseVertex;
+    int slot;          // -1 unless resident
+    ChunkState state;
+};
+
+// All chunks share one VAO/VBO/EBO; chunk indices are local to the chunk and
+// offset with baseVertex, which is what glMultiDrawElementsIndirect expects.
+// A chunk with walls holds a fixed slot sized for a chunk full of walls, so
+// it can be re-meshed and re-uploaded without moving any other chunk. By
+// default there is a slot for every chunk; with fewer (a mesh memory budget)
+// far chunks give theirs up and are only drawn as impostors.
+struct MazeMesh {
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    int rows = 0, cols = 0;
+    int chunksX = 0, chunksZ = 0;
+    GLsizei slotVertices = 0, slotIndices = 0;
+    int slotCount = 0;
+    std::vector<int> freeSlots;
+    int nonEmptyChunks = 0; // resident chunks
+    std::vector<MazeChunk> chunks; // row-major, chunksX per row
+};
+
+// CPU-side geometry of one chunk, indices local to the chunk
+struct ChunkGeometry {
+    std::vector<float> vertices; // MESH_VERTEX_FLOATS per vertex
+    std::vector<unsigned int> indices;
+    glm::vec3 boundsMin = glm::vec3(1e30f);
+    glm::vec3 boundsMax = glm::vec3(-1e30f);
+};
+
+// Allocate the buffers for a rows x cols maze with `slotCount` chunk slots
+// (0 = one per chunk); every chunk starts out unmeshed
+void initMazeMesh(MazeMesh& mesh, int rows, int cols, int slotCount = 0);
+void deleteMazeMesh(MazeMesh& mesh);
+
+// GPU bytes of one chunk slot (vertices and indices)
+size_t mazeMeshSlotBytes();
+
+// Give chunk `index` a slot, unless it already has one; false when every
+// slot is taken
+bool acquireChunkSlot(MazeMesh& mesh, int index);
+
+// Release a resident chunk's slot. It keeps its bounds and still counts as
+// having walls, for impostors and culling stats.
+void evictMazeChunk(MazeMesh& mesh, int index);
+
+// Build the geometry of chunk (chunkX, chunkZ), including per-vertex ambient
+// occlusion from the neighbouring cells. Pure CPU work that only reads
+// `maze`, so it can run on any thread.
+void meshMazeChunk(const std::vector<std::vector<int>>& maze, int chunkX, int chunkZ, ChunkGeometry& geometry);
+
+// Record that chunk `index` now holds `geometry` (whose data must already be
+// in the chunk's slot of the buffers; geometry with walls needs a slot)
+void setMazeChunkGeometry(MazeMesh& mesh, int index, const ChunkGeometry& geometry);
+
+// Conservative bounds of a chunk's cells, whatever is meshed there. Depends
+// only on the grid size, so other threads may use it while chunks stream in.
+void mazeChunkFootprint(const MazeMesh& mesh, int index, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+// GL 3.3 path, first stage: frustum cull on the CPU, then split the
+// survivors by distance into full-detail chunks and impostor chunks. A chunk
+// inside the LOD transition band lands in both lists. Only uses chunk
+// footprints, so it can run on the simulation thread; lists may include
+// chunks that have no geometry (yet).
+void cullMazeChunks(const MazeMesh& mesh, const Frustum& frustum, const LodSettings& lod,
+                    const glm::vec3& cameraPosition, std::vector<GLuint>& meshChunks,
+                    std::vector<GLuint>& impostorChunks, CullStats& stats);
+
+// Second stage: drop the listed chunks hidden behind `occlusion` (in place);
+// returns how many were dropped
+int occlusionCullChunks(const MazeMesh& mesh, const OcclusionBuffer& occlusion, std::vector<GLuint>& chunks);
+
+// Drop chunks without geometry (in place); returns how many were dropped
+int dropEmptyChunks(const MazeMesh& mesh, std::vector<GLuint>& chunks);
+
+// Same, but keep evicted chunks, which impostors can still stand in for
+int dropChunksWithoutWalls(const MazeMesh& mesh, std::vector<GLuint>& chunks);
+
+// One draw per listed chunk
+void drawMazeChunkList(const MazeMesh& mesh, const std::vector<GLuint>& chunks);
+
+#endif //~ MAZE_MESH_HPP
@@ -0,0 +1,21 @@
+// Preprocessor Directives
+#ifndef MAZE_TEXTURE_HPP
+#define MAZE_TEXTURE_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+#include <maze.hpp>
+
+// Upload MazeBits as a GL_R32UI texture (one texel per 32 cells of a row),
+// sampled through shaders/maze_bits.glsl
+GLuint createMazeBitsTexture(const MazeBits& bits);
+
+// Re-upload the single texel holding (row, col) after `bits` was edited
+void updateMazeBitsTexel(GLuint texture, const MazeBits& bits, int row, int col);
+
+// Bind to `unit` and set the mazeBits/mazeSize uniforms of `program`
+void bindMazeBitsTexture(GLuint program, GLuint texture, const MazeBits& bits, int unit);
+
+#endif //~ MAZE_TEXTURE_HPP
@@ -0,0 +1,68 @@
+// Preprocessor Directives
+#ifndef MEMORY_STATS_HPP
+#define MEMORY_STATS_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <string>
+
+// What a block of memory is for; every report and budget is per tag
+enum MemoryTag {
+    MEMORY_MAZE,      // the grid, its bit-packed copies and their textures
+    MEMORY_MESHES,    // chunk vertex/index slots and the chunk table
+    MEMORY_STREAMING, // staging ring and meshed chunks waiting for upload
+    MEMORY_PATHS,     // pathfinding state
+    MEMORY_TEXTURES,  // wall texture array
+    MEMORY_LIGHTS,
+    MEMORY_SHADOWS,
+    MEMORY_AGENTS,
+    MEMORY_CULLING,   // GPU culling buffers, impostor lists
+    MEMORY_TARGETS,   // scene render target, Hi-Z pyramid
+    MEMORY_TAG_COUNT
+};
+
+// Lower-case name, as used by --memory-budget and the JSON report
+const char* memoryTagName(MemoryTag tag);
+bool parseMemoryTag(const std::string& name, MemoryTag& tag);
+
+// CPU side: each owner (any object address) reports its current footprint,
+// replacing what it reported before. Only the first report of an owner
+// allocates. Safe to call from any thread.
+void reportCpuMemory(MemoryTag tag, const void* owner, size_t bytes);
+void forgetCpuMemory(const void* owner);
+
+// GPU side: call right after glBufferData / glTexImage* with the size of the
+// whole object (all mip levels), and before deleting it. Untracking name 0
+// does nothing. Must be called on the thread that owns the GL context.
+void trackBufferMemory(MemoryTag tag, GLuint buffer, size_t bytes);
+void trackTextureMemory(MemoryTag tag, GLuint texture, size_t bytes);
+void untrackBufferMemory(GLuint buffer);
+void untrackTextureMemory(GLuint texture);
+
+// Bytes per texel of the sized internal formats this project uses
+size_t texelBytes(GLenum internalFormat);
+
+// CPU + GPU bytes a tag should stay under; 0 (the default) is no budget.
+// Set before initRenderer: the mesh budget sizes the chunk slot pool, and
+// chunks are evicted to keep within it.
+void setMemoryBudget(MemoryTag tag, size_t bytes);
+size_t memoryBudget(MemoryTag tag);
+
+struct MemoryUsage {
+    size_t cpu[MEMORY_TAG_COUNT] = {};
+    size_t gpu[MEMORY_TAG_COUNT] = {};
+    size_t budget[MEMORY_TAG_COUNT] = {};
+    size_t cpuTotal = 0, gpuTotal = 0;
+};
+
+// Totals of everything reported so far; does not allocate
+void readMemoryUsage(MemoryUsage& usage);
+bool memoryOverBudget(const MemoryUsage& usage, MemoryTag tag);
+
+// Write the current usage per tag to `path` as JSON
+bool writeMemoryReport(const std::string& path);
+
+#endif //~ MEMORY_STATS_HPP
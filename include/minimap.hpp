@@ -0,0 +1,45 @@
+// Preprocessor Directives
+#ifndef MINIMAP_HPP
+#define MINIMAP_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <maze.hpp>
+#include <shader.hpp>
+
+// Overhead map drawn with a single fullscreen-triangle draw into a corner
+// viewport. The maze comes from the shared bit texture; the explored mask is
+// a GL_R8 texture that only receives the cells that changed.
+struct Minimap {
+    ShaderProgram program;
+    GLuint exploredTexture = 0;
+    GLuint emptyVao = 0;
+    std::vector<uint8_t> explored; // CPU mirror, 255 = seen
+    int rows = 0, cols = 0;
+    int lastRow = -1, lastCol = -1; // player cell of the last update
+    int sizePixels = 220;
+};
+
+// Cells within this many cells of the player count as explored
+const int MINIMAP_REVEAL_RADIUS = 2;
+
+bool initMinimap(Minimap& minimap, const MazeBits& bits);
+
+// Reveal around the player; does nothing until the player changes cell,
+// then uploads just the revealed rectangle
+void updateMinimapExplored(Minimap& minimap, const glm::vec3& playerPosition);
+
+// Draw into the top-right corner of the currently bound framebuffer
+void drawMinimap(const Minimap& minimap, GLuint bitsTexture, const MazeBits& bits,
+                 const glm::vec3& playerPosition, const glm::vec3& playerFront,
+                 int framebufferWidth, int framebufferHeight);
+
+void deleteMinimap(Minimap& minimap);
+
+#endif //~ MINIMAP_HPP
@@ -0,0 +1,46 @@
+// Preprocessor Directives
+#ifndef NET_HPP
+#define NET_HPP
+#pragma once
+
+// System Headers
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Non-blocking UDP over BSD sockets (Winsock on Windows), just what
+// replication needs: datagrams to and from IPv4 addresses
+struct NetAddress {
+    uint32_t ip = 0; // host byte order
+    uint16_t port = 0;
+
+    bool operator==(const NetAddress& other) const { return ip == other.ip && port == other.port; }
+};
+
+struct UdpSocket {
+    intptr_t handle = -1;
+};
+
+// 127.0.0.1:port
+NetAddress loopbackAddress(uint16_t port);
+
+// "host:port" with a dotted IPv4 host or "localhost"; false when malformed
+bool parseNetAddress(const std::string& text, NetAddress& address);
+
+// Bind to `port` on every interface (0 = any free port) and switch to
+// non-blocking; false, with an ERROR line, when that fails
+bool openUdpSocket(UdpSocket& socket, uint16_t port = 0);
+
+// The port the socket is bound to
+uint16_t udpSocketPort(const UdpSocket& socket);
+
+// False when the datagram was not sent (a full send buffer drops it, as the
+// network would)
+bool sendPacket(UdpSocket& socket, const NetAddress& to, const void* data, size_t bytes);
+
+// Bytes of the next waiting datagram, 0 when none is waiting, -1 on an error
+int receivePacket(UdpSocket& socket, NetAddress& from, void* buffer, size_t capacity);
+
+void closeUdpSocket(UdpSocket& socket);
+
+#endif //~ NET_HPP
@@ -0,0 +1,87 @@
+// Preprocessor Directives
+#ifndef PATHFINDING_HPP
+#define PATHFINDING_HPP
+#pragma once
+
+// System Headers
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <maze.hpp>
+
+// Shortest paths between open maze cells: 4-connected, one unit per step,
+// walls have no edges in or out. Two searches over MazeBits:
+//
+// - findPath, plain A* from scratch, for one-off queries and as the baseline
+//   of --bench replanning;
+// - PathPlanner, D* Lite (Koenig & Likhachev): it searches backwards from
+//   the goal and keeps its costs between calls. When walls change, only the
+//   costs the changed cells actually affect are repaired, and the start may
+//   move along the path without invalidating anything.
+const int PATH_UNREACHABLE = std::numeric_limits<int>::max() / 4;
+
+struct PathKey {
+    int k1 = 0, k2 = 0;
+};
+
+struct PathQueueEntry {
+    PathKey key;
+    int cell = 0;
+};
+
+struct PathPlanner {
+    int rows = 0, cols = 0;
+    int start = 0, goal = 0; // cell = row * cols + col
+    int last = 0;            // start when the heuristic offset was last raised
+    int km = 0;              // heuristic offset, grows as the start moves
+
+    std::vector<int> g, rhs;     // cost to the goal, and its one-step lookahead
+    std::vector<PathKey> keys;   // key of the live queue entry per cell
+    std::vector<uint8_t> queued;
+    // binary min-heap; entries whose key is not the cell's live one are stale
+    // and skipped, and purged in place when the heap is full
+    std::vector<PathQueueEntry> queue;
+
+    uint64_t expanded = 0; // cells taken off the queue, over the planner's lifetime
+};
+
+// Plan from (startRow, startCol) to (goalRow, goalCol) in a grid the size of
+// `bits`. The arrays keep their capacity, so re-targeting a planner on the
+// same maze does not allocate. Reported under MEMORY_PATHS, owned by the
+// planner's address.
+void initPathPlanner(PathPlanner& planner, const MazeBits& bits, int startRow, int startCol, int goalRow,
+                     int goalCol);
+
+// The agent moved; takes effect with the next planPath
+void movePlannerStart(PathPlanner& planner, int row, int col);
+
+// The wall at (row, col) of `bits` changed (already set in `bits`); call once
+// per changed cell, then planPath
+void plannerCellChanged(PathPlanner& planner, const MazeBits& bits, int row, int col);
+
+// Bring the costs up to date for the current start. False when the goal
+// cannot be reached from it.
+bool planPath(PathPlanner& planner, const MazeBits& bits);
+
+// After planPath: the neighbour of the start to step into. False when there
+// is none (at the goal, or unreachable).
+bool nextPathStep(const PathPlanner& planner, const MazeBits& bits, int& row, int& col);
+
+// After planPath: steps from the start to the goal, or PATH_UNREACHABLE
+inline int plannedLength(const PathPlanner& planner) { return planner.g[planner.start]; }
+
+// Scratch of findPath, reused across calls; `seen` is stamped per search so
+// nothing is cleared in between
+struct PathSearch {
+    std::vector<int> g;
+    std::vector<uint32_t> seen;
+    uint32_t stamp = 0;
+    std::vector<PathQueueEntry> open;
+    uint64_t expanded = 0;
+};
+
+// A* from scratch: steps from start to goal, or PATH_UNREACHABLE
+int findPath(const MazeBits& bits, int startRow, int startCol, int goalRow, int goalCol, PathSearch& search);
+
+#endif //~ PATHFINDING_HPP
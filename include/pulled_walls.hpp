@@ -0,0 +1,27 @@
+// Preprocessor Directives
+#ifndef PULLED_WALLS_HPP
+#define PULLED_WALLS_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+#include <maze.hpp>
+#include <shader.hpp>
+
+// Vertex-pulling wall renderer: the only GPU-side maze data is the bit grid
+// (see createMazeBitsTexture); shaders/pulled_walls.vert builds the wall
+// faces from gl_InstanceID/gl_VertexID.
+struct PulledWalls {
+    ShaderProgram program;
+    GLuint emptyVao = 0;
+};
+
+bool initPulledWalls(PulledWalls& walls);
+
+// Expects view/projection/ourColor to be set on walls.program by the caller
+void drawPulledWalls(const PulledWalls& walls, GLuint bitsTexture, const MazeBits& bits);
+
+void deletePulledWalls(PulledWalls& walls);
+
+#endif //~ PULLED_WALLS_HPP
@@ -0,0 +1,60 @@
+// Preprocessor Directives
+#ifndef RAYCAST_HPP
+#define RAYCAST_HPP
+#pragma once
+
+// System Headers
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <jobs.hpp>
+#include <maze.hpp>
+
+// Rays walk the grid cell by cell (DDA), so a ray costs one bit test per cell
+// it crosses, whatever its length. Cells outside the grid are open, like
+// isWall() in shaders/maze_bits.glsl: a ray that leaves the grid hits nothing.
+
+// Which kind of cell boundary a ray crossed into the wall it hit
+enum RaySide : uint8_t {
+    RAY_SIDE_X, // a boundary between columns: the face looks along x
+    RAY_SIDE_Z, // between rows: the face looks along z
+};
+
+// Rays on the xz plane in world space, as structure of arrays. Fill the
+// inputs (or use setRay / setRaySegment), cast, read the results.
+struct RayBatch {
+    int count = 0;
+
+    // inputs
+    std::vector<float> originX, originZ;
+    std::vector<float> dirX, dirZ;    // unit length
+    std::vector<float> maxDistance;
+
+    // results
+    std::vector<float> hitDistance;    // along the ray to the wall face; maxDistance when nothing was hit
+    std::vector<int32_t> hitRow, hitCol; // -1 when nothing was hit
+    std::vector<uint8_t> hitSide;      // RaySide
+};
+
+// Room for `count` rays; never shrinks the arrays
+void resizeRayBatch(RayBatch& batch, int count);
+
+void setRay(RayBatch& batch, int index, const glm::vec2& origin, const glm::vec2& direction, float maxDistance);
+
+// The ray from `from` towards `to`, stopping there: nothing is hit exactly
+// when the line of sight is clear
+void setRaySegment(RayBatch& batch, int index, const glm::vec2& from, const glm::vec2& to);
+
+// Cast rays [begin, end) of the batch on the calling thread. A ray that
+// starts inside a wall hits it at distance 0.
+void castRays(const MazeBits& bits, RayBatch& batch, int begin, int end);
+
+// Cast the whole batch, in parallel blocks when `jobs` is given
+void castRays(const MazeBits& bits, RayBatch& batch, JobSystem* jobs = nullptr);
+
+// Single query: no wall between `from` and `to` (both world xz)
+bool lineOfSight(const MazeBits& bits, const glm::vec2& from, const glm::vec2& to);
+
+#endif //~ RAYCAST_HPP
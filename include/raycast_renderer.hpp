@@ -0,0 +1,58 @@
+// Preprocessor Directives
+#ifndef RAYCAST_RENDERER_HPP
+#define RAYCAST_RENDERER_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include <culling.hpp>
+#include <jobs.hpp>
+#include <maze.hpp>
+#include <raycast.hpp>
+
+// Software fallback for machines without a usable GPU: the maze drawn
+// Wolfenstein-style, one grid ray per screen column (see raycast.hpp), into
+// a CPU framebuffer. Walls are flat coloured with the GL path's colour, side
+// shading and fog; agents and shadows are not drawn. Drawing needs no GL
+// context; presenting the frame in a window does.
+struct RaycastRenderer {
+    JobSystem* jobs = nullptr; // rows are filled in parallel when set
+    MazeBits bits;
+    LodSettings lod; // fog
+    glm::vec3 wallColor = glm::vec3(0.0f, 0.75f, 1.0f);
+
+    int width = 0, height = 0;
+    std::vector<uint32_t> pixels; // RGBA8, top row first
+
+    // per column
+    RayBatch rays;
+    std::vector<int32_t> wallTop, wallBottom; // wall rows [top, bottom)
+    std::vector<uint32_t> columnColor;
+
+    // presentation: the pixels go to a texture, blitted to the window
+    GLuint texture = 0, fbo = 0;
+    int textureWidth = 0, textureHeight = 0;
+};
+
+void initRaycastRenderer(RaycastRenderer& renderer, const MazeBits& bits, const LodSettings& lod,
+                         JobSystem* jobs);
+
+// Draw one width x height frame from the camera the GL path would use
+// (`projection` gives the field of view; pitch shears the view vertically).
+// Allocates only when the size changes.
+void drawRaycastFrame(RaycastRenderer& renderer, const glm::vec3& cameraPosition, const glm::vec3& cameraFront,
+                      const glm::mat4& projection, int width, int height);
+
+// Copy the last frame to the default framebuffer (or to `destination`);
+// needs a GL context
+void presentRaycastFrame(RaycastRenderer& renderer, int screenWidth, int screenHeight, GLuint destination = 0);
+
+// Releases the GL objects too, when there are any
+void deleteRaycastRenderer(RaycastRenderer& renderer);
+
+#endif //~ RAYCAST_RENDERER_HPP
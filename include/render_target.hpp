@@ -0,0 +1,29 @@
+// Preprocessor Directives
+#ifndef RENDER_TARGET_HPP
+#define RENDER_TARGET_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+// Offscreen colour + depth framebuffer. The scene is drawn here rather than
+// into the default framebuffer so later passes can sample its depth.
+struct RenderTarget {
+    GLuint fbo = 0;
+    GLuint colorTexture = 0; // GL_RGBA8
+    GLuint depthTexture = 0; // GL_DEPTH_COMPONENT32F
+    int width = 0, height = 0;
+};
+
+// (Re)allocate the attachments; a no-op when the size did not change
+bool resizeRenderTarget(RenderTarget& target, int width, int height);
+
+void bindRenderTarget(const RenderTarget& target);
+
+// Copy the colour attachment to the default framebuffer (or to
+// `destination`), which is left bound
+void blitRenderTargetToScreen(const RenderTarget& target, int screenWidth, int screenHeight, GLuint destination = 0);
+
+void deleteRenderTarget(RenderTarget& target);
+
+#endif //~ RENDER_TARGET_HPP
@@ -0,0 +1,149 @@
+// Preprocessor Directives
+#ifndef RENDERER_HPP
+#define RENDERER_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <agents.hpp>
+#include <chunk_streaming.hpp>
+#include <culling.hpp>
+#include <gpu_culling.hpp>
+#include <hiz.hpp>
+#include <impostors.hpp>
+#include <jobs.hpp>
+#include <lights.hpp>
+#include <maze.hpp>
+#include <maze_edit.hpp>
+#include <maze_mesh.hpp>
+#include <minimap.hpp>
+#include <pulled_walls.hpp>
+#include <raycast_renderer.hpp>
+#include <render_target.hpp>
+#include <shader.hpp>
+#include <shadows.hpp>
+#include <textures.hpp>
+
+// Everything the renderer needs to draw one frame, produced once per
+// simulation tick. Snapshots travel through a TripleBuffer, so the renderer
+// never touches simulation state directly.
+struct RenderSnapshot {
+    uint64_t tick = 0;
+    float time = 0.0f;
+    glm::vec3 cameraPos = glm::vec3(0.0f);
+    glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    int framebufferWidth = 0, framebufferHeight = 0;
+
+    // CPU culling path: frustum + LOD split already done by the simulation
+    // side (see cullMazeChunks); the renderer only adds the Hi-Z test
+    std::vector<GLuint> meshChunks;
+    std::vector<GLuint> impostorChunks;
+    CullStats cullStats;
+
+    // per agent (x, z, heading, tint), see writeAgentInstances
+    std::vector<glm::vec4> agents;
+};
+
+// What the renderer reports back for the window title
+struct RenderStats {
+    float fps = 0.0f;
+    CullStats cull;
+};
+
+struct RenderSettings {
+    bool forceCpuCulling = false;     // skip the GL 4.3 path
+    bool useOcclusionCulling = true;  // Hi-Z against the previous frame
+    bool useVertexPulling = false;    // walls built from the bit grid
+    bool showMinimap = true;
+    GLsizeiptr uploadBudget = DEFAULT_UPLOAD_BUDGET; // chunk bytes per frame
+    int torches = 64;                 // 0 = unlit walls
+    bool sunShadows = true;           // cached shadow map for the walls
+    bool cpuRaycast = false;          // software walls only, see raycast_renderer.hpp
+    LodSettings lod;
+};
+
+// All GL state of the maze renderer. Must only be used on the thread that
+// owns the GL context.
+struct Renderer {
+    RenderSettings settings;
+    bool useGpuCulling = false;
+    JobSystem* jobs = nullptr; // CPU-side helpers, e.g. meshing
+
+    ShaderProgram mazeShader;
+    MazeMesh mazeMesh;
+    ChunkStreamer chunkStreamer; // meshes chunks off-thread, uploads on budget
+    std::shared_ptr<MazeGrid> grid; // what the chunks are meshed from
+    MazeBits mazeBits;
+    GLuint mazeBitsTexture = 0;
+    TextureArrayLoad wallTextureLoad; // decoded on the job system
+    TextureArray wallTextures;        // empty until that load finished
+    std::vector<PointLight> lights;
+    LightGrid lightGrid;
+    LightBuffers lightBuffers;
+    ShadowMaps shadows;
+    AgentInstances agentInstances; // vao 0 when agents cannot be drawn
+
+    PulledWalls pulledWalls;
+    ChunkImpostors impostors;
+    GpuCuller gpuCuller;
+    RenderTarget sceneTarget;
+    HiZPyramid hiz;
+    OcclusionBuffer occlusionBuffer; // CPU path's copy of a coarse Hi-Z level
+    Minimap minimap;
+    RaycastRenderer raycaster; // only with settings.cpuRaycast
+
+    // wall edits from the simulation, taken at the start of every frame
+    MazeEditQueue* edits = nullptr;
+    std::vector<MazeEdit> takenEdits;
+    std::vector<int> editedChunks;
+
+    // CPU path: the snapshot's lists after the occlusion test
+    std::vector<GLuint> visibleChunks, impostorChunks;
+    CullStats cullStats;
+
+    // where finished frames go: 0 is the window, headless runs draw into
+    // a framebuffer of their own
+    GLuint outputFramebuffer = 0;
+
+    float lastShaderCheck = 0.0f;
+    float lastStatsUpdate = 0.0f;
+    int framesSinceStats = 0;
+};
+
+// Settings may be downgraded to what the context supports; check
+// renderer.settings afterwards. `jobs` may be null (everything serial).
+bool initRenderer(Renderer& renderer, const std::vector<std::vector<int>>& maze, const RenderSettings& settings,
+                  JobSystem* jobs);
+
+// True when the simulation side should fill RenderSnapshot's chunk lists
+bool rendererWantsChunkLists(const Renderer& renderer);
+
+// Draw one frame into the default framebuffer (no swap). Returns false when
+// there was nothing to draw into (minimized window).
+bool renderFrame(Renderer& renderer, const RenderSnapshot& snapshot);
+
+// True once everything that streams in over the first frames (chunk meshes,
+// wall textures, cached shadow tiles) has arrived, so frames no longer
+// change for the same camera
+bool rendererSettled(Renderer& renderer);
+
+// Bring the GPU copies of the maze up to date with `edits` (already applied
+// on the simulation side): bit texture texels, light lists around the cells,
+// and new meshes for just the chunks touching them, which stream in like
+// any other. renderFrame does this with the edits queued in renderer.edits.
+void applyMazeEdits(Renderer& renderer, const std::vector<MazeEdit>& edits);
+
+// Returns true about twice a second, when `stats` was refreshed
+bool updateRenderStats(Renderer& renderer, float time, RenderStats& stats);
+
+void deleteRenderer(Renderer& renderer);
+
+#endif //~ RENDERER_HPP
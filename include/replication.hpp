@@ -0,0 +1,199 @@
+// Preprocessor Directives
+#ifndef REPLICATION_HPP
+#define REPLICATION_HPP
+#pragma once
+
+// System Headers
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <maze.hpp>
+#include <net.hpp>
+
+// Several players in one labyrinth. The server owns the simulation: every
+// player's position, view angles and jump/crouch state, moved by the inputs
+// the clients send. Each tick it sends every client a snapshot of the players
+// near it, over UDP:
+//
+// - quantized: positions in 1/64 cell, angles in 16 bits;
+// - delta compressed against the newest snapshot the client acknowledged
+//   (its inputs carry the ack), so players that did not change cost nothing
+//   and the rest only their changed fields. Without a usable ack (the first
+//   snapshots, a long outage) a full snapshot goes out instead;
+// - filtered by interest: the maze is cut into square regions, and a client
+//   only hears about players in its own region and the eight around it.
+//
+// The server keeps, per client, the snapshots exactly as that client will
+// decode them, so a baseline on either side is the same bytes.
+const int REPLICATION_TICK_RATE = 60;        // server ticks (and snapshots) per second
+const int SNAPSHOT_HISTORY = 32;             // snapshots kept for baselines, on both sides
+const size_t MAX_PACKET_BYTES = 1200;        // under any real MTU; snapshots never fragment
+const int INTEREST_REGION_CELLS = 8;         // region side, in maze cells
+const double CLIENT_TIMEOUT_SECONDS = 5.0;   // no input for this long and the player leaves
+
+enum PlayerButton : uint8_t {
+    BUTTON_FORWARD = 1,
+    BUTTON_BACK = 2,
+    BUTTON_LEFT = 4,
+    BUTTON_RIGHT = 8,
+    BUTTON_JUMP = 16,
+    BUTTON_CROUCH = 32,
+};
+
+enum PlayerFlag : uint8_t {
+    PLAYER_JUMPING = 1,
+    PLAYER_CROUCHING = 2,
+};
+
+// The server's player: what cameraPos, yaw/pitch (cameraFront) and the jump
+// and crouch statics of processInput are for the local camera
+struct PlayerState {
+    glm::vec3 position = glm::vec3(0.0f);
+    float yaw = -90.0f, pitch = 0.0f; // degrees, as mouse_callback keeps them
+    uint8_t flags = 0;
+    float jumpTime = 0.0f;
+};
+
+// What a client sends every tick: the keys held and where it looks
+struct PlayerInput {
+    uint32_t sequence = 0;
+    float yaw = -90.0f, pitch = 0.0f;
+    uint8_t buttons = 0;
+};
+
+// The direction a player looks in, as mouse_callback computes cameraFront
+glm::vec3 playerFront(float yaw, float pitch);
+
+// Advance a player by dt the way processInput moves the camera: walking at
+// 3 cells a second on the ground plane, stopped by walls, a 0.5 s jump and a
+// crouch half a cell down
+void stepPlayer(PlayerState& player, const PlayerInput& input, const MazeBits& walls, float dt);
+
+// A player on the wire. Positions count 1/64 cells from the maze's corner,
+// height 1/100 units; yaw is 1/65536 of a turn, pitch 1/32767 of 90 degrees.
+struct NetPlayer {
+    uint16_t id = 0;
+    uint16_t x = 0, z = 0;
+    int16_t y = 0;
+    uint16_t yaw = 0;
+    int16_t pitch = 0;
+    uint8_t flags = 0;
+};
+
+bool operator==(const NetPlayer& a, const NetPlayer& b);
+
+NetPlayer quantizePlayer(const PlayerState& player, uint16_t id, int rows, int cols);
+
+// Back to world space; jumpTime is not replicated and stays 0
+PlayerState dequantizePlayer(const NetPlayer& player, int rows, int cols);
+
+// The players one client knows about after one tick, sorted by id
+struct Snapshot {
+    uint32_t sequence = 0; // the server tick; 0 = empty slot
+    std::vector<NetPlayer> players;
+};
+
+// Counters of one side; times are totals in milliseconds
+struct ReplicationStats {
+    uint64_t ticks = 0;
+    uint64_t packetsSent = 0, bytesSent = 0;
+    uint64_t packetsReceived = 0, bytesReceived = 0;
+    uint64_t fullSnapshots = 0, deltaSnapshots = 0;
+    uint64_t playersVisible = 0; // summed over snapshots
+    uint64_t playersWritten = 0; // of those, the ones that changed and went out
+    uint64_t playersDeferred = 0; // changed but did not fit; they go out next time
+    uint64_t undecodable = 0;     // snapshots whose baseline the client no longer had
+    double simulateMs = 0.0, replicateMs = 0.0;
+};
+
+struct ServerClient {
+    NetAddress address;
+    uint16_t player = 0;
+    PlayerInput input; // newest; held until a newer one arrives
+    uint32_t acked = 0; // newest snapshot the client decoded; 0 = none
+    double lastHeard = 0.0;
+    std::array<Snapshot, SNAPSHOT_HISTORY> history; // by sequence % SNAPSHOT_HISTORY
+};
+
+struct ReplicationServer {
+    UdpSocket socket;
+    uint32_t seed = 0; // of the maze, for the clients to generate the same one
+    MazeBits walls;
+    uint32_t tick = 0;
+    double time = 0.0;
+    float simulatedLoss = 0.0f; // drop this fraction of outgoing packets, to exercise recovery
+    std::mt19937 rng;
+
+    std::vector<PlayerState> players; // by id
+    std::vector<uint8_t> active;      // players[id] is someone's
+    std::vector<ServerClient> clients;
+
+    // interest: active players bucketed by region, rebuilt every tick
+    int regionRows = 0, regionCols = 0;
+    std::vector<uint32_t> regionStart; // regionRows * regionCols + 1 offsets into regionPlayers
+    std::vector<uint16_t> regionPlayers, playerRegion;
+
+    // scratch, reused every tick
+    std::vector<uint16_t> visible, removed;
+    std::vector<uint8_t> packet;
+
+    ReplicationStats stats;
+};
+
+// Generate the maze (generateMaze with `seed`, so clients can do the same)
+// and listen on `port` (0 = any free one). False, with an ERROR line, when
+// the socket cannot be opened.
+bool startReplicationServer(ReplicationServer& server, uint32_t seed, int mazeSize, uint16_t port);
+
+// One fixed step of dt: take in the inputs that arrived, drop clients gone
+// quiet, move every player and send every client its snapshot
+void replicationServerTick(ReplicationServer& server, float dt);
+
+void stopReplicationServer(ReplicationServer& server);
+
+// A dedicated server without a window: ticks at REPLICATION_TICK_RATE and
+// prints its counters every few seconds, until the process is stopped.
+// Only returns (non-zero) when the server cannot start.
+int runReplicationServer(uint16_t port, uint32_t seed, int mazeSize);
+
+struct ReplicationClient {
+    UdpSocket socket;
+    NetAddress server;
+    float simulatedLoss = 0.0f; // as the server's
+    std::mt19937 rng;
+
+    // the level, from the first full snapshot
+    bool joined = false;
+    uint32_t mazeSeed = 0;
+    int mazeRows = 0, mazeCols = 0;
+    uint16_t player = 0;
+
+    uint32_t inputSequence = 0;
+    uint32_t latest = 0; // newest decoded snapshot; 0 = none yet
+    std::array<Snapshot, SNAPSHOT_HISTORY> received; // by sequence % SNAPSHOT_HISTORY
+    std::vector<uint16_t> removed; // scratch
+    std::vector<uint8_t> packet;
+
+    ReplicationStats stats;
+};
+
+// Open a socket for talking to `server`; nothing is sent until the first input
+bool connectReplicationClient(ReplicationClient& client, const NetAddress& server);
+
+// Send this tick's input, acknowledging the newest snapshot
+void sendPlayerInput(ReplicationClient& client, PlayerInput input);
+
+// Decode every snapshot that arrived; true when a newer one did
+bool receiveSnapshots(ReplicationClient& client);
+
+// The newest decoded snapshot (empty before the first)
+const Snapshot& latestSnapshot(const ReplicationClient& client);
+
+// Tell the server we left, and close the socket
+void disconnectReplicationClient(ReplicationClient& client);
+
+#endif //~ REPLICATION_HPP
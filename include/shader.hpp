@@ -0,0 +1,49 @@
+// Preprocessor Directives
+#ifndef SHADER_HPP
+#define SHADER_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// One stage of a program, loaded from a file under shaders/
+struct ShaderStage {
+    GLenum type;
+    std::string path;
+};
+
+// A linked program together with everything needed to rebuild it.
+// `dependencies` lists every file that went into the program (stage files and
+// everything they #include), so hot reload can watch all of them.
+struct ShaderProgram {
+    GLuint id = 0;
+    std::vector<ShaderStage> stages;
+    std::vector<std::string> dependencies;
+    std::vector<std::filesystem::path> watchedPaths; // dependencies, converted once for polling
+    std::vector<std::filesystem::file_time_type> timestamps;
+    bool loadedFromCache = false;
+};
+
+// Absolute path of a file in the project's shaders/ directory
+std::string shaderPath(const std::string& name);
+
+// Read a shader file and expand `#include "file"` directives (resolved relative
+// to the including file). Every file read is appended to `dependencies`.
+bool loadShaderSource(const std::string& path, std::string& source, std::vector<std::string>& dependencies);
+
+// Build `program` from its stages. A program binary cached on disk is used when
+// the expanded sources and the driver match; otherwise the stages are compiled,
+// linked and the result is written back to the cache.
+bool buildShaderProgram(ShaderProgram& program);
+
+// Rebuild the program when any of its dependencies changed on disk. On failure
+// the previous program is kept so a typo does not kill the running session.
+bool reloadShaderProgramIfChanged(ShaderProgram& program);
+
+void deleteShaderProgram(ShaderProgram& program);
+
+#endif //~ SHADER_HPP
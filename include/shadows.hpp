@@ -0,0 +1,67 @@
+// Preprocessor Directives
+#ifndef SHADOWS_HPP
+#define SHADOWS_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <vector>
+
+#include <maze_mesh.hpp>
+#include <shader.hpp>
+
+// The sun's shadow map is split into SHADOW_TILES x SHADOW_TILES tiles of
+// SHADOW_TILE_SIZE texels that are re-rendered independently
+const int SHADOW_TILES = 8;
+const int SHADOW_TILE_SIZE = 256;
+const int SHADOW_MAP_SIZE = SHADOW_TILES * SHADOW_TILE_SIZE;
+
+// Dirty tiles re-rendered per frame by default
+const int DEFAULT_SHADOW_TILE_BUDGET = 4;
+
+// Called with the light matrix while the dynamic shadow map is bound; draws
+// whatever moves. The static depth program is in use; casters with their own
+// vertex layout bind their own program.
+using ShadowCasterCallback = std::function<void(GLuint program, const glm::mat4& lightMatrix)>;
+
+// Directional shadows for the static walls, rendered once and cached. A
+// chunk that changes only invalidates the tiles its walls project onto, and
+// those are re-rendered on a per-frame budget. Dynamic casters are drawn
+// every frame into a copy of the cached map.
+struct ShadowMaps {
+    glm::vec3 sunDirection = glm::vec3(0.0f); // towards the ground
+    glm::mat4 lightMatrix = glm::mat4(1.0f);  // world -> shadow clip space
+
+    GLuint staticMap = 0, staticFbo = 0;   // GL_DEPTH_COMPONENT32F, cached
+    GLuint dynamicMap = 0, dynamicFbo = 0; // static copy + moving casters
+    bool hasDynamic = false;               // sample dynamicMap this frame
+    ShaderProgram depthProgram;
+
+    std::vector<glm::vec4> chunkRects; // per chunk: light-space (min.xy, max.xy) in tiles
+    std::vector<bool> dirtyTiles;
+    int dirtyCount = 0;
+    int tileBudget = DEFAULT_SHADOW_TILE_BUDGET;
+    int tilesRendered = 0; // last frame
+};
+
+// `sunDirection` points from the sun towards the maze
+bool initShadowMaps(ShadowMaps& shadows, const MazeMesh& mesh, const glm::vec3& sunDirection,
+                    int tileBudget = DEFAULT_SHADOW_TILE_BUDGET);
+
+// Mark every tile chunk `index` casts onto for re-rendering
+void invalidateShadowChunk(ShadowMaps& shadows, int index);
+
+// Re-render dirty tiles within the budget, then composite `dynamicCasters`
+// (may be empty) over the cached map. Leaves the shadow framebuffers unbound
+// and the viewport changed.
+void updateShadowMaps(ShadowMaps& shadows, const MazeMesh& mesh, const ShadowCasterCallback& dynamicCasters);
+
+// Bind the map to `unit` and set the sun uniforms of shaders/shadows.glsl
+void bindShadowMaps(GLuint program, const ShadowMaps& shadows, int unit);
+
+void deleteShadowMaps(ShadowMaps& shadows);
+
+#endif //~ SHADOWS_HPP
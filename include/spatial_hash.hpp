@@ -0,0 +1,51 @@
+// Preprocessor Directives
+#ifndef SPATIAL_HASH_HPP
+#define SPATIAL_HASH_HPP
+#pragma once
+
+// System Headers
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Broad phase for moving entities on the xz plane. Cells are cellSize wide
+// and, at the default size of 1, line up with the maze cells (centred on
+// integer coordinates, like mazeCellPosition()). Cells are hashed into a fixed
+// number of buckets, so entities may also be outside the maze.
+//
+// Rebuilt from scratch each tick with a counting sort into arrays sized at
+// init. Rebuilding never allocates while the count stays within capacity.
+// Entities are stored in bucket order next to their cell, which keeps a query
+// to a few contiguous reads per cell.
+struct SpatialHash {
+    float cellSize = 1.0f;
+    int capacity = 0;
+    int count = 0;
+    uint32_t bucketMask = 0;
+
+    std::vector<uint32_t> bucketStart; // bucket count + 1 offsets into the sorted arrays
+    std::vector<uint32_t> entityBucket; // scratch, per input entity
+
+    // sorted by bucket
+    std::vector<uint32_t> ids;
+    std::vector<float> x, z;
+    std::vector<int32_t> cellX, cellZ; // tells hash collisions apart
+};
+
+// Room for `capacity` entities; a larger count later grows the arrays once
+void initSpatialHash(SpatialHash& hash, int capacity, float cellSize = 1.0f);
+
+// Replace the contents with entities 0..count-1 at (x[i], z[i])
+void buildSpatialHash(SpatialHash& hash, const float* x, const float* z, int count);
+
+// Append the ids of entities within `radius` of `centre` (xz) to `results`;
+// returns how many were appended
+int querySpatialHashRadius(const SpatialHash& hash, const glm::vec2& centre, float radius,
+                           std::vector<uint32_t>& results);
+
+// Same for the axis-aligned box [boxMin, boxMax], bounds inclusive
+int querySpatialHashBox(const SpatialHash& hash, const glm::vec2& boxMin, const glm::vec2& boxMax,
+                        std::vector<uint32_t>& results);
+
+#endif //~ SPATIAL_HASH_HPP
@@ -0,0 +1,71 @@
+// Preprocessor Directives
+#ifndef TEXTURES_HPP
+#define TEXTURES_HPP
+#pragma once
+
+// System Headers
+#include <glad/glad.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <jobs.hpp>
+
+// Every layer of a texture array is resampled to this size
+const int TEXTURE_LAYER_SIZE = 128;
+
+// Decoded RGBA8 image with its full mip chain, level 0 = size x size
+struct TextureImage {
+    int size = 0;
+    std::vector<std::vector<uint8_t>> levels;
+};
+
+// Images being decoded (or read from the cache) on the job system, one job
+// per layer under `done` (null when loaded synchronously)
+struct TextureArrayLoad {
+    JobSystem* jobs = nullptr;
+    std::vector<std::string> paths;
+    std::vector<TextureImage> images;
+    JobHandle done;
+    std::atomic<int> fromCache{0};
+};
+
+struct TextureArray {
+    GLuint id = 0;
+    int layers = 0;
+    int size = 0;
+};
+
+// Absolute path of a file in the project's textures/ directory
+std::string texturePath(const std::string& name);
+
+// Decode `path`, resample it to size x size and build the mip chain. A
+// binary cache keyed on the file's size and mtime skips all of that on
+// later launches. Unreadable files become a checkerboard so layer indices
+// stay stable. Pure CPU work, safe on any thread.
+void loadTextureImage(const std::string& path, int size, TextureImage& image, bool& fromCache);
+
+// Start loading one layer per path; with null `jobs` everything is loaded
+// right away on the calling thread
+void startTextureArrayLoad(TextureArrayLoad& load, JobSystem* jobs, const std::vector<std::string>& paths,
+                           int size = TEXTURE_LAYER_SIZE);
+
+bool textureArrayLoadFinished(const TextureArrayLoad& load);
+
+// Create the GL_TEXTURE_2D_ARRAY from a finished load and free the CPU copy.
+// GL thread only.
+void uploadTextureArray(TextureArrayLoad& load, TextureArray& array);
+
+// Waits for a load that is still running and drops its images
+void cancelTextureArrayLoad(TextureArrayLoad& load);
+
+// Set `sampler` to `unit` and `layersUniform` to the layer count (0 while
+// the array is not uploaded yet, which shaders treat as "untextured")
+void bindTextureArray(GLuint program, const TextureArray& array, const char* sampler, const char* layersUniform,
+                      int unit);
+
+void deleteTextureArray(TextureArray& array);
+
+#endif //~ TEXTURES_HPP
@@ -0,0 +1,48 @@
+// Preprocessor Directives
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+#pragma once
+
+#include <atomic>
+
+// Lock-free single-producer/single-consumer triple buffer. The writer fills
+// writeBuffer() and publishes it; the reader picks up the newest published
+// value with update() and reads it from readBuffer() for as long as it likes.
+// Neither side ever waits for the other, and intermediate values the reader
+// was too slow to see are simply dropped.
+//
+// Slots are recycled, so a slot handed to the writer holds stale data and must
+// be overwritten completely (containers inside keep their capacity).
+template <typename T>
+class TripleBuffer {
+public:
+    // writer side
+    T& writeBuffer() { return slots[backIndex]; }
+
+    void publish() {
+        int previous = middle.exchange(backIndex | freshBit, std::memory_order_acq_rel);
+        backIndex = previous & indexMask;
+    }
+
+    // reader side; returns true when a newer value was taken
+    bool update() {
+        if (!(middle.load(std::memory_order_acquire) & freshBit))
+            return false;
+        int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & indexMask;
+        return true;
+    }
+
+    const T& readBuffer() const { return slots[frontIndex]; }
+
+private:
+    static const int freshBit = 4;
+    static const int indexMask = 3;
+
+    T slots[3];
+    int backIndex = 0;             // owned by the writer
+    std::atomic<int> middle{1};    // shared, plus freshBit when unread
+    int frontIndex = 2;            // owned by the reader
+};
+
+#endif //~ TRIPLE_BUFFER_HPP
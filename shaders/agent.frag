@@ -0,0 +1,15 @@
+#version 330 core
+in vec3 WorldPos;
+flat in float Tint;
+out vec4 FragColor;
+
+#include "lod.glsl"
+#include "lighting.glsl"
+
+void main()
+{
+    vec3 normal = normalize(cross(dFdx(WorldPos), dFdy(WorldPos)));
+    // a muted palette so agents stand out from the walls without glowing
+    vec3 albedo = mix(vec3(0.75, 0.3, 0.2), vec3(0.3, 0.6, 0.35), Tint);
+    FragColor = vec4(applyFog(applyLighting(albedo, WorldPos, normal), WorldPos), 1.0);
+}
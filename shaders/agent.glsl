@@ -0,0 +1,22 @@
+// One agent = one box, built from gl_VertexID: four sides and the top, two
+// triangles each. The instance is (x, z, heading, tint).
+layout (location = 0) in vec4 aInstance;
+
+const vec3 agentSize = vec3(0.3, 1.2, 0.45); // width, height, depth (forward)
+const float agentFloor = -1.4;              // WALL_BOTTOM
+
+const vec3 agentFaceOrigin[5] = vec3[5](vec3(-0.5, 0, -0.5), vec3(-0.5, 0, 0.5), vec3(-0.5, 0, -0.5),
+                                        vec3(0.5, 0, -0.5), vec3(-0.5, 1, -0.5));
+const vec3 agentFaceU[5] = vec3[5](vec3(1, 0, 0), vec3(1, 0, 0), vec3(0, 0, 1), vec3(0, 0, 1), vec3(1, 0, 0));
+const vec3 agentFaceV[5] = vec3[5](vec3(0, 1, 0), vec3(0, 1, 0), vec3(0, 1, 0), vec3(0, 1, 0), vec3(0, 0, 1));
+const vec2 agentQuadCorner[6] = vec2[6](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(1, 1), vec2(0, 1), vec2(0, 0));
+
+vec3 agentVertex()
+{
+    int face = gl_VertexID / 6;
+    vec2 corner = agentQuadCorner[gl_VertexID % 6];
+    vec3 local = (agentFaceOrigin[face] + agentFaceU[face] * corner.x + agentFaceV[face] * corner.y) * agentSize;
+    // local +z is forward; heading turns it towards (sin, cos)
+    float s = sin(aInstance.z), c = cos(aInstance.z);
+    return vec3(aInstance.x + local.x * c + local.z * s, agentFloor + local.y, aInstance.y - local.x * s + local.z * c);
+}
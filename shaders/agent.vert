@@ -0,0 +1,13 @@
+#version 330 core
+out vec3 WorldPos;
+flat out float Tint;
+
+#include "camera.glsl"
+#include "agent.glsl"
+
+void main()
+{
+    WorldPos = agentVertex();
+    Tint = aInstance.w;
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 330 core
+// Agents into the sun's dynamic shadow map
+#include "agent.glsl"
+
+uniform mat4 lightMatrix;
+
+void main()
+{
+    gl_Position = lightMatrix * vec4(agentVertex(), 1.0);
+}
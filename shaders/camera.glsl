@@ -0,0 +1,3 @@
+// Camera matrices shared by every pass that draws in world space.
+uniform mat4 view;
+uniform mat4 projection;
@@ -0,0 +1,11 @@
+#version 330 core
+// Single oversized triangle covering the viewport; draw with 3 vertices and
+// an empty VAO.
+out vec2 TexCoords;
+
+void main()
+{
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoords = position;
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
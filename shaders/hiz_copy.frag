@@ -0,0 +1,10 @@
+#version 330 core
+// Level 0 of the Hi-Z pyramid: a float copy of the scene depth buffer
+out float Depth;
+
+uniform sampler2D sceneDepth;
+
+void main()
+{
+    Depth = texelFetch(sceneDepth, ivec2(gl_FragCoord.xy), 0).r;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+// Builds one Hi-Z level: each texel keeps the farthest depth of the texels it
+// covers in the previous level. The previous level is the texture's base
+// level while this pass runs, so texelFetch uses lod 0. Level 0 itself is
+// produced by the same shader reading the scene depth texture.
+out float Depth;
+
+uniform sampler2D previousLevel;
+uniform ivec2 previousSize;
+
+void main()
+{
+    ivec2 base = ivec2(gl_FragCoord.xy) * 2;
+    ivec2 last = previousSize - 1;
+    float depth = 0.0;
+    // odd sizes: the last texel of a row/column also covers the leftover one
+    ivec2 extent = ivec2(base.x + 2 == last.x ? 2 : 1, base.y + 2 == last.y ? 2 : 1);
+    for (int y = 0; y <= extent.y; ++y) {
+        for (int x = 0; x <= extent.x; ++x) {
+            ivec2 coord = min(base + ivec2(x, y), last);
+            depth = max(depth, texelFetch(previousLevel, coord, 0).r);
+        }
+    }
+    Depth = depth;
+}
@@ -0,0 +1,79 @@
+#version 330 core
+// Heightmap impostor for a far chunk: the bit grid is the heightmap (walls
+// are wallTop high, open cells have no height). March the view ray through
+// the chunk's cells with a 2D DDA from where it enters the proxy box and
+// stop at the first wall cell whose vertical extent it crosses.
+in vec3 WorldPos;
+flat in ivec2 ChunkMin;
+flat in ivec2 ChunkMax;
+out vec4 FragColor;
+
+#include "camera.glsl"
+#include "maze_bits.glsl"
+#include "lod.glsl"
+#include "wall_textures.glsl"
+#include "lighting.glsl"
+
+uniform vec4 ourColor;
+uniform int chunkSize;
+uniform float wallBottom;
+uniform float wallTop;
+
+void main()
+{
+    vec3 dir = normalize(WorldPos - cameraPosition);
+    // grid space: cell c spans [c, c + 1) on each horizontal axis
+    vec2 origin = WorldPos.xz + vec2(mazeSize / 2) + 0.5;
+    vec2 d = dir.xz;
+
+    ivec2 cell = clamp(ivec2(floor(origin)), ChunkMin, ChunkMax - 1);
+    ivec2 stepDir = ivec2(sign(d));
+    vec2 invD = 1.0 / max(abs(d), vec2(1e-6));
+    vec2 nextBoundary = vec2(cell) + max(vec2(stepDir), vec2(0.0));
+    vec2 tMax = abs(nextBoundary - origin) * invD;
+
+    // face the ray last crossed; until it steps that is the proxy box face
+    vec3 normal = normalize(cross(dFdx(WorldPos), dFdy(WorldPos)));
+    float tEnter = 0.0;
+    float tHit = -1.0;
+    for (int i = 0; i < 2 * chunkSize + 2; ++i) {
+        float tExit = min(tMax.x, tMax.y);
+        if (isWall(cell)) {
+            float yEnter = WorldPos.y + dir.y * tEnter;
+            float yExit = WorldPos.y + dir.y * tExit;
+            if (yEnter <= wallTop && yEnter >= wallBottom) {
+                tHit = tEnter; // hit the side (or entered through the box face)
+                break;
+            }
+            if (yEnter > wallTop && yExit <= wallTop) {
+                tHit = tEnter + (wallTop - yEnter) / dir.y; // hit the top
+                normal = vec3(0.0, 1.0, 0.0);
+                break;
+            }
+        }
+        if (tMax.x < tMax.y) {
+            cell.x += stepDir.x;
+            tMax.x += invD.x;
+            normal = vec3(-float(stepDir.x), 0.0, 0.0);
+        } else {
+            cell.y += stepDir.y;
+            tMax.y += invD.y;
+            normal = vec3(0.0, 0.0, -float(stepDir.y));
+        }
+        tEnter = tExit;
+        if (any(lessThan(cell, ChunkMin)) || any(greaterThanEqual(cell, ChunkMax)))
+            break;
+    }
+    if (tHit < 0.0)
+        discard;
+
+    vec3 hit = WorldPos + dir * tHit;
+    // the full-detail mesh owns this pixel until the fade passes it
+    if (lodDither() >= lodBlend(hit))
+        discard;
+
+    vec4 clip = projection * view * vec4(hit, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+    vec3 albedo = wallAverage(ivec2(cellCentre(cell)), ourColor.rgb);
+    FragColor = vec4(applyFog(applyLighting(albedo, hit, normal), hit), ourColor.a);
+}
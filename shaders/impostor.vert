@@ -0,0 +1,39 @@
+#version 330 core
+// Far-chunk impostor proxy: the chunk's bounding box, built from gl_VertexID
+// (36 vertices, counter-clockwise from outside) for the chunk named by the
+// per-instance attribute. impostor.frag ray-marches the bit grid inside it.
+layout (location = 0) in uint aChunk;
+
+out vec3 WorldPos;
+flat out ivec2 ChunkMin; // first cell (col, row)
+flat out ivec2 ChunkMax; // one past the last cell
+
+#include "camera.glsl"
+#include "maze_bits.glsl"
+
+uniform int chunkSize;
+uniform int chunksX;
+uniform float wallBottom;
+uniform float wallTop;
+
+const int boxCorners[36] = int[36](0, 4, 6, 0, 6, 2,   // -x
+                                   1, 3, 7, 1, 7, 5,   // +x
+                                   0, 1, 5, 0, 5, 4,   // -y
+                                   2, 6, 7, 2, 7, 3,   // +y
+                                   0, 2, 3, 0, 3, 1,   // -z
+                                   4, 5, 7, 4, 7, 6);  // +z
+
+void main()
+{
+    ivec2 chunk = ivec2(int(aChunk) % chunksX, int(aChunk) / chunksX);
+    ChunkMin = chunk * chunkSize;
+    ChunkMax = min(ChunkMin + chunkSize, mazeSize);
+
+    vec2 low = cellCentre(ChunkMin) - 0.5;
+    vec2 high = cellCentre(ChunkMax - 1) + 0.5;
+    int corner = boxCorners[gl_VertexID];
+    WorldPos = vec3((corner & 1) != 0 ? high.x : low.x,
+                    (corner & 2) != 0 ? wallTop : wallBottom,
+                    (corner & 4) != 0 ? high.y : low.y);
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+}
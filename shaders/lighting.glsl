@@ -0,0 +1,41 @@
+// Point lights binned per maze cell (see include/lights.hpp). A fragment
+// looks up the cell it faces and only evaluates the lights listed there.
+// The sun comes on top of that, wherever its shadow map says it reaches.
+#include "shadows.glsl"
+
+uniform samplerBuffer lightData;     // per light: (position, radius), (colour, -)
+uniform usamplerBuffer lightIndices;
+uniform usampler2D lightCells;       // (first, count) per cell
+uniform ivec2 lightGridSize;         // (cols, rows)
+uniform bool lightingEnabled;
+uniform float time;
+
+const vec3 ambientLight = vec3(0.25, 0.27, 0.32);
+
+// `normal` picks the cell in front of a wall face: side faces are lit from
+// the corridor they face, top faces from the wall's own cell
+vec3 applyLighting(vec3 albedo, vec3 worldPos, vec3 normal)
+{
+    if (!lightingEnabled)
+        return albedo;
+    ivec2 cell = ivec2(floor(worldPos.xz + normal.xz * 0.25 + 0.5)) + lightGridSize / 2;
+    if (any(lessThan(cell, ivec2(0))) || any(greaterThanEqual(cell, lightGridSize)))
+        return albedo * (ambientLight + sunLight(worldPos, normal));
+
+    uvec2 range = texelFetch(lightCells, cell, 0).rg;
+    vec3 light = ambientLight + sunLight(worldPos, normal);
+    for (uint i = 0u; i < range.y; ++i) {
+        int index = int(texelFetch(lightIndices, int(range.x + i)).r);
+        vec4 positionRadius = texelFetch(lightData, 2 * index);
+        vec3 color = texelFetch(lightData, 2 * index + 1).rgb;
+
+        vec3 toLight = positionRadius.xyz - worldPos;
+        float dist = length(toLight);
+        // smooth window so the light reaches exactly zero at its radius
+        float window = clamp(1.0 - pow(dist / positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (1.0 + dist * dist);
+        float flicker = 0.9 + 0.1 * sin(time * 11.0 + float(index) * 1.7) * sin(time * 7.3 + float(index));
+        light += color * flicker * attenuation * max(dot(normal, toLight / max(dist, 1e-4)), 0.0);
+    }
+    return albedo * light;
+}
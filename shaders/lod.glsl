@@ -0,0 +1,27 @@
+// Distance fog and the dithered cross-fade between full-detail chunks and
+// their impostors. Both sides of the fade evaluate lodBlend() per pixel, so
+// each pixel is covered by exactly one of them inside the transition band.
+uniform vec3 cameraPosition;
+uniform vec3 fogColor;
+uniform float fogStart;
+uniform float fogEnd;
+uniform float lodStart;
+uniform float lodEnd;
+
+// 0 = full detail, 1 = impostor (horizontal distance, like the chunk test)
+float lodBlend(vec3 worldPos)
+{
+    return smoothstep(lodStart, lodEnd, distance(worldPos.xz, cameraPosition.xz));
+}
+
+// Interleaved gradient noise: a stable per-pixel threshold in [0, 1)
+float lodDither()
+{
+    return fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+}
+
+vec3 applyFog(vec3 color, vec3 worldPos)
+{
+    float amount = clamp((distance(worldPos, cameraPosition) - fogStart) / (fogEnd - fogStart), 0.0, 1.0);
+    return mix(color, fogColor, amount);
+}
@@ -0,0 +1,22 @@
+#version 330 core
+in vec3 WorldPos;
+in float Occlusion;
+out vec4 FragColor;
+
+#include "lod.glsl"
+#include "wall_textures.glsl"
+#include "lighting.glsl"
+
+uniform vec4 ourColor;
+
+void main()
+{
+    // flat-shaded geometry: the face normal comes from the screen-space
+    // derivatives (taken before any discard, while they are still defined)
+    vec3 normal = normalize(cross(dFdx(WorldPos), dFdy(WorldPos)));
+    // fading out towards the impostor
+    if (lodDither() < lodBlend(WorldPos))
+        discard;
+    vec3 albedo = wallAlbedo(WorldPos, normal, ourColor.rgb) * Occlusion;
+    FragColor = vec4(applyFog(applyLighting(albedo, WorldPos, normal), WorldPos), ourColor.a);
+}
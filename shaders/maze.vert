@@ -0,0 +1,18 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in float aOcclusion; // baked at mesh build time
+
+out vec3 WorldPos;
+out float Occlusion;
+
+#include "camera.glsl"
+
+uniform mat4 model;
+
+void main()
+{
+    vec4 world = model * vec4(aPos, 1.0);
+    WorldPos = world.xyz;
+    Occlusion = aOcclusion;
+    gl_Position = projection * view * world;
+}
@@ -0,0 +1,18 @@
+// The maze as one bit per cell in a GL_R32UI texture: texel (x, row) holds
+// cells [32x, 32x + 31] of that row, lowest bit first.
+uniform usampler2D mazeBits;
+uniform ivec2 mazeSize; // (cols, rows)
+
+bool isWall(ivec2 cell)
+{
+    if (cell.x < 0 || cell.y < 0 || cell.x >= mazeSize.x || cell.y >= mazeSize.y)
+        return false;
+    uint word = texelFetch(mazeBits, ivec2(cell.x >> 5, cell.y), 0).r;
+    return ((word >> uint(cell.x & 31)) & 1u) != 0u;
+}
+
+// Matches mazeCellPosition() in include/maze.hpp
+vec2 cellCentre(ivec2 cell)
+{
+    return vec2(cell - mazeSize / 2);
+}
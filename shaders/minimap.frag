@@ -0,0 +1,41 @@
+#version 330 core
+// Overhead map in one full-viewport pass: every pixel looks up its cell in the
+// maze bit texture and the explored mask, then the player marker is drawn
+// analytically on top. Row 0 of the maze is at the top of the map.
+in vec2 TexCoords;
+out vec4 FragColor;
+
+#include "maze_bits.glsl"
+
+uniform sampler2D explored;  // GL_R8, 1 = seen
+uniform vec2 playerCell;     // continuous (col, row)
+uniform vec2 playerHeading;  // normalized (x, z) facing
+
+const vec3 wallColor = vec3(0.0, 0.45, 0.6);
+const vec3 floorColor = vec3(0.92);
+const vec3 unexploredColor = vec3(0.15);
+const vec3 playerColor = vec3(0.9, 0.1, 0.1);
+
+float segmentDistance(vec2 p, vec2 a, vec2 b)
+{
+    vec2 ab = b - a;
+    float t = clamp(dot(p - a, ab) / dot(ab, ab), 0.0, 1.0);
+    return length(p - a - ab * t);
+}
+
+void main()
+{
+    vec2 position = vec2(TexCoords.x, 1.0 - TexCoords.y) * vec2(mazeSize);
+    ivec2 cell = clamp(ivec2(position), ivec2(0), mazeSize - 1);
+
+    vec3 color = isWall(cell) ? wallColor : floorColor;
+    if (texelFetch(explored, cell, 0).r < 0.5)
+        color = unexploredColor;
+
+    float playerDistance = length(position - playerCell);
+    float heading = segmentDistance(position, playerCell, playerCell + playerHeading * 1.5);
+    if (playerDistance < 0.6 || heading < 0.15)
+        color = playerColor;
+
+    FragColor = vec4(color, 1.0);
+}
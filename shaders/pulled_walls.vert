@@ -0,0 +1,57 @@
+#version 330 core
+// Walls without vertex buffers: one instance per maze cell, 30 vertices per
+// instance (four sides and the top, two triangles each). Everything is
+// derived from gl_InstanceID/gl_VertexID and the maze bit texture; faces of
+// open cells, and sides facing another wall, collapse to a degenerate point.
+
+out vec3 WorldPos;
+out float Occlusion;
+
+#include "camera.glsl"
+#include "maze_bits.glsl"
+
+// Same extents and occlusion levels as the walls in src/maze_mesh.cpp
+const float wallBottom = -1.4;
+const float wallTop = 4.5;
+
+// per face: neighbour direction (xz), corner origin and the two quad edges
+const ivec2 faceNeighbour[5] = ivec2[5](ivec2(0, -1), ivec2(0, 1), ivec2(-1, 0), ivec2(1, 0), ivec2(0, 0));
+const vec3 faceOrigin[5] = vec3[5](vec3(-0.5, wallBottom, -0.5), vec3(-0.5, wallBottom, 0.5),
+                                   vec3(-0.5, wallBottom, -0.5), vec3(0.5, wallBottom, -0.5),
+                                   vec3(-0.5, wallTop, -0.5));
+const vec3 faceU[5] = vec3[5](vec3(1, 0, 0), vec3(1, 0, 0), vec3(0, 0, 1), vec3(0, 0, 1), vec3(1, 0, 0));
+const vec3 faceV[5] = vec3[5](vec3(0, 1, 0), vec3(0, 1, 0), vec3(0, 1, 0), vec3(0, 1, 0), vec3(0, 0, 1));
+const float occlusionCurve[4] = float[4](0.45, 0.65, 0.85, 1.0);
+const vec2 quadCorner[6] = vec2[6](vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(1, 1), vec2(0, 1), vec2(0, 0));
+
+void main()
+{
+    ivec2 cell = ivec2(gl_InstanceID % mazeSize.x, gl_InstanceID / mazeSize.x);
+    int face = gl_VertexID / 6;
+
+    // the top is always visible; a side only when the neighbour is open
+    bool emit = isWall(cell) && (face == 4 || !isWall(cell + faceNeighbour[face]));
+    if (!emit) {
+        WorldPos = vec3(0.0);
+        Occlusion = 1.0;
+        gl_Position = vec4(0.0);
+        return;
+    }
+
+    vec2 corner = quadCorner[gl_VertexID % 6];
+    vec3 local = faceOrigin[face] + faceU[face] * corner.x +
+                 faceV[face] * corner.y * (face == 4 ? 1.0 : wallTop - wallBottom);
+    // a side darkens along an edge where it meets a perpendicular wall (the
+    // cell beside the open neighbour), and towards the floor
+    Occlusion = 1.0;
+    if (face != 4) {
+        ivec2 tangent = ivec2(faceU[face].xz);
+        ivec2 beside = cell + faceNeighbour[face] + (corner.x > 0.5 ? tangent : -tangent);
+        bool meetsWall = isWall(beside);
+        Occlusion = corner.y < 0.5 ? occlusionCurve[meetsWall ? 0 : 2] : occlusionCurve[meetsWall ? 2 : 3];
+    }
+
+    vec2 centre = cellCentre(cell);
+    WorldPos = local + vec3(centre.x, 0.0, centre.y);
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 330 core
+// Static walls into the sun's shadow map
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 lightMatrix;
+
+void main()
+{
+    gl_Position = lightMatrix * vec4(aPos, 1.0);
+}
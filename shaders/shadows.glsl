@@ -0,0 +1,20 @@
+// Directional sun with a cached shadow map (see include/shadows.hpp)
+uniform sampler2DShadow sunShadowMap;
+uniform mat4 sunMatrix;     // world -> shadow clip space
+uniform vec3 sunDirection;  // from the sun towards the maze
+uniform bool sunEnabled;
+
+const vec3 sunColor = vec3(0.55, 0.5, 0.42);
+
+vec3 sunLight(vec3 worldPos, vec3 normal)
+{
+    if (!sunEnabled)
+        return vec3(0.0);
+    float facing = dot(normal, -sunDirection);
+    if (facing <= 0.0)
+        return vec3(0.0);
+    // a small push along the normal on top of the raster bias
+    vec4 clip = sunMatrix * vec4(worldPos + normal * 0.05, 1.0);
+    vec3 coord = clip.xyz / clip.w * 0.5 + 0.5;
+    return sunColor * facing * texture(sunShadowMap, coord);
+}
@@ -0,0 +1,35 @@
+// Wall albedo from the GL_TEXTURE_2D_ARRAY of wall variants. Each wall cell
+// picks a layer by hashing its (integer) world-space centre, so the mesh,
+// vertex-pulled and impostor paths all agree on which variant a wall uses.
+uniform sampler2DArray wallTextures;
+uniform int wallTextureLayers; // 0 until the textures have loaded
+
+int wallLayer(ivec2 cellCentre)
+{
+    uint h = uint(cellCentre.x) * 73856093u ^ uint(cellCentre.y) * 19349663u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return int(h % uint(wallTextureLayers));
+}
+
+// World-space texture mapping for axis-aligned walls, one repeat per cell;
+// `normal` only needs to be roughly right to pick the projection
+vec3 wallAlbedo(vec3 worldPos, vec3 normal, vec3 untextured)
+{
+    if (wallTextureLayers == 0)
+        return untextured;
+    vec3 n = abs(normal);
+    vec2 uv = n.x > 0.5 ? worldPos.zy : (n.z > 0.5 ? worldPos.xy : worldPos.xz);
+    // step half a cell back into the wall to find the cell it belongs to
+    ivec2 cell = ivec2(floor(worldPos.xz - normal.xz * 0.25 + 0.5));
+    return texture(wallTextures, vec3(uv, float(wallLayer(cell)))).rgb;
+}
+
+// Average colour of a wall, for pixels too far away to show any texture
+vec3 wallAverage(ivec2 cellCentre, vec3 untextured)
+{
+    if (wallTextureLayers == 0)
+        return untextured;
+    return textureLod(wallTextures, vec3(0.5, 0.5, float(wallLayer(cellCentre))), 16.0).rgb;
+}
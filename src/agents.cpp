@@ -0,0 +1,332 @@
+#include <agents.hpp>
+#include <memory_stats.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float PI = 3.14159265f;
+
+// agents per job; small enough to spread 10k agents over every core
+const int AGENT_GRAIN = 2048;
+
+// seekers per job when their planners are repaired
+const int SEEKER_GRAIN = 16;
+
+// four sides and the top of a box, two triangles each (see agent.glsl)
+const GLsizei verticesPerAgent = 5 * 6;
+
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+float randomUnit(uint32_t& state) {
+    return (nextRandom(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Inverse of mazeCellPosition() along one axis
+int cellOf(float position, int size) {
+    return static_cast<int>(std::floor(position + 0.5f)) + size / 2;
+}
+
+bool wallAt(const MazeBits& bits, int row, int col) {
+    if (row < 0 || col < 0 || row >= bits.rows || col >= bits.cols)
+        return true;
+    return bits.isWall(row, col);
+}
+
+// True when moving from `from` to `to` crossed (or reached) a cell centre
+bool crossedCentre(float from, float to, float& centre) {
+    float a = std::min(from, to), b = std::max(from, to);
+    centre = std::floor(b);
+    return centre >= a && centre <= b && from != to;
+}
+
+void startWalking(AgentSystem& agents, int i, int dx, int dz) {
+    agents.velX[i] = dx * AGENT_SPEED;
+    agents.velZ[i] = dz * AGENT_SPEED;
+    agents.heading[i] = std::atan2(static_cast<float>(dx), static_cast<float>(dz));
+    agents.state[i] = AGENT_WALKING;
+}
+
+// Point a seeker's planner at a random open cell; false after a few misses
+bool retargetSeeker(AgentSystem& agents, int i, int row, int col) {
+    const MazeBits& walls = agents.walls;
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        int goalRow = nextRandom(agents.rng[i]) % walls.rows;
+        int goalCol = nextRandom(agents.rng[i]) % walls.cols;
+        if (!walls.isWall(goalRow, goalCol)) {
+            initPathPlanner(agents.planners[i], walls, row, col, goalRow, goalCol);
+            return true;
+        }
+    }
+    return false;
+}
+
+// A seeker's next step (dx, dz) along its plan, with a new goal when it
+// arrived or its goal was walled off. False when there is no step; the
+// seeker then wanders for a cell.
+bool plannedStep(AgentSystem& agents, int i, int row, int col, int& dx, int& dz) {
+    const MazeBits& walls = agents.walls;
+    PathPlanner& planner = agents.planners[i];
+    if ((planner.g.empty() || planner.goal == row * walls.cols + col) && !retargetSeeker(agents, i, row, col))
+        return false;
+    movePlannerStart(planner, row, col);
+    if (!planPath(planner, walls) && (!retargetSeeker(agents, i, row, col) || !planPath(planner, walls)))
+        return false;
+    int nextRow, nextCol;
+    if (!nextPathStep(planner, walls, nextRow, nextCol))
+        return false;
+    dx = nextCol - col;
+    dz = nextRow - row;
+    return true;
+}
+
+// At a cell centre: head for a random open neighbour, turning back only in
+// a dead end. Seekers follow their plan instead.
+void chooseDirection(AgentSystem& agents, int i) {
+    const int dirs[4][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}}; // (dx, dz)
+    int col = cellOf(agents.posX[i], agents.walls.cols);
+    int row = cellOf(agents.posZ[i], agents.walls.rows);
+    int dx, dz;
+    if (i < agents.seekers && plannedStep(agents, i, row, col, dx, dz)) {
+        startWalking(agents, i, dx, dz);
+        // stop at the next centre (not this one) to plan again
+        agents.timer[i] = 0.5f / AGENT_SPEED;
+        return;
+    }
+
+    float backX = -std::sin(agents.heading[i]), backZ = -std::cos(agents.heading[i]);
+
+    int open[4], openCount = 0, back = -1;
+    for (int d = 0; d < 4; ++d) {
+        if (wallAt(agents.walls, row + dirs[d][1], col + dirs[d][0]))
+            continue;
+        if (dirs[d][0] * backX + dirs[d][1] * backZ > 0.5f)
+            back = d;
+        else
+            open[openCount++] = d;
+    }
+    if (openCount == 0 && back >= 0)
+        open[openCount++] = back;
+    if (openCount == 0)
+        return; // walled in; stay paused
+
+    int d = open[nextRandom(agents.rng[i]) % openCount];
+    startWalking(agents, i, dirs[d][0], dirs[d][1]);
+    agents.timer[i] = i < agents.seekers ? 0.5f / AGENT_SPEED : 1.0f + 4.0f * randomUnit(agents.rng[i]);
+}
+
+void updateRange(AgentSystem& agents, float dt, int begin, int end) {
+    float* posX = agents.posX.data();
+    float* posZ = agents.posZ.data();
+    float* velX = agents.velX.data();
+    float* velZ = agents.velZ.data();
+    float* nextX = agents.nextX.data();
+    float* nextZ = agents.nextZ.data();
+    float* timer = agents.timer.data();
+
+    // integrate: independent streams, no branches
+    for (int i = begin; i < end; ++i) {
+        nextX[i] = posX[i] + velX[i] * dt;
+        nextZ[i] = posZ[i] + velZ[i] * dt;
+        timer[i] -= dt;
+    }
+
+    // collide against the grid and run the state machine. Agents walk along
+    // cell centre lines, one axis at a time, so only the cell ahead of the
+    // leading edge can be hit.
+    const MazeBits& walls = agents.walls;
+    for (int i = begin; i < end; ++i) {
+        if (agents.state[i] == AGENT_PAUSED) {
+            if (timer[i] <= 0.0f)
+                chooseDirection(agents, i);
+            continue;
+        }
+        int row = cellOf(posZ[i], walls.rows), col = cellOf(posX[i], walls.cols);
+        if (velX[i] != 0.0f) {
+            float edge = nextX[i] + (velX[i] > 0.0f ? AGENT_RADIUS : -AGENT_RADIUS);
+            if (wallAt(walls, row, cellOf(edge, walls.cols))) {
+                nextX[i] = posX[i];
+                velX[i] = -velX[i];
+                agents.heading[i] = std::atan2(velX[i], velZ[i]);
+            }
+        }
+        if (velZ[i] != 0.0f) {
+            float edge = nextZ[i] + (velZ[i] > 0.0f ? AGENT_RADIUS : -AGENT_RADIUS);
+            if (wallAt(walls, cellOf(edge, walls.rows), col)) {
+                nextZ[i] = posZ[i];
+                velZ[i] = -velZ[i];
+                agents.heading[i] = std::atan2(velX[i], velZ[i]);
+            }
+        }
+
+        // turns happen at cell centres only, after a short pause
+        float centre;
+        bool atCentre = velX[i] != 0.0f ? crossedCentre(posX[i], nextX[i], centre)
+                                         : crossedCentre(posZ[i], nextZ[i], centre);
+        if (timer[i] <= 0.0f && atCentre) {
+            (velX[i] != 0.0f ? nextX[i] : nextZ[i]) = centre;
+            velX[i] = velZ[i] = 0.0f;
+            agents.state[i] = AGENT_PAUSED;
+            // seekers turn without dawdling
+            timer[i] = i < agents.seekers ? 0.0f : 0.2f + 0.6f * randomUnit(agents.rng[i]);
+        }
+    }
+
+    for (int i = begin; i < end; ++i) {
+        posX[i] = nextX[i];
+        posZ[i] = nextZ[i];
+    }
+}
+
+} // namespace
+
+void initAgents(AgentSystem& agents, const MazeBits& bits, int count, uint32_t seed, JobSystem* jobs) {
+    agents.jobs = jobs;
+    agents.walls = bits;
+    std::vector<std::pair<int, int>> open;
+    for (int row = 0; row < bits.rows; ++row)
+        for (int col = 0; col < bits.cols; ++col)
+            if (!bits.isWall(row, col))
+                open.push_back({row, col});
+    agents.count = open.empty() ? 0 : std::max(count, 0);
+
+    agents.posX.resize(agents.count);
+    agents.posZ.resize(agents.count);
+    agents.velX.assign(agents.count, 0.0f);
+    agents.velZ.assign(agents.count, 0.0f);
+    agents.nextX.resize(agents.count);
+    agents.nextZ.resize(agents.count);
+    agents.timer.resize(agents.count);
+    agents.heading.resize(agents.count);
+    agents.state.assign(agents.count, AGENT_PAUSED);
+    agents.rng.resize(agents.count);
+
+    uint32_t spawn = seed | 1u;
+    for (int i = 0; i < agents.count; ++i) {
+        const auto& cell = open[nextRandom(spawn) % open.size()];
+        glm::vec3 position = mazeCellPosition(cell.first, cell.second, bits.rows, bits.cols);
+        agents.posX[i] = position.x;
+        agents.posZ[i] = position.z;
+        agents.rng[i] = (seed ^ (static_cast<uint32_t>(i) * 0x9E3779B9u)) | 1u;
+        agents.heading[i] = 2.0f * PI * randomUnit(agents.rng[i]);
+        agents.timer[i] = randomUnit(agents.rng[i]); // stagger the first steps
+    }
+    initSpatialHash(agents.nearby, agents.count);
+    buildSpatialHash(agents.nearby, agents.posX.data(), agents.posZ.data(), agents.count);
+
+    // fixed from here on: updates never grow the arrays
+    const SpatialHash& hash = agents.nearby;
+    size_t bytes = agents.walls.words.capacity() * sizeof(uint32_t) +
+                   agents.count * (8 * sizeof(float) + sizeof(uint8_t) + sizeof(uint32_t)) +
+                   hash.bucketStart.capacity() * sizeof(uint32_t) +
+                   hash.capacity * (2 * sizeof(uint32_t) + 2 * sizeof(float) + 2 * sizeof(int32_t));
+    reportCpuMemory(MEMORY_AGENTS, &agents, bytes);
+}
+
+void setAgentSeekers(AgentSystem& agents, int count) {
+    agents.seekers = std::clamp(count, 0, agents.count);
+    agents.planners.resize(agents.seekers);
+    agents.changedCells.reserve(64);
+}
+
+void agentWallChanged(AgentSystem& agents, int row, int col) {
+    if (agents.seekers > 0)
+        agents.changedCells.push_back(row * agents.walls.cols + col);
+}
+
+void updateAgents(AgentSystem& agents, float dt) {
+    if (!agents.changedCells.empty()) {
+        // planners that have not planned yet will start from the new walls
+        auto repair = [&agents](int begin, int end) {
+            const MazeBits& walls = agents.walls;
+            for (int i = begin; i < end; ++i) {
+                PathPlanner& planner = agents.planners[i];
+                if (planner.g.empty())
+                    continue;
+                for (int cell : agents.changedCells)
+                    plannerCellChanged(planner, walls, cell / walls.cols, cell % walls.cols);
+            }
+        };
+        if (agents.jobs && agents.seekers > SEEKER_GRAIN)
+            parallelFor(*agents.jobs, 0, agents.seekers, SEEKER_GRAIN, repair);
+        else
+            repair(0, agents.seekers);
+        agents.changedCells.clear();
+    }
+
+    auto update = [&agents, dt](int begin, int end) { updateRange(agents, dt, begin, end); };
+    if (agents.jobs && agents.count > AGENT_GRAIN)
+        parallelFor(*agents.jobs, 0, agents.count, AGENT_GRAIN, update);
+    else
+        update(0, agents.count);
+    buildSpatialHash(agents.nearby, agents.posX.data(), agents.posZ.data(), agents.count);
+}
+
+void writeAgentInstances(const AgentSystem& agents, std::vector<glm::vec4>& instances) {
+    instances.resize(agents.count);
+    for (int i = 0; i < agents.count; ++i)
+        instances[i] = glm::vec4(agents.posX[i], agents.posZ[i], agents.heading[i], (i * 37 % 101) / 101.0f);
+}
+
+bool initAgentInstances(AgentInstances& instances) {
+    instances.program.stages = {{GL_VERTEX_SHADER, shaderPath("agent.vert")},
+                                {GL_FRAGMENT_SHADER, shaderPath("agent.frag")}};
+    instances.depthProgram.stages = {{GL_VERTEX_SHADER, shaderPath("agent_depth.vert")},
+                                     {GL_FRAGMENT_SHADER, shaderPath("shadow_depth.frag")}};
+    if (!buildShaderProgram(instances.program) || !buildShaderProgram(instances.depthProgram))
+        return false;
+
+    glGenVertexArrays(1, &instances.vao);
+    glGenBuffers(1, &instances.instanceBuffer);
+    glBindVertexArray(instances.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instances.instanceBuffer);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *) 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void uploadAgentInstances(AgentInstances& instances, const std::vector<glm::vec4>& data) {
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(data.size() * sizeof(glm::vec4));
+    glBindBuffer(GL_ARRAY_BUFFER, instances.instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    trackBufferMemory(MEMORY_AGENTS, instances.instanceBuffer, bytes);
+    if (bytes > 0)
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instances.count = static_cast<GLsizei>(data.size());
+}
+
+void drawAgentInstances(const AgentInstances& instances) {
+    if (instances.count == 0)
+        return;
+    glBindVertexArray(instances.vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, verticesPerAgent, instances.count);
+}
+
+void drawAgentShadows(const AgentInstances& instances, const glm::mat4& lightMatrix) {
+    if (instances.count == 0)
+        return;
+    glUseProgram(instances.depthProgram.id);
+    glUniformMatrix4fv(glGetUniformLocation(instances.depthProgram.id, "lightMatrix"), 1, GL_FALSE, &lightMatrix[0][0]);
+    glBindVertexArray(instances.vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, verticesPerAgent, instances.count);
+}
+
+void deleteAgentInstances(AgentInstances& instances) {
+    deleteShaderProgram(instances.program);
+    deleteShaderProgram(instances.depthProgram);
+    glDeleteVertexArrays(1, &instances.vao);
+    untrackBufferMemory(instances.instanceBuffer);
+    glDeleteBuffers(1, &instances.instanceBuffer);
+    instances.vao = instances.instanceBuffer = 0;
+    instances.count = 0;
+}
@@ -0,0 +1,57 @@
+#include <allocation_counter.hpp>
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local uint64_t threadAllocations = 0;
+
+} // namespace
+
+#ifndef NDEBUG
+
+// Only the plain and array forms are replaced; the nothrow forms forward to
+// them and over-aligned allocations are rare enough to leave alone
+void* operator new(std::size_t size) {
+    ++threadAllocations;
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+bool allocationCountingAvailable() {
+    return true;
+}
+
+#else
+
+bool allocationCountingAvailable() {
+    return false;
+}
+
+#endif
+
+uint64_t threadAllocationCount() {
+    return threadAllocations;
+}
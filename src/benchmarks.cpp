@@ -0,0 +1,579 @@
+#include <benchmarks.hpp>
+#include <fixed_maze.hpp>
+#include <jobs.hpp>
+#include <lights.hpp>
+#include <maze.hpp>
+#include <maze_edit.hpp>
+#include <maze_mesh.hpp>
+#include <memory_stats.hpp>
+#include <pathfinding.hpp>
+#include <raycast.hpp>
+#include <replication.hpp>
+#include <spatial_hash.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedNanoseconds(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// Entities at a constant density in a square that grows with their count, so
+// each query finds about the same number of neighbours at every size. The
+// spatial hash should stay flat while the brute-force scan grows linearly.
+void benchSpatialHash() {
+    const float density = 4.0f; // entities per square unit (about one maze cell)
+    const float radius = 1.5f;
+    const int queries = 2000;
+    const int rebuilds = 20;
+
+    std::printf("%10s %14s %16s %16s %10s\n", "entities", "rebuild ns/e", "hash ns/query", "scan ns/query",
+                "found");
+    std::mt19937 rng(42);
+    SpatialHash hash;
+    std::vector<uint32_t> results;
+    for (int count = 1000; count <= 256000; count *= 4) {
+        float side = std::sqrt(count / density);
+        std::uniform_real_distribution<float> coordinate(-side / 2, side / 2);
+        std::vector<float> x(count), z(count);
+        for (int i = 0; i < count; ++i) {
+            x[i] = coordinate(rng);
+            z[i] = coordinate(rng);
+        }
+        std::vector<glm::vec2> centres(queries);
+        for (glm::vec2& centre : centres)
+            centre = glm::vec2(coordinate(rng), coordinate(rng));
+
+        initSpatialHash(hash, count);
+        Clock::time_point start = Clock::now();
+        for (int r = 0; r < rebuilds; ++r)
+            buildSpatialHash(hash, x.data(), z.data(), count);
+        double rebuild = elapsedNanoseconds(start) / rebuilds / count;
+
+        results.reserve(1024);
+        long found = 0;
+        start = Clock::now();
+        for (const glm::vec2& centre : centres) {
+            results.clear();
+            found += querySpatialHashRadius(hash, centre, radius, results);
+        }
+        double hashQuery = elapsedNanoseconds(start) / queries;
+
+        // the test every caller had to write before the broad phase
+        long scanned = 0;
+        start = Clock::now();
+        for (const glm::vec2& centre : centres) {
+            for (int i = 0; i < count; ++i) {
+                float dx = x[i] - centre.x, dz = z[i] - centre.y;
+                scanned += dx * dx + dz * dz <= radius * radius;
+            }
+        }
+        double scanQuery = elapsedNanoseconds(start) / queries;
+
+        std::printf("%10d %14.2f %16.1f %16.1f %10.1f%s\n", count, rebuild, hashQuery, scanQuery,
+                    static_cast<double>(found) / queries, found == scanned ? "" : "  MISMATCH");
+    }
+}
+
+// First wall cell along the ray by sampling it in small steps, or -1; the
+// reference the DDA is checked against
+int32_t sampledHit(const MazeBits& bits, const RayBatch& batch, int i) {
+    const float step = 1.0f / 4096.0f;
+    for (float t = 0.0f; t < batch.maxDistance[i]; t += step) {
+        float x = batch.originX[i] + batch.dirX[i] * t + static_cast<float>(bits.cols / 2) + 0.5f;
+        float z = batch.originZ[i] + batch.dirZ[i] * t + static_cast<float>(bits.rows / 2) + 0.5f;
+        int col = static_cast<int>(std::floor(x)), row = static_cast<int>(std::floor(z));
+        if (row >= 0 && col >= 0 && row < bits.rows && col < bits.cols && bits.isWall(row, col))
+            return row * bits.cols + col;
+    }
+    return -1;
+}
+
+void benchRaycastGrid(const char* label, const MazeBits& bits, JobSystem& jobs, float maxDistance) {
+    const int rayCount = 1 << 20;
+    const int repeats = 5;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> row(0, bits.rows - 1), col(0, bits.cols - 1);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f), jitter(-0.45f, 0.45f);
+
+    // from random open cells in random directions
+    RayBatch batch;
+    resizeRayBatch(batch, rayCount);
+    for (int i = 0; i < rayCount; ++i) {
+        int r, c;
+        do {
+            r = row(rng);
+            c = col(rng);
+        } while (bits.isWall(r, c));
+        glm::vec3 centre = mazeCellPosition(r, c, bits.rows, bits.cols);
+        float a = angle(rng);
+        setRay(batch, i, glm::vec2(centre.x + jitter(rng), centre.z + jitter(rng)),
+               glm::vec2(std::cos(a), std::sin(a)), maxDistance);
+    }
+
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < repeats; ++r)
+        castRays(bits, batch, nullptr);
+    double serial = elapsedNanoseconds(start) / repeats;
+    start = Clock::now();
+    for (int r = 0; r < repeats; ++r)
+        castRays(bits, batch, &jobs);
+    double parallel = elapsedNanoseconds(start) / repeats;
+
+    double cells = 0.0;
+    int hits = 0;
+    for (int i = 0; i < rayCount; ++i) {
+        cells += batch.hitDistance[i];
+        hits += batch.hitRow[i] >= 0;
+    }
+    int mismatches = 0;
+    for (int i = 0; i < rayCount; i += 1024) {
+        int32_t expected = sampledHit(bits, batch, i);
+        int32_t found = batch.hitRow[i] < 0 ? -1 : batch.hitRow[i] * bits.cols + batch.hitCol[i];
+        mismatches += expected != found;
+    }
+
+    std::printf("%-8s %9dx%-5d %12.1f %12.1f %10.1f %8.1f%% %10d\n", label, bits.cols, bits.rows,
+                rayCount / serial * 1e3, rayCount / parallel * 1e3, cells / rayCount, 100.0 * hits / rayCount,
+                mismatches);
+}
+
+// Rays per second on one core and on the job system, in a generated maze
+// (short corridors) and a sparse grid (long open lines)
+void benchRaycast() {
+    JobSystem jobs;
+    initJobSystem(jobs, 0);
+    std::printf("%-8s %15s %12s %12s %10s %9s %10s\n", "grid", "size", "Mrays/s 1x", "Mrays/s all",
+                "avg dist", "hit", "mismatch");
+
+    std::vector<std::vector<int>> maze;
+    generateMaze(maze, 255, 255);
+    MazeBits bits;
+    packMaze(maze, bits);
+    benchRaycastGrid("maze", bits, jobs, 64.0f);
+
+    std::mt19937 rng(11);
+    std::bernoulli_distribution wall(0.02);
+    maze.assign(1024, std::vector<int>(1024, 0));
+    for (auto& cells : maze)
+        for (int& cell : cells)
+            cell = wall(rng) ? 1 : 0;
+    packMaze(maze, bits);
+    benchRaycastGrid("sparse", bits, jobs, 256.0f);
+    deleteJobSystem(jobs);
+}
+
+// Lists of the same lights, whichever order they were binned in
+bool sameLights(const LightGrid& a, const LightGrid& b, size_t cell) {
+    std::vector<uint32_t> left(a.indices.begin() + a.cells[2 * cell],
+                               a.indices.begin() + a.cells[2 * cell] + a.cells[2 * cell + 1]);
+    std::vector<uint32_t> right(b.indices.begin() + b.cells[2 * cell],
+                                b.indices.begin() + b.cells[2 * cell] + b.cells[2 * cell + 1]);
+    std::sort(left.begin(), left.end());
+    std::sort(right.begin(), right.end());
+    return left == right;
+}
+
+// The CPU side of one wall edit (re-meshing the chunks around it, re-binning
+// the lights that reach it) against rebuilding everything derived from the
+// maze. The GPU side is one texel, those chunks' uploads and a sub-upload of
+// the light cells either way. Afterwards the incrementally binned lights are
+// checked against a full binning.
+void benchMazeEdit() {
+    const int size = 255;
+    const int edits = 2000;
+    const int rebuilds = 5;
+
+    std::vector<std::vector<int>> maze;
+    generateMaze(maze, size, size, 7u);
+    MazeBits bits;
+    packMaze(maze, bits);
+    std::vector<PointLight> lights;
+    placeTorches(bits, 2048, 1234u, lights);
+    LightGrid grid;
+    binLights(bits, lights, grid);
+    int chunksX = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    int chunkCount = chunksX * chunksX;
+
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> cell(1, size - 2);
+    ChunkGeometry geometry;
+    std::vector<int> chunks;
+    double editNs = 0.0;
+    int applied = 0, meshed = 0, compactions = 0;
+    for (int i = 0; i < edits; ++i) {
+        MazeEdit edit;
+        edit.row = cell(rng);
+        edit.col = cell(rng);
+        edit.wall = maze[edit.row][edit.col] == 0;
+        auto start = Clock::now();
+        applyMazeEdit(maze, bits, edit);
+        chunks.clear();
+        chunksTouchingCell(size, size, edit.row, edit.col, chunks);
+        for (int chunk : chunks)
+            meshMazeChunk(maze, chunk % chunksX, chunk / chunksX, geometry);
+        rebinLightsAround(bits, lights, grid, edit.row, edit.col);
+        if (grid.unusedIndices > grid.indices.size() / 2) { // as applyMazeEdits does
+            binLights(bits, lights, grid);
+            ++compactions;
+        }
+        editNs += elapsedNanoseconds(start);
+        ++applied;
+        meshed += static_cast<int>(chunks.size());
+    }
+
+    auto start = Clock::now();
+    LightGrid full;
+    for (int r = 0; r < rebuilds; ++r) {
+        packMaze(maze, bits);
+        for (int chunk = 0; chunk < chunkCount; ++chunk)
+            meshMazeChunk(maze, chunk % chunksX, chunk / chunksX, geometry);
+        binLights(bits, lights, full);
+    }
+    double rebuildNs = elapsedNanoseconds(start) / rebuilds;
+
+    size_t mismatched = 0;
+    for (size_t c = 0; c < grid.cells.size() / 2; ++c)
+        if (!sameLights(grid, full, c))
+            ++mismatched;
+
+    std::printf("%dx%d maze, %zu torches, %d chunks\n", size, size, lights.size(), chunkCount);
+    std::printf("edit:         %10.1f us (%.1f chunks re-meshed, %d full re-binnings in %d edits)\n",
+                editNs / applied / 1000.0, static_cast<double>(meshed) / applied, compactions, applied);
+    std::printf("full rebuild: %10.1f us (%.0fx)\n", rebuildNs / 1000.0, rebuildNs / (editNs / applied));
+    std::printf("light cells differing from a full binning: %zu\n", mismatched);
+}
+
+// One agent crossing a shifting maze: every few steps some walls between
+// corridor cells open and as many close, anywhere in the maze, and the agent
+// replans with D* Lite (repairing its previous search) and, for comparison,
+// with A* from scratch. Both must agree on the length of the path. The maze
+// gets some loops first, so that a closed wall rarely cuts it in two; when
+// the goal is cut off anyway, the agent gets a new one (not a replan).
+void benchReplanningMaze(int size, uint32_t seed) {
+    const int moves = 2000;
+    const int shiftEvery = 4;  // moves
+    const int shiftCells = 4;  // walls opened, and closed, per shift
+
+    std::vector<std::vector<int>> maze;
+    generateMaze(maze, size, size, seed);
+    MazeBits bits;
+    packMaze(maze, bits);
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution braid(0.1);
+    for (int r = 1; r < size - 1; ++r)
+        for (int c = 1; c < size - 1; ++c)
+            if ((r + c) % 2 == 1 && braid(rng))
+                bits.setWall(r, c, false);
+    std::uniform_int_distribution<int> interior(1, size - 2);
+    // rooms are the odd cells; a random one, far from the agent or not
+    auto randomRoom = [&rng, &interior]() { return interior(rng) | 1; };
+
+    PathPlanner planner;
+    PathSearch search;
+    int row = 1, col = 1, goalRow = size - 2, goalCol = size - 2;
+
+    auto start = Clock::now();
+    initPathPlanner(planner, bits, row, col, goalRow, goalCol);
+    planPath(planner, bits);
+    double firstPlanNs = elapsedNanoseconds(start);
+    start = Clock::now();
+    findPath(bits, row, col, goalRow, goalCol, search);
+    double firstSearchNs = elapsedNanoseconds(start);
+
+    double replanNs = 0.0, searchNs = 0.0;
+    uint64_t replanExpanded = 0, searchExpanded = 0;
+    int replans = 0, mismatches = 0, retargets = 0;
+    for (int move = 1; move <= moves; ++move) {
+        bool shifted = move % shiftEvery == 0;
+        if (shifted) {
+            int opened = 0, closed = 0;
+            while (opened < shiftCells || closed < shiftCells) {
+                int r = interior(rng), c = interior(rng);
+                if ((r + c) % 2 == 0 || (r == row && c == col))
+                    continue; // rooms and pillars stay, as in shiftWalls()
+                bool wall = bits.isWall(r, c);
+                if (wall ? opened == shiftCells : closed == shiftCells)
+                    continue;
+                bits.setWall(r, c, !wall);
+                plannerCellChanged(planner, bits, r, c);
+                ++(wall ? opened : closed);
+            }
+        }
+
+        uint64_t expanded = planner.expanded;
+        start = Clock::now();
+        movePlannerStart(planner, row, col);
+        bool reachable = planPath(planner, bits);
+        double planNs = elapsedNanoseconds(start);
+        if (!reachable) {
+            goalRow = randomRoom();
+            goalCol = randomRoom();
+            initPathPlanner(planner, bits, row, col, goalRow, goalCol);
+            planPath(planner, bits);
+            ++retargets;
+        } else if (shifted) {
+            replanNs += planNs;
+            replanExpanded += planner.expanded - expanded;
+            expanded = search.expanded;
+            start = Clock::now();
+            int length = findPath(bits, row, col, goalRow, goalCol, search);
+            searchNs += elapsedNanoseconds(start);
+            searchExpanded += search.expanded - expanded;
+            if (length != plannedLength(planner))
+                ++mismatches;
+            ++replans;
+        }
+
+        if (!nextPathStep(planner, bits, row, col)) {
+            // arrived (or walled in): on to a new goal
+            goalRow = randomRoom();
+            goalCol = randomRoom();
+            initPathPlanner(planner, bits, row, col, goalRow, goalCol);
+            ++retargets;
+        }
+    }
+    forgetCpuMemory(&planner);
+
+    replans = std::max(replans, 1);
+    std::printf("%4dx%-4d %10.2f %10.2f %9d %11.1f %11.1f %8.1fx %11.0f %11.0f %9d %9d\n", size, size,
+                firstPlanNs / 1e6, firstSearchNs / 1e6, replans, replanNs / replans / 1000.0,
+                searchNs / replans / 1000.0, searchNs / std::max(replanNs, 1.0),
+                static_cast<double>(replanExpanded) / replans, static_cast<double>(searchExpanded) / replans,
+                retargets, mismatches);
+}
+
+void benchReplanning() {
+    std::printf("%-9s %10s %10s %9s %11s %11s %9s %11s %11s %9s %9s\n", "maze", "first D*ms", "first A*ms",
+                "replans", "D* us", "A* us", "speedup", "D* cells", "A* cells", "retarget", "mismatch");
+    benchReplanningMaze(127, 5u);
+    benchReplanningMaze(255, 5u);
+    benchReplanningMaze(511, 5u);
+}
+
+// Generated by the compiler; the assert fails the build if it is not
+constexpr Maze<19, 19> EMBEDDED_MAZE = generateFixedMaze<19, 19>(2024u);
+static_assert(!EMBEDDED_MAZE.isWall(17, 17) && EMBEDDED_MAZE.isWall(0, 0), "embedded maze is carved");
+
+// The collision and path kernels on a Maze<W, H> against the same code on
+// MazeBits of the same maze. Both must give the same answers, and the
+// path lengths must match A*'s.
+template <int W, int H>
+void benchFixedMazeSize() {
+    const int points = 1 << 20;
+    const float radius = 0.2f; // an agent's
+    const int paths = 4000000 / (W * H) + 100;
+
+    std::vector<std::vector<int>> maze;
+    generateMaze(maze, H, W, 9u);
+    MazeBits bits;
+    packMaze(maze, bits);
+    Maze<W, H> fixed;
+    loadFixedMaze(bits, fixed);
+
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> x(-W / 2 - 0.5f, W / 2 + 0.5f), z(-H / 2 - 0.5f, H / 2 + 0.5f);
+    std::vector<float> pointX(points), pointZ(points);
+    for (int i = 0; i < points; ++i) {
+        pointX[i] = x(rng);
+        pointZ[i] = z(rng);
+    }
+    std::vector<uint8_t> dynamicHits(points), fixedHits(points);
+    auto start = Clock::now();
+    for (int i = 0; i < points; ++i)
+        dynamicHits[i] = circleHitsWall(bits, pointX[i], pointZ[i], radius);
+    double dynamicCollisionNs = elapsedNanoseconds(start) / points;
+    start = Clock::now();
+    for (int i = 0; i < points; ++i)
+        fixedHits[i] = circleHitsWall(fixed, pointX[i], pointZ[i], radius);
+    double fixedCollisionNs = elapsedNanoseconds(start) / points;
+    int mismatches = 0;
+    for (int i = 0; i < points; ++i)
+        mismatches += dynamicHits[i] != fixedHits[i];
+
+    std::vector<int> open;
+    for (int row = 0; row < H; ++row)
+        for (int col = 0; col < W; ++col)
+            if (!bits.isWall(row, col))
+                open.push_back(row * W + col);
+    std::uniform_int_distribution<size_t> pick(0, open.size() - 1);
+    std::vector<int> from(paths), to(paths), dynamicSteps(paths), fixedSteps(paths);
+    for (int i = 0; i < paths; ++i) {
+        from[i] = open[pick(rng)];
+        to[i] = open[pick(rng)];
+    }
+    WavefrontScratch<MazeBits> dynamicScratch;
+    start = Clock::now();
+    for (int i = 0; i < paths; ++i)
+        dynamicSteps[i] = wavefrontSteps(bits, from[i] / W, from[i] % W, to[i] / W, to[i] % W, dynamicScratch);
+    double dynamicPathNs = elapsedNanoseconds(start) / paths;
+    WavefrontScratch<Maze<W, H>> fixedScratch;
+    start = Clock::now();
+    for (int i = 0; i < paths; ++i)
+        fixedSteps[i] = wavefrontSteps(fixed, from[i] / W, from[i] % W, to[i] / W, to[i] % W, fixedScratch);
+    double fixedPathNs = elapsedNanoseconds(start) / paths;
+    PathSearch search;
+    for (int i = 0; i < paths; ++i)
+        mismatches += dynamicSteps[i] != fixedSteps[i] ||
+                      fixedSteps[i] != findPath(bits, from[i] / W, from[i] % W, to[i] / W, to[i] % W, search);
+
+    std::printf("%4dx%-4d %14.2f %14.2f %8.2fx %14.2f %14.2f %8.2fx %9d\n", W, H, dynamicCollisionNs,
+                fixedCollisionNs, dynamicCollisionNs / fixedCollisionNs, dynamicPathNs / 1000.0,
+                fixedPathNs / 1000.0, dynamicPathNs / fixedPathNs, mismatches);
+}
+
+void benchFixedMaze() {
+    std::printf("%-9s %14s %14s %9s %14s %14s %9s %9s\n", "maze", "collide ns dyn", "collide ns fix",
+                "speedup", "path us dyn", "path us fix", "speedup", "mismatch");
+    benchFixedMazeSize<19, 19>();
+    benchFixedMazeSize<63, 63>();
+    benchFixedMazeSize<127, 127>();
+
+    WavefrontScratch<Maze<19, 19>> scratch;
+    std::printf("embedded 19x19 maze (constexpr): %d steps corner to corner\n",
+                wavefrontSteps(EMBEDDED_MAZE, 1, 1, 17, 17, scratch));
+}
+
+// A server and `clientCount` bots in one thread, over loopback, for ten
+// seconds of game time with 5% of the packets lost each way. Bots walk ahead
+// and turn where a wall stops them, and now and then jump or crouch. Every
+// tick each bot's newest decoded snapshot is compared with the server's
+// record of it; they must be identical.
+void benchReplicationRun(int mazeSize, int clientCount) {
+    const int ticks = 10 * REPLICATION_TICK_RATE;
+    const float loss = 0.05f;
+    const float dt = 1.0f / REPLICATION_TICK_RATE;
+
+    ReplicationServer server;
+    if (!startReplicationServer(server, 11u, mazeSize, 0))
+        return;
+    server.simulatedLoss = loss;
+    NetAddress address = loopbackAddress(udpSocketPort(server.socket));
+    std::vector<ReplicationClient> clients(clientCount);
+    std::vector<PlayerInput> inputs(clientCount);
+    std::vector<NetPlayer> lastSeen(clientCount);
+    std::vector<int> serverIndex(clientCount, -1);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int i = 0; i < clientCount; ++i) {
+        if (!connectReplicationClient(clients[i], address))
+            return;
+        clients[i].simulatedLoss = loss;
+        clients[i].rng.seed(100u + i);
+        inputs[i].yaw = 360.0f * unit(rng);
+    }
+
+    int mismatches = 0;
+    for (int tick = 0; tick < ticks; ++tick) {
+        for (int i = 0; i < clientCount; ++i) {
+            ReplicationClient& client = clients[i];
+            PlayerInput& input = inputs[i];
+            const std::vector<NetPlayer>& players = latestSnapshot(client).players;
+            auto self = std::lower_bound(players.begin(), players.end(), client.player,
+                                         [](const NetPlayer& player, uint16_t id) { return player.id < id; });
+            if (self != players.end() && self->id == client.player) {
+                if (self->x == lastSeen[i].x && self->z == lastSeen[i].z)
+                    input.yaw += unit(rng) < 0.5f ? 90.0f : -90.0f; // walked into a wall
+                lastSeen[i] = *self;
+            }
+            input.buttons = BUTTON_FORWARD;
+            if (unit(rng) < 0.01f)
+                input.buttons |= BUTTON_JUMP;
+            if (i % 8 == 0 && (tick / 120) % 2 == 1)
+                input.buttons |= BUTTON_CROUCH;
+            sendPlayerInput(client, input);
+        }
+        replicationServerTick(server, dt);
+        for (int i = 0; i < clientCount; ++i) {
+            ReplicationClient& client = clients[i];
+            receiveSnapshots(client);
+            if (client.latest == 0)
+                continue;
+            if (serverIndex[i] < 0) {
+                NetAddress self = loopbackAddress(udpSocketPort(client.socket));
+                for (size_t c = 0; c < server.clients.size(); ++c)
+                    if (server.clients[c].address == self)
+                        serverIndex[i] = static_cast<int>(c);
+            }
+            // nobody leaves during the run, so the indices stay put
+            const Snapshot& record = server.clients[serverIndex[i]].history[client.latest % SNAPSHOT_HISTORY];
+            const Snapshot& decoded = latestSnapshot(client);
+            if (record.sequence != decoded.sequence || record.players.size() != decoded.players.size() ||
+                !std::equal(record.players.begin(), record.players.end(), decoded.players.begin()))
+                ++mismatches;
+        }
+    }
+    // and everyone leaves: the server must let go of all of them
+    for (ReplicationClient& client : clients)
+        disconnectReplicationClient(client);
+    replicationServerTick(server, dt);
+    mismatches += static_cast<int>(server.clients.size());
+
+    const ReplicationStats& stats = server.stats;
+    double seconds = static_cast<double>(ticks) / REPLICATION_TICK_RATE;
+    uint64_t snapshots = stats.fullSnapshots + stats.deltaSnapshots;
+    // the same snapshots, every player sent whole as floats (id, position,
+    // yaw, pitch, flags) after the same 13-byte header
+    double rawBytes = 13.0 * snapshots + (2.0 + 5 * sizeof(float) + 1.0) * stats.playersVisible;
+    uint64_t undecodable = 0;
+    for (const ReplicationClient& client : clients)
+        undecodable += client.stats.undecodable;
+    std::printf("%4dx%-4d %7d %9.3f %9.3f %9.0f %9.0f %7.2f%% %8.1f %8.1f %8.1fx %9llu %9llu %9d\n", mazeSize,
+                mazeSize, clientCount, (stats.simulateMs + stats.replicateMs) / stats.ticks,
+                stats.simulateMs / stats.ticks, stats.bytesSent / seconds / clientCount,
+                stats.bytesReceived / seconds / clientCount, 100.0 * stats.fullSnapshots / snapshots,
+                static_cast<double>(stats.playersVisible) / snapshots,
+                static_cast<double>(stats.playersWritten) / snapshots, rawBytes / stats.bytesSent,
+                static_cast<unsigned long long>(stats.playersDeferred), static_cast<unsigned long long>(undecodable),
+                mismatches);
+    stopReplicationServer(server);
+}
+
+void benchReplication() {
+    std::printf("%-9s %7s %9s %9s %9s %9s %8s %8s %8s %9s %9s %9s %9s\n", "maze", "clients", "tick ms", "sim ms",
+                "down B/s", "up B/s", "full", "visible", "written", "vs raw", "deferred", "undecoded", "mismatch");
+    benchReplicationRun(19, 16);
+    benchReplicationRun(63, 64);
+    benchReplicationRun(127, 256);
+}
+
+} // namespace
+
+bool runBenchmark(const std::string& name) {
+    if (name == "spatial-hash") {
+        benchSpatialHash();
+        return true;
+    }
+    if (name == "raycast") {
+        benchRaycast();
+        return true;
+    }
+    if (name == "maze-edit") {
+        benchMazeEdit();
+        return true;
+    }
+    if (name == "replanning") {
+        benchReplanning();
+        return true;
+    }
+    if (name == "fixed-maze") {
+        benchFixedMaze();
+        return true;
+    }
+    if (name == "replication") {
+        benchReplication();
+        return true;
+    }
+    std::cout << "ERROR::BENCHMARK::UNKNOWN " << name
+              << "\nAvailable: spatial-hash raycast maze-edit replanning fixed-maze replication" << std::endl;
+    return false;
+}
@@ -0,0 +1,293 @@
+#include <chunk_streaming.hpp>
+#include <frame_arena.hpp>
+#include <memory_stats.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+GLsizeiptr alignUp(GLsizeiptr size) {
+    return (size + 15) & ~GLsizeiptr(15);
+}
+
+// Give back the ring space of every batch the GPU has finished copying from
+void retireBatches(ChunkStreamer& streamer) {
+    while (!streamer.batches.empty()) {
+        StagingBatch& batch = streamer.batches.front();
+        GLenum status = glClientWaitSync(batch.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(batch.fence);
+        streamer.tail = batch.end;
+        streamer.batches.pop_front();
+    }
+    if (streamer.batches.empty())
+        streamer.head = streamer.tail = 0;
+}
+
+// Offset of `size` free bytes in the ring, or -1 when the GPU still owns too
+// much of it. The ring never fills up completely, so head == tail always
+// means empty.
+GLintptr allocateStaging(ChunkStreamer& streamer, GLsizeiptr size) {
+    if (streamer.head >= streamer.tail) {
+        if (STAGING_RING_BYTES - streamer.head >= size) {
+            GLintptr offset = streamer.head;
+            streamer.head += size;
+            return offset;
+        }
+        if (streamer.tail > size) { // wrap around
+            streamer.head = size;
+            return 0;
+        }
+        return -1;
+    }
+    if (streamer.tail - streamer.head > size) {
+        GLintptr offset = streamer.head;
+        streamer.head += size;
+        return offset;
+    }
+    return -1;
+}
+
+void uploadChunk(ChunkStreamer& streamer, MazeMesh& mesh, const MeshedChunk& meshed, GLintptr offset) {
+    const ChunkGeometry& geometry = meshed.geometry;
+    const MazeChunk& chunk = mesh.chunks[meshed.chunk];
+    GLsizeiptr vertexBytes = geometry.vertices.size() * sizeof(float);
+    GLsizeiptr indexBytes = geometry.indices.size() * sizeof(unsigned int);
+
+    // the fences make sure this range is no longer being read by the GPU
+    glBindBuffer(GL_COPY_READ_BUFFER, streamer.stagingBuffer);
+    void* staging = glMapBufferRange(GL_COPY_READ_BUFFER, offset, vertexBytes + indexBytes,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!staging) {
+        std::cout << "ERROR::CHUNK_STREAMING::MAP_FAILED" << std::endl;
+        return;
+    }
+    std::memcpy(staging, geometry.vertices.data(), vertexBytes);
+    std::memcpy(static_cast<char*>(staging) + vertexBytes, geometry.indices.data(), indexBytes);
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mesh.vbo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset,
+                        static_cast<GLintptr>(chunk.baseVertex) * MESH_VERTEX_FLOATS * sizeof(float), vertexBytes);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mesh.ebo);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset + vertexBytes,
+                        static_cast<GLintptr>(chunk.firstIndex) * sizeof(unsigned int), indexBytes);
+}
+
+} // namespace
+
+void initChunkStreamer(ChunkStreamer& streamer, const MazeMesh& mesh, JobSystem* jobs, GLsizeiptr uploadBudget) {
+    streamer.jobs = jobs;
+    streamer.uploadBudget = uploadBudget;
+    streamer.chunksX = mesh.chunksX;
+    streamer.latestVersion.assign(mesh.chunks.size(), 0);
+    streamer.appliedVersion.assign(mesh.chunks.size(), 0);
+    streamer.residencyRequests.reserve(mesh.slotCount);
+
+    glGenBuffers(1, &streamer.stagingBuffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, streamer.stagingBuffer);
+    glBufferData(GL_COPY_READ_BUFFER, STAGING_RING_BYTES, nullptr, GL_STREAM_DRAW);
+    trackBufferMemory(MEMORY_STREAMING, streamer.stagingBuffer, STAGING_RING_BYTES);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+void requestChunkMeshes(ChunkStreamer& streamer, std::shared_ptr<const MazeGrid> maze,
+                        const std::vector<int>& chunks) {
+    std::lock_guard<std::mutex> lock(streamer.mutex);
+    streamer.maze = maze;
+    for (int chunk : chunks) {
+        uint64_t version = ++streamer.nextVersion;
+        streamer.latestVersion[chunk] = version;
+        int chunkX = chunk % streamer.chunksX;
+        int chunkZ = chunk / streamer.chunksX;
+
+        if (!streamer.jobs) {
+            MeshedChunk meshed;
+            meshed.chunk = chunk;
+            meshed.version = version;
+            meshMazeChunk(*maze, chunkX, chunkZ, meshed.geometry);
+            streamer.finished.push_back(std::move(meshed));
+            continue;
+        }
+
+        ++streamer.meshing;
+        JobHandle job = createJob([&streamer, maze, chunk, chunkX, chunkZ, version] {
+            MeshedChunk meshed;
+            meshed.chunk = chunk;
+            meshed.version = version;
+            meshMazeChunk(*maze, chunkX, chunkZ, meshed.geometry);
+
+            std::lock_guard<std::mutex> lock(streamer.mutex);
+            streamer.finished.push_back(std::move(meshed));
+            --streamer.meshing;
+        });
+        streamer.running.push_back(job);
+        runJob(*streamer.jobs, job);
+    }
+}
+
+int streamChunkUploads(ChunkStreamer& streamer, MazeMesh& mesh) {
+    retireBatches(streamer);
+    streamer.uploadedChunks.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        for (MeshedChunk& meshed : streamer.finished)
+            streamer.waiting.push_back(std::move(meshed));
+        streamer.finished.clear();
+        // a chunk requested again while in flight only needs its newest mesh
+        streamer.waiting.erase(std::remove_if(streamer.waiting.begin(), streamer.waiting.end(),
+                                              [&](const MeshedChunk& meshed) {
+                                                  return meshed.version != streamer.latestVersion[meshed.chunk];
+                                              }),
+                               streamer.waiting.end());
+        streamer.running.erase(std::remove_if(streamer.running.begin(), streamer.running.end(), jobFinished),
+                               streamer.running.end());
+    }
+
+    GLsizeiptr uploadedBytes = 0;
+    size_t done = 0;
+    for (; done < streamer.waiting.size(); ++done) {
+        const MeshedChunk& meshed = streamer.waiting[done];
+        const ChunkGeometry& geometry = meshed.geometry;
+        if (geometry.vertices.size() > static_cast<size_t>(mesh.slotVertices) * MESH_VERTEX_FLOATS ||
+            geometry.indices.size() > static_cast<size_t>(mesh.slotIndices)) {
+            std::cout << "ERROR::CHUNK_STREAMING::CHUNK_TOO_LARGE " << meshed.chunk << std::endl;
+            continue;
+        }
+
+        GLsizeiptr bytes = alignUp((geometry.vertices.size() + geometry.indices.size()) * 4);
+        // always let one chunk through, however large, so nothing starves
+        if (uploadedBytes > 0 && uploadedBytes + bytes > streamer.uploadBudget)
+            break;
+        if (bytes > 0 && !acquireChunkSlot(mesh, meshed.chunk)) {
+            streamer.appliedVersion[meshed.chunk] = meshed.version;
+            streamer.residencyDirty = true;
+            continue;
+        }
+        if (bytes > 0) {
+            GLintptr offset = allocateStaging(streamer, bytes);
+            if (offset < 0)
+                break; // ring full until older copies complete
+            uploadChunk(streamer, mesh, meshed, offset);
+        }
+        setMazeChunkGeometry(mesh, meshed.chunk, geometry);
+        streamer.appliedVersion[meshed.chunk] = meshed.version;
+        streamer.uploadedChunks.push_back(meshed.chunk);
+        uploadedBytes += bytes;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (uploadedBytes > 0) {
+        StagingBatch batch;
+        batch.end = streamer.head;
+        batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        streamer.batches.push_back(batch);
+    }
+    streamer.waiting.erase(streamer.waiting.begin(), streamer.waiting.begin() + done);
+    if (!streamer.uploadedChunks.empty())
+        streamer.residencyDirty = true;
+
+    size_t waitingBytes = streamer.waiting.capacity() * sizeof(MeshedChunk);
+    for (const MeshedChunk& meshed : streamer.waiting)
+        waitingBytes += meshed.geometry.vertices.capacity() * sizeof(float) +
+                        meshed.geometry.indices.capacity() * sizeof(unsigned int);
+    reportCpuMemory(MEMORY_STREAMING, &streamer, waitingBytes);
+
+    streamer.stats.meshing = streamer.meshing.load();
+    streamer.stats.waiting = static_cast<int>(streamer.waiting.size());
+    streamer.stats.uploaded = static_cast<int>(streamer.uploadedChunks.size());
+    streamer.stats.bytes = uploadedBytes;
+    return static_cast<int>(streamer.uploadedChunks.size());
+}
+
+int updateChunkResidency(ChunkStreamer& streamer, MazeMesh& mesh, const glm::vec3& cameraPosition) {
+    int chunkCount = static_cast<int>(mesh.chunks.size());
+    if (mesh.slotCount >= chunkCount)
+        return 0; // everything fits
+
+    int64_t cameraChunkX = static_cast<int64_t>(std::floor(cameraPosition.x / CHUNK_SIZE));
+    int64_t cameraChunkZ = static_cast<int64_t>(std::floor(cameraPosition.z / CHUNK_SIZE));
+    int64_t key = (cameraChunkZ << 32) ^ (cameraChunkX & 0xffffffff);
+    if (key == streamer.residencyKey && !streamer.residencyDirty)
+        return 0;
+    streamer.residencyKey = key;
+    streamer.residencyDirty = false;
+
+    // nearest chunks first, until the slots run out; chunks known to be
+    // empty need none
+    glm::vec2 camera(cameraPosition.x, cameraPosition.z);
+    FrameArena& arena = threadFrameArena();
+    FrameVector<std::pair<float, int>> order = makeFrameVector<std::pair<float, int>>(arena);
+    order.reserve(chunkCount);
+    for (int i = 0; i < chunkCount; ++i) {
+        glm::vec3 boundsMin, boundsMax;
+        mazeChunkFootprint(mesh, i, boundsMin, boundsMax);
+        glm::vec2 low(boundsMin.x, boundsMin.z), high(boundsMax.x, boundsMax.z);
+        order.emplace_back(glm::length(camera - glm::clamp(camera, low, high)), i);
+    }
+    std::sort(order.begin(), order.end());
+
+    FrameVector<uint8_t> wanted(chunkCount, 0, ArenaAllocator<uint8_t>(arena));
+    int slotsLeft = mesh.slotCount;
+    for (const auto& entry : order) {
+        int cost = mesh.chunks[entry.second].state == CHUNK_EMPTY ? 0 : 1;
+        if (cost > slotsLeft)
+            break;
+        slotsLeft -= cost;
+        wanted[entry.second] = 1;
+    }
+
+    int evicted = 0;
+    for (int i = 0; i < chunkCount; ++i) {
+        if (!wanted[i] && mesh.chunks[i].state == CHUNK_RESIDENT) {
+            evictMazeChunk(mesh, i);
+            ++evicted;
+        }
+    }
+
+    std::shared_ptr<const MazeGrid> maze;
+    streamer.residencyRequests.clear();
+    {
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        maze = streamer.maze;
+        for (int i = 0; i < chunkCount; ++i) {
+            ChunkState state = mesh.chunks[i].state;
+            bool inFlight = streamer.latestVersion[i] != streamer.appliedVersion[i];
+            if (wanted[i] && (state == CHUNK_UNMESHED || state == CHUNK_EVICTED) && !inFlight)
+                streamer.residencyRequests.push_back(i);
+        }
+    }
+    if (maze && !streamer.residencyRequests.empty())
+        requestChunkMeshes(streamer, maze, streamer.residencyRequests);
+    return evicted;
+}
+
+void deleteChunkStreamer(ChunkStreamer& streamer) {
+    std::vector<JobHandle> running;
+    {
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        running = streamer.running;
+    }
+    for (const JobHandle& job : running)
+        waitForJob(*streamer.jobs, job);
+    streamer.running.clear();
+    streamer.finished.clear();
+    streamer.waiting.clear();
+
+    for (StagingBatch& batch : streamer.batches)
+        glDeleteSync(batch.fence);
+    streamer.batches.clear();
+    untrackBufferMemory(streamer.stagingBuffer);
+    forgetCpuMemory(&streamer);
+    glDeleteBuffers(1, &streamer.stagingBuffer);
+    streamer.stagingBuffer = 0;
+    streamer.maze.reset();
+    streamer.head = streamer.tail = 0;
+}
@@ -0,0 +1,90 @@
+#include <culling.hpp>
+
+#include <algorithm>
+
+Frustum extractFrustum(const glm::mat4& viewProjection) {
+    const glm::mat4& m = viewProjection;
+    // glm is column-major: row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum frustum;
+    frustum.planes[0] = row3 + row0; // left
+    frustum.planes[1] = row3 - row0; // right
+    frustum.planes[2] = row3 + row1; // bottom
+    frustum.planes[3] = row3 - row1; // top
+    frustum.planes[4] = row3 + row2; // near
+    frustum.planes[5] = row3 - row2; // far
+
+    for (glm::vec4& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool aabbInFrustum(const Frustum& frustum, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    for (const glm::vec4& plane : frustum.planes) {
+        // corner furthest along the plane normal
+        glm::vec3 positive(plane.x >= 0.0f ? boundsMax.x : boundsMin.x,
+                           plane.y >= 0.0f ? boundsMax.y : boundsMin.y,
+                           plane.z >= 0.0f ? boundsMax.z : boundsMin.z);
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool projectAabb(const glm::mat4& viewProjection, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                 glm::vec2& rectMin, glm::vec2& rectMax, float& nearestDepth) {
+    rectMin = glm::vec2(1.0f);
+    rectMax = glm::vec2(0.0f);
+    nearestDepth = 1.0f;
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec4 p = viewProjection * glm::vec4(corner & 1 ? boundsMax.x : boundsMin.x,
+                                                 corner & 2 ? boundsMax.y : boundsMin.y,
+                                                 corner & 4 ? boundsMax.z : boundsMin.z, 1.0f);
+        if (p.w <= 0.0f)
+            return false;
+        glm::vec3 ndc = glm::vec3(p) / p.w;
+        glm::vec2 window = glm::vec2(ndc.x, ndc.y) * 0.5f + 0.5f;
+        rectMin = glm::min(rectMin, window);
+        rectMax = glm::max(rectMax, window);
+        nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+    }
+    rectMin = glm::clamp(rectMin, glm::vec2(0.0f), glm::vec2(1.0f));
+    rectMax = glm::clamp(rectMax, glm::vec2(0.0f), glm::vec2(1.0f));
+    return true;
+}
+
+bool aabbOccluded(const OcclusionBuffer& occlusion, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    if (!occlusion.valid)
+        return false;
+
+    glm::vec2 rectMin, rectMax;
+    float nearestDepth;
+    if (!projectAabb(occlusion.viewProjection, boundsMin, boundsMax, rectMin, rectMax, nearestDepth))
+        return false;
+
+    int x0 = std::min(static_cast<int>(rectMin.x * occlusion.width), occlusion.width - 1);
+    int x1 = std::min(static_cast<int>(rectMax.x * occlusion.width), occlusion.width - 1);
+    int y0 = std::min(static_cast<int>(rectMin.y * occlusion.height), occlusion.height - 1);
+    int y1 = std::min(static_cast<int>(rectMax.y * occlusion.height), occlusion.height - 1);
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            if (nearestDepth <= occlusion.depth[y * occlusion.width + x])
+                return false;
+        }
+    }
+    return true;
+}
+
+void aabbDistanceRangeXZ(const glm::vec3& point, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                         float& nearest, float& farthest) {
+    glm::vec2 p(point.x, point.z);
+    glm::vec2 low(boundsMin.x, boundsMin.z);
+    glm::vec2 high(boundsMax.x, boundsMax.z);
+    nearest = glm::length(p - glm::clamp(p, low, high));
+    glm::vec2 far = glm::max(glm::abs(p - low), glm::abs(p - high));
+    farthest = glm::length(far);
+}
@@ -0,0 +1,118 @@
+#include <frame_arena.hpp>
+#include <memory_stats.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace {
+
+size_t alignUp(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+// Overflow blocks; MSVC has no std::aligned_alloc, and what _aligned_malloc
+// returns must go back through _aligned_free, so every block goes that way
+void* allocateBlock(size_t bytes, size_t alignment) {
+#ifdef _WIN32
+    return _aligned_malloc(std::max(bytes, size_t(1)), std::max(alignment, alignof(std::max_align_t)));
+#else
+    return alignment <= alignof(std::max_align_t)
+               ? std::malloc(std::max(bytes, size_t(1)))
+               : std::aligned_alloc(alignment, alignUp(std::max(bytes, size_t(1)), alignment));
+#endif
+}
+
+void freeBlock(void* block) {
+#ifdef _WIN32
+    _aligned_free(block);
+#else
+    std::free(block);
+#endif
+}
+
+unsigned char* allocateMainBlock(size_t capacity) {
+    void* block = allocateBlock(capacity, FRAME_ARENA_ALIGNMENT);
+    if (!block)
+        throw std::bad_alloc();
+    return static_cast<unsigned char*>(block);
+}
+
+} // namespace
+
+void FrameArenaBlockFree::operator()(unsigned char* block) const {
+    freeBlock(block);
+}
+
+void initFrameArena(FrameArena& arena, size_t capacity) {
+    arena.memory.reset(allocateMainBlock(capacity));
+    arena.capacity = capacity;
+    arena.used = 0;
+    arena.peak = 0;
+    arena.overflow.reserve(16);
+}
+
+void* arenaAllocate(FrameArena& arena, size_t bytes, size_t alignment) {
+    // the block itself is FRAME_ARENA_ALIGNMENT aligned, so aligned offsets
+    // are aligned addresses up to that
+    alignment = std::max(alignment, size_t(1));
+    size_t offset = alignUp(arena.used, alignment);
+    arena.peak += offset - arena.used + bytes;
+    if (alignment <= FRAME_ARENA_ALIGNMENT && offset + bytes <= arena.capacity) {
+        arena.used = offset + bytes;
+        return arena.memory.get() + offset;
+    }
+
+    void* block = allocateBlock(bytes, alignment);
+    if (!block)
+        throw std::bad_alloc();
+    arena.overflow.push_back(block);
+    return block;
+}
+
+void resetFrameArena(FrameArena& arena) {
+    for (void* block : arena.overflow)
+        freeBlock(block);
+    bool overflowed = !arena.overflow.empty();
+    arena.overflow.clear();
+    if (overflowed) {
+        // leave some headroom over the frame that did not fit
+        size_t capacity = alignUp(arena.peak + arena.peak / 2, 4096);
+        arena.memory.reset(allocateMainBlock(capacity));
+        arena.capacity = capacity;
+    }
+    arena.used = 0;
+    arena.peak = 0;
+}
+
+ArenaMark arenaMark(const FrameArena& arena) {
+    ArenaMark mark;
+    mark.used = arena.used;
+    mark.overflowBlocks = arena.overflow.size();
+    return mark;
+}
+
+void arenaRewind(FrameArena& arena, const ArenaMark& mark) {
+    while (arena.overflow.size() > mark.overflowBlocks) {
+        freeBlock(arena.overflow.back());
+        arena.overflow.pop_back();
+    }
+    arena.used = mark.used;
+}
+
+void deleteFrameArena(FrameArena& arena) {
+    resetFrameArena(arena);
+    arena.memory.reset();
+    arena.capacity = 0;
+}
+
+FrameArena& threadFrameArena() {
+    thread_local FrameArena arena;
+    if (!arena.memory)
+        initFrameArena(arena);
+    return arena;
+}
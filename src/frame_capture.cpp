@@ -0,0 +1,236 @@
+#include <frame_capture.hpp>
+#include <memory_stats.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+
+// The writer works through mapped slots oldest first; -1 when none is
+int oldestMappedSlot(const FrameCapture& capture) {
+    int oldest = -1;
+    for (int i = 0; i < CAPTURE_RING_SLOTS; ++i) {
+        const CaptureSlot& slot = capture.slots[i];
+        if (slot.state.load(std::memory_order_acquire) == CAPTURE_SLOT_MAPPED &&
+            (oldest < 0 || slot.frame < capture.slots[oldest].frame))
+            oldest = i;
+    }
+    return oldest;
+}
+
+// Runs of unchanged pixels and of new ones, see CaptureFrameHeader. A
+// demo frame mostly differs in a few spans (the minimap, agents), or
+// everywhere when the camera moves; either way this is one pass.
+void encodeDelta(const uint32_t* previous, const uint32_t* pixels, size_t count, std::vector<uint32_t>& encoded) {
+    encoded.clear();
+    size_t i = 0;
+    while (i < count) {
+        size_t start = i;
+        while (i < count && pixels[i] == previous[i])
+            ++i;
+        size_t changed = i;
+        while (i < count && pixels[i] != previous[i])
+            ++i;
+        encoded.push_back(static_cast<uint32_t>(changed - start));
+        encoded.push_back(static_cast<uint32_t>(i - changed));
+        encoded.insert(encoded.end(), pixels + changed, pixels + i);
+    }
+}
+
+void writeSlot(FrameCapture& capture, const CaptureSlot& slot) {
+    size_t count = static_cast<size_t>(slot.width) * slot.height;
+    const uint32_t* pixels = reinterpret_cast<const uint32_t*>(slot.pixels);
+
+    CaptureFrameHeader header;
+    header.width = slot.width;
+    header.height = slot.height;
+    header.frame = slot.frame;
+    bool keyframe = !capture.compress || capture.previous.size() != count ||
+                    capture.written.load() % capture.keyframeInterval == 0;
+    const uint32_t* payload = pixels;
+    size_t words = count;
+    if (!keyframe) {
+        encodeDelta(capture.previous.data(), pixels, count, capture.encoded);
+        header.encoding = CAPTURE_DELTA;
+        payload = capture.encoded.data();
+        words = capture.encoded.size();
+    }
+    header.bytes = words * sizeof(uint32_t);
+    bool ok = std::fwrite(&header, sizeof(header), 1, capture.file) == 1 &&
+              std::fwrite(payload, sizeof(uint32_t), words, capture.file) == words;
+    if (!ok)
+        std::cout << "ERROR::FRAME_CAPTURE::WRITE_FAILED frame " << slot.frame << std::endl;
+
+    if (capture.compress) {
+        capture.previous.assign(pixels, pixels + count);
+        reportCpuMemory(MEMORY_TARGETS, &capture.previous,
+                        (capture.previous.capacity() + capture.encoded.capacity()) * sizeof(uint32_t));
+    }
+    capture.written.fetch_add(1, std::memory_order_relaxed);
+    capture.bytesWritten.fetch_add(sizeof(header) + header.bytes, std::memory_order_relaxed);
+}
+
+void writerLoop(FrameCapture& capture) {
+    for (;;) {
+        int slot = -1;
+        {
+            std::unique_lock<std::mutex> lock(capture.mutex);
+            capture.wake.wait(lock, [&capture, &slot] {
+                slot = oldestMappedSlot(capture);
+                return slot >= 0 || capture.stopping;
+            });
+        }
+        if (slot < 0)
+            return; // stopping, and everything handed over is written
+        writeSlot(capture, capture.slots[slot]);
+        capture.slots[slot].state.store(CAPTURE_SLOT_WRITTEN, std::memory_order_release);
+    }
+}
+
+void mapSlot(FrameCapture& capture, CaptureSlot& slot) {
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    slot.pixels = static_cast<const uint8_t*>(glMapBufferRange(
+        GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(slot.width) * slot.height * 4, GL_MAP_READ_BIT));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!slot.pixels) {
+        std::cout << "ERROR::FRAME_CAPTURE::MAP_FAILED frame " << slot.frame << std::endl;
+        slot.state.store(CAPTURE_SLOT_FREE, std::memory_order_release);
+        ++capture.dropped;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(capture.mutex);
+        slot.state.store(CAPTURE_SLOT_MAPPED, std::memory_order_release);
+    }
+    capture.wake.notify_one();
+}
+
+// Hand finished readbacks to the writer in frame order (fences signal in
+// order, so the first unfinished one ends the pass) and unmap what the
+// writer is done with. `wait` blocks on the fences instead.
+void collectSlots(FrameCapture& capture, bool wait) {
+    for (int k = 0; k < CAPTURE_RING_SLOTS; ++k) {
+        CaptureSlot& slot = capture.slots[(capture.next + k) % CAPTURE_RING_SLOTS];
+        int state = slot.state.load(std::memory_order_acquire);
+        if (state == CAPTURE_SLOT_WRITTEN) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            slot.pixels = nullptr;
+            slot.state.store(CAPTURE_SLOT_FREE, std::memory_order_release);
+        }
+    }
+    for (int k = 0; k < CAPTURE_RING_SLOTS; ++k) {
+        CaptureSlot& slot = capture.slots[(capture.next + k) % CAPTURE_RING_SLOTS];
+        if (slot.state.load(std::memory_order_acquire) != CAPTURE_SLOT_READING)
+            continue;
+        GLuint64 timeout = wait ? GLuint64(1000000000) : 0;
+        GLenum status = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        mapSlot(capture, slot);
+    }
+}
+
+// Buffers for frames of `bytes`. Only happens with every slot free: on a
+// resize, frames are dropped until the ring has drained.
+bool resizeSlots(FrameCapture& capture, GLsizeiptr bytes) {
+    for (const CaptureSlot& slot : capture.slots)
+        if (slot.state.load(std::memory_order_acquire) != CAPTURE_SLOT_FREE)
+            return false;
+    for (CaptureSlot& slot : capture.slots) {
+        if (!slot.buffer)
+            glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        trackBufferMemory(MEMORY_TARGETS, slot.buffer, bytes);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    capture.slotBytes = bytes;
+    return true;
+}
+
+} // namespace
+
+bool startFrameCapture(FrameCapture& capture, const std::string& path, bool compress) {
+    capture.file = std::fopen(path.c_str(), "wb");
+    if (!capture.file) {
+        std::cout << "ERROR::FRAME_CAPTURE::FILE_NOT_OPENED " << path << std::endl;
+        return false;
+    }
+    // large sequential writes; the stdio buffer only batches the headers
+    std::setvbuf(capture.file, nullptr, _IOFBF, 1 << 20);
+    capture.path = path;
+    capture.compress = compress;
+    capture.stopping = false;
+    capture.active = true;
+    capture.writer = std::thread(writerLoop, std::ref(capture));
+    return true;
+}
+
+void captureFrame(FrameCapture& capture, GLuint framebuffer, int width, int height) {
+    if (!capture.active || width <= 0 || height <= 0)
+        return;
+    auto start = std::chrono::steady_clock::now();
+    collectSlots(capture, false);
+
+    uint64_t frame = capture.offered++;
+    GLsizeiptr bytes = static_cast<GLsizeiptr>(width) * height * 4;
+    CaptureSlot& slot = capture.slots[capture.next];
+    if ((bytes > capture.slotBytes && !resizeSlots(capture, bytes)) ||
+        slot.state.load(std::memory_order_acquire) != CAPTURE_SLOT_FREE) {
+        ++capture.dropped; // the GPU or the disk is behind
+    } else {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        if (framebuffer == 0)
+            glReadBuffer(GL_BACK);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot.width = width;
+        slot.height = height;
+        slot.frame = frame;
+        slot.state.store(CAPTURE_SLOT_READING, std::memory_order_release);
+        capture.next = (capture.next + 1) % CAPTURE_RING_SLOTS;
+    }
+    capture.readbackMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void stopFrameCapture(FrameCapture& capture) {
+    if (!capture.active)
+        return;
+    collectSlots(capture, true);
+    {
+        std::lock_guard<std::mutex> lock(capture.mutex);
+        capture.stopping = true;
+    }
+    capture.wake.notify_one();
+    capture.writer.join();
+    collectSlots(capture, false);
+
+    for (CaptureSlot& slot : capture.slots) {
+        if (slot.fence) // a readback that never finished
+            glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        slot.state.store(CAPTURE_SLOT_FREE, std::memory_order_relaxed);
+        untrackBufferMemory(slot.buffer);
+        glDeleteBuffers(1, &slot.buffer);
+        slot.buffer = 0;
+    }
+    forgetCpuMemory(&capture.previous);
+    std::fclose(capture.file);
+    capture.file = nullptr;
+    capture.active = false;
+
+    uint64_t written = capture.written.load();
+    std::printf("Capture: %llu frames written to %s (%.1f MB), %llu dropped, %.3f ms per frame on the render thread\n",
+                static_cast<unsigned long long>(written), capture.path.c_str(),
+                capture.bytesWritten.load() / (1024.0 * 1024.0), static_cast<unsigned long long>(capture.dropped),
+                capture.offered ? capture.readbackMs / capture.offered : 0.0);
+}
@@ -0,0 +1,190 @@
+#include <gpu_culling.hpp>
+#include <memory_stats.hpp>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <vector>
+
+namespace {
+
+// Mirrors ChunkInfo in shaders/cull_chunks.comp (std430)
+struct GpuChunkInfo {
+    glm::vec4 boundsMin;
+    glm::vec4 boundsMax;
+    GLuint indexCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint hasWalls;
+};
+
+// Layout fixed by the GL spec for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+const GLuint cullGroupSize = 64;
+
+// Mirrors the Stats block in shaders/cull_chunks.comp
+struct GpuCullStats {
+    GLuint frustumRejected;
+    GLuint occlusionRejected;
+    GLuint drawn;
+    GLuint impostors;
+};
+
+} // namespace
+
+void readGpuCullStats(GpuCuller& culler, CullStats& stats) {
+    for (;;) {
+        GLsync& fence = culler.statsFences[culler.statsRead];
+        if (!fence || glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return;
+        glDeleteSync(fence);
+        fence = nullptr;
+
+        GpuCullStats counters;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, culler.statsBuffers[culler.statsRead]);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counters), &counters);
+        stats.chunks = culler.nonEmptyChunks;
+        stats.frustumRejected = counters.frustumRejected;
+        stats.occlusionRejected = counters.occlusionRejected;
+        stats.drawn = counters.drawn;
+        stats.impostors = counters.impostors;
+        culler.statsRead = (culler.statsRead + 1) % CULL_STATS_SLOTS;
+    }
+}
+
+bool gpuCullingSupported() {
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+bool initGpuCuller(GpuCuller& culler, const MazeMesh& mesh) {
+    culler.program.stages = {{GL_COMPUTE_SHADER, shaderPath("cull_chunks.comp")}};
+    if (!buildShaderProgram(culler.program))
+        return false;
+
+    glGenBuffers(1, &culler.chunkBuffer);
+    glGenBuffers(1, &culler.commandBuffer);
+    glGenBuffers(CULL_STATS_SLOTS, culler.statsBuffers);
+    for (GLuint buffer : culler.statsBuffers) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GpuCullStats), nullptr, GL_DYNAMIC_READ);
+        trackBufferMemory(MEMORY_CULLING, buffer, sizeof(GpuCullStats));
+    }
+    updateGpuCullerChunks(culler, mesh);
+    return true;
+}
+
+void updateGpuCullerChunks(GpuCuller& culler, const MazeMesh& mesh) {
+    std::vector<GpuChunkInfo> infos;
+    infos.reserve(mesh.chunks.size());
+    for (const MazeChunk& chunk : mesh.chunks) {
+        GpuChunkInfo info;
+        info.boundsMin = glm::vec4(chunk.boundsMin, 0.0f);
+        info.boundsMax = glm::vec4(chunk.boundsMax, 0.0f);
+        info.indexCount = chunk.indexCount;
+        info.firstIndex = chunk.firstIndex;
+        info.baseVertex = chunk.baseVertex;
+        info.hasWalls = chunk.state == CHUNK_RESIDENT || chunk.state == CHUNK_EVICTED;
+        infos.push_back(info);
+    }
+    culler.chunkCount = static_cast<GLsizei>(infos.size());
+    culler.nonEmptyChunks = mesh.nonEmptyChunks;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culler.chunkBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, infos.size() * sizeof(GpuChunkInfo), infos.data(), GL_STATIC_DRAW);
+    trackBufferMemory(MEMORY_CULLING, culler.chunkBuffer, infos.size() * sizeof(GpuChunkInfo));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, culler.commandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, infos.size() * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+    trackBufferMemory(MEMORY_CULLING, culler.commandBuffer, infos.size() * sizeof(DrawElementsIndirectCommand));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void dispatchGpuCulling(GpuCuller& culler, const Frustum& frustum, const HiZPyramid* hiz, const LodSettings& lod,
+                        const glm::vec3& cameraPosition, ChunkImpostors* impostors) {
+    if (culler.chunkCount == 0)
+        return;
+
+    // skip counting this frame if every stats slot is still in flight
+    bool recordStats = culler.statsFences[culler.statsWrite] == nullptr;
+    GLuint statsBuffer = culler.statsBuffers[culler.statsWrite];
+    if (recordStats) {
+        GpuCullStats zero = {0, 0, 0, 0};
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, statsBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+    }
+
+    GLuint program = culler.program.id;
+    glUseProgram(program);
+    glUniform4fv(glGetUniformLocation(program, "frustumPlanes"), 6, &frustum.planes[0].x);
+    glUniform1ui(glGetUniformLocation(program, "chunkCount"), culler.chunkCount);
+
+    bool useHiZ = hiz && hiz->valid;
+    glUniform1i(glGetUniformLocation(program, "useHiZ"), useHiZ);
+    if (useHiZ) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, hiz->texture);
+        glUniform1i(glGetUniformLocation(program, "hiZ"), 0);
+        glUniform1i(glGetUniformLocation(program, "hiZLevels"), hiz->levels);
+        glUniformMatrix4fv(glGetUniformLocation(program, "hiZViewProjection"), 1, GL_FALSE,
+                           glm::value_ptr(hiz->viewProjection));
+    }
+
+    bool useImpostors = impostors && lod.impostors;
+    glUniform1i(glGetUniformLocation(program, "useImpostors"), useImpostors);
+    glUniform2f(glGetUniformLocation(program, "cameraXZ"), cameraPosition.x, cameraPosition.z);
+    glUniform1f(glGetUniformLocation(program, "impostorStart"), lod.impostorStart);
+    glUniform1f(glGetUniformLocation(program, "impostorEnd"), lod.impostorEnd);
+    if (useImpostors) {
+        // count, instanceCount, first, baseInstance; instances are appended
+        const GLuint command[4] = {IMPOSTOR_VERTICES, 0, 0, 0};
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, impostors->indirectBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(command), command);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, impostors->instanceBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, impostors->indirectBuffer);
+    }
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, culler.chunkBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, culler.commandBuffer);
+    // an unrecorded frame still needs somewhere for the atomics to land
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, statsBuffer);
+    glDispatchCompute((culler.chunkCount + cullGroupSize - 1) / cullGroupSize, 1, 1);
+
+    // commands are consumed as indirect parameters, the impostor list as an
+    // instanced vertex attribute, the counters by glGetBufferSubData
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    if (recordStats) {
+        culler.statsFences[culler.statsWrite] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        culler.statsWrite = (culler.statsWrite + 1) % CULL_STATS_SLOTS;
+    }
+}
+
+void drawGpuCulledChunks(GpuCuller& culler, const MazeMesh& mesh) {
+    glBindVertexArray(mesh.vao);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler.commandBuffer);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, culler.chunkCount, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void deleteGpuCuller(GpuCuller& culler) {
+    deleteShaderProgram(culler.program);
+    untrackBufferMemory(culler.chunkBuffer);
+    untrackBufferMemory(culler.commandBuffer);
+    for (GLuint buffer : culler.statsBuffers)
+        untrackBufferMemory(buffer);
+    glDeleteBuffers(1, &culler.chunkBuffer);
+    glDeleteBuffers(1, &culler.commandBuffer);
+    for (int i = 0; i < CULL_STATS_SLOTS; ++i) {
+        if (culler.statsFences[i])
+            glDeleteSync(culler.statsFences[i]);
+        culler.statsFences[i] = nullptr;
+    }
+    glDeleteBuffers(CULL_STATS_SLOTS, culler.statsBuffers);
+    culler.chunkBuffer = culler.commandBuffer = 0;
+    culler.chunkCount = 0;
+}
@@ -0,0 +1,349 @@
+#include <headless.hpp>
+#include <agents.hpp>
+#include <culling.hpp>
+#include <image_write.hpp>
+#include <jobs.hpp>
+#include <maze.hpp>
+#include <raycast_renderer.hpp>
+#include <render_target.hpp>
+
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Frames drawn at the first camera position while chunks, textures and
+// shadow tiles stream in; none of them is timed or compared
+const int MAX_WARMUP_FRAMES = 2000;
+
+// Simulated time per frame, so agents are in the same place in every run
+const float FRAME_STEP = 1.0f / 60.0f;
+
+// The camera faces the point this many cells further down the path, which
+// rounds off the corners
+const float LOOK_AHEAD = 1.5f;
+
+// Agents are placed as in the interactive run
+const uint32_t AGENT_SEED = 4321u;
+
+// Cell centres from (1, 1), where generateMaze starts carving, to the open
+// cell farthest from it along the corridors
+std::vector<glm::vec3> buildCameraPath(const MazeGrid& maze) {
+    int rows = static_cast<int>(maze.size());
+    int cols = rows ? static_cast<int>(maze[0].size()) : 0;
+    if (rows < 3 || cols < 3 || maze[1][1] != 0)
+        return {glm::vec3(0.0f)};
+
+    std::vector<int> parent(static_cast<size_t>(rows) * cols, -1);
+    std::queue<int> open;
+    int start = cols + 1, last = start;
+    parent[start] = start;
+    open.push(start);
+    while (!open.empty()) {
+        last = open.front();
+        open.pop();
+        int row = last / cols, col = last % cols;
+        const int steps[4][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
+        for (const auto& step : steps) {
+            int r = row + step[0], c = col + step[1];
+            if (r < 0 || r >= rows || c < 0 || c >= cols || maze[r][c] != 0 || parent[r * cols + c] >= 0)
+                continue;
+            parent[r * cols + c] = last;
+            open.push(r * cols + c);
+        }
+    }
+
+    std::vector<glm::vec3> path;
+    for (int cell = last;; cell = parent[cell]) {
+        path.push_back(mazeCellPosition(cell / cols, cell % cols, rows, cols));
+        if (cell == start)
+            break;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+glm::vec3 pointOnPath(const std::vector<glm::vec3>& path, float s) {
+    if (path.size() < 2)
+        return path.front();
+    s = std::clamp(s, 0.0f, static_cast<float>(path.size() - 1));
+    size_t i = std::min(static_cast<size_t>(s), path.size() - 2);
+    return glm::mix(path[i], path[i + 1], s - static_cast<float>(i));
+}
+
+// Camera for frame `frame` of `frames`, moving at constant speed from one end
+// of the path to the other
+void cameraOnPath(const std::vector<glm::vec3>& path, int frame, int frames, glm::vec3& position, glm::vec3& front) {
+    float s = frames > 1 ? static_cast<float>(path.size() - 1) * frame / (frames - 1) : 0.0f;
+    position = pointOnPath(path, s);
+    glm::vec3 ahead = pointOnPath(path, s + LOOK_AHEAD) - position;
+    if (glm::length(ahead) < 1e-4f) // the end of the path: keep facing the same way
+        ahead = position - pointOnPath(path, s - LOOK_AHEAD);
+    front = glm::length(ahead) > 1e-4f ? glm::normalize(ahead) : glm::vec3(0.0f, 0.0f, -1.0f);
+}
+
+std::string framePath(const std::string& directory, int frame) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/frame_%04d.png", frame);
+    return directory + name;
+}
+
+// Fraction of pixels that differ by more than the tolerance in any channel;
+// `pixels` may be bottom row first, the reference never is
+bool matchesReference(const HeadlessSettings& settings, int frame, const uint8_t* pixels, bool bottomUp) {
+    std::string path = framePath(settings.referenceDirectory, frame);
+    int width = 0, height = 0, channels = 0;
+    stbi_uc* reference = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (!reference) {
+        std::cout << "ERROR::HEADLESS::NO_REFERENCE " << path << std::endl;
+        return false;
+    }
+    if (width != settings.width || height != settings.height) {
+        std::cout << "ERROR::HEADLESS::REFERENCE_SIZE " << path << " is " << width << "x" << height << std::endl;
+        stbi_image_free(reference);
+        return false;
+    }
+
+    size_t rowBytes = static_cast<size_t>(width) * 4, different = 0;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = pixels + static_cast<size_t>(bottomUp ? height - 1 - y : y) * rowBytes;
+        const uint8_t* expected = reference + static_cast<size_t>(y) * rowBytes;
+        for (size_t x = 0; x < rowBytes; x += 4) {
+            bool differs = false;
+            for (int c = 0; c < 4; ++c)
+                differs |= std::abs(row[x + c] - expected[x + c]) > settings.pixelTolerance;
+            different += differs;
+        }
+    }
+    stbi_image_free(reference);
+
+    float fraction = static_cast<float>(different) / (static_cast<float>(width) * height);
+    if (fraction > settings.maxDifferentPixels) {
+        std::cout << "ERROR::HEADLESS::IMAGE_MISMATCH frame " << frame << ": " << fraction * 100.0f
+                  << "% of the pixels differ" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Write and compare one finished frame; false when either failed
+bool checkFrame(const HeadlessSettings& settings, int frame, const uint8_t* pixels, bool bottomUp) {
+    bool passed = true;
+    if (!settings.outputDirectory.empty())
+        passed = writePng(framePath(settings.outputDirectory, frame), settings.width, settings.height, pixels,
+                          bottomUp);
+    if (!settings.referenceDirectory.empty())
+        passed = matchesReference(settings, frame, pixels, bottomUp) && passed;
+    return passed;
+}
+
+glm::mat4 headlessProjection(const HeadlessSettings& settings, const RenderSettings& renderSettings) {
+    return glm::perspective(glm::radians(45.0f), static_cast<float>(settings.width) / settings.height, 0.1f,
+                            renderSettings.lod.fogEnd);
+}
+
+// A context without a visible window. GLFW's null platform (3.4 and later)
+// needs no display server at all; the context comes from EGL, which Mesa
+// runs surfaceless, or from OSMesa.
+GLFWwindow* createHeadlessContext(bool osmesa) {
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+    if (!glfwInit()) {
+        std::cout << "ERROR::HEADLESS::GLFW_INIT_FAILED" << std::endl;
+        return nullptr;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, osmesa ? GLFW_OSMESA_CONTEXT_API : GLFW_EGL_CONTEXT_API);
+
+    // frames go to a framebuffer of our own, so the window size is irrelevant
+    GLFWwindow* window = nullptr;
+    const int contextVersions[][2] = {{4, 3}, {3, 3}};
+    for (const auto& version : contextVersions) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+        window = glfwCreateWindow(64, 64, "headless", nullptr, nullptr);
+        if (window != nullptr)
+            break;
+    }
+    if (window == nullptr) {
+        std::cout << "ERROR::HEADLESS::NO_CONTEXT " << (osmesa ? "OSMesa" : "EGL") << std::endl;
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+    std::cout << "Headless context: " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+    return window;
+}
+
+using FrameCallback = std::function<void(int frame, double ms, const uint8_t* pixels, bool bottomUp)>;
+
+bool renderWithGl(const HeadlessSettings& settings, const RenderSettings& renderSettings, const MazeGrid& maze,
+                  const std::vector<glm::vec3>& path, JobSystem& jobs, const FrameCallback& finished) {
+    GLFWwindow* window = createHeadlessContext(settings.osmesa);
+    if (!window)
+        return false;
+
+    Renderer renderer;
+    RenderTarget output;
+    if (!initRenderer(renderer, maze, renderSettings, &jobs) ||
+        !resizeRenderTarget(output, settings.width, settings.height)) {
+        glfwTerminate();
+        return false;
+    }
+    renderer.outputFramebuffer = output.fbo;
+    AgentSystem agents;
+    initAgents(agents, renderer.mazeBits, settings.agentCount, AGENT_SEED, &jobs);
+
+    RenderSnapshot snapshot;
+    snapshot.projection = headlessProjection(settings, renderSettings);
+    snapshot.framebufferWidth = settings.width;
+    snapshot.framebufferHeight = settings.height;
+    auto prepareFrame = [&](int frame) {
+        cameraOnPath(path, frame, settings.frames, snapshot.cameraPos, snapshot.cameraFront);
+        snapshot.tick = static_cast<uint64_t>(frame) + 1;
+        snapshot.time = frame * FRAME_STEP;
+        snapshot.view = glm::lookAt(snapshot.cameraPos, snapshot.cameraPos + snapshot.cameraFront,
+                                    glm::vec3(0.0f, 1.0f, 0.0f));
+        snapshot.meshChunks.clear();
+        snapshot.impostorChunks.clear();
+        snapshot.cullStats = CullStats();
+        if (rendererWantsChunkLists(renderer))
+            cullMazeChunks(renderer.mazeMesh, extractFrustum(snapshot.projection * snapshot.view),
+                           renderer.settings.lod, snapshot.cameraPos, snapshot.meshChunks, snapshot.impostorChunks,
+                           snapshot.cullStats);
+        writeAgentInstances(agents, snapshot.agents);
+    };
+
+    // stream everything in first, so the timed frames and the images do not
+    // depend on how fast that went
+    prepareFrame(0);
+    int warmup = 0;
+    for (; warmup < MAX_WARMUP_FRAMES && !rendererSettled(renderer); ++warmup)
+        renderFrame(renderer, snapshot);
+    if (!rendererSettled(renderer))
+        std::cout << "Headless: still streaming after " << warmup << " warm-up frames" << std::endl;
+    glFinish();
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(settings.width) * settings.height * 4);
+    for (int frame = 0; frame < settings.frames; ++frame) {
+        if (frame > 0)
+            updateAgents(agents, FRAME_STEP);
+        prepareFrame(frame);
+
+        // glFinish so the time covers the GPU's (or the rasterizer's) work too
+        Clock::time_point start = Clock::now();
+        renderFrame(renderer, snapshot);
+        glFinish();
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, output.fbo);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, settings.width, settings.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        finished(frame, ms, pixels.data(), true);
+    }
+
+    deleteRenderTarget(output);
+    deleteRenderer(renderer);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return true;
+}
+
+// No GL at all: the raycaster's framebuffer is the image
+bool renderWithRaycaster(const HeadlessSettings& settings, const RenderSettings& renderSettings,
+                         const MazeGrid& maze, const std::vector<glm::vec3>& path, JobSystem& jobs,
+                         const FrameCallback& finished) {
+    MazeBits bits;
+    packMaze(maze, bits);
+    RaycastRenderer raycaster;
+    initRaycastRenderer(raycaster, bits, renderSettings.lod, &jobs);
+    glm::mat4 projection = headlessProjection(settings, renderSettings);
+
+    for (int frame = 0; frame < settings.frames; ++frame) {
+        glm::vec3 position, front;
+        cameraOnPath(path, frame, settings.frames, position, front);
+        Clock::time_point start = Clock::now();
+        drawRaycastFrame(raycaster, position, front, projection, settings.width, settings.height);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        finished(frame, ms, reinterpret_cast<const uint8_t*>(raycaster.pixels.data()), false);
+    }
+    deleteRaycastRenderer(raycaster);
+    return true;
+}
+
+} // namespace
+
+int runHeadless(const HeadlessSettings& settings, const RenderSettings& renderSettings, int jobWorkers) {
+    MazeGrid maze;
+    generateMaze(maze, settings.mazeSize, settings.mazeSize, settings.seed);
+    std::vector<glm::vec3> path = buildCameraPath(maze);
+    JobSystem jobs;
+    initJobSystem(jobs, jobWorkers);
+
+    std::vector<double> frameMs;
+    frameMs.reserve(settings.frames);
+    bool imagesPassed = true;
+    FrameCallback finished = [&](int frame, double ms, const uint8_t* pixels, bool bottomUp) {
+        frameMs.push_back(ms);
+        imagesPassed = checkFrame(settings, frame, pixels, bottomUp) && imagesPassed;
+    };
+    bool rendered = renderSettings.cpuRaycast
+                        ? renderWithRaycaster(settings, renderSettings, maze, path, jobs, finished)
+                        : renderWithGl(settings, renderSettings, maze, path, jobs, finished);
+    deleteJobSystem(jobs);
+    if (!rendered)
+        return 1;
+
+    if (!settings.timingsFile.empty()) {
+        std::ofstream file(settings.timingsFile);
+        file << "frame,ms\n";
+        for (size_t i = 0; i < frameMs.size(); ++i)
+            file << i << "," << frameMs[i] << "\n";
+        if (!file)
+            std::cout << "ERROR::HEADLESS::FILE_NOT_WRITTEN " << settings.timingsFile << std::endl;
+    }
+
+    double average = 0.0, worst = 0.0, p95 = 0.0;
+    if (!frameMs.empty()) {
+        for (double ms : frameMs)
+            average += ms;
+        average /= frameMs.size();
+        std::vector<double> sorted = frameMs;
+        std::sort(sorted.begin(), sorted.end());
+        worst = sorted.back();
+        p95 = sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)];
+    }
+    std::printf("Headless: %d frames at %dx%d, %.3f ms average, %.3f ms p95, %.3f ms worst\n", settings.frames,
+                settings.width, settings.height, average, p95, worst);
+
+    bool fastEnough = settings.maxAverageMs <= 0.0f || average <= settings.maxAverageMs;
+    if (!fastEnough)
+        std::cout << "ERROR::HEADLESS::FRAME_TIME " << average << " ms average, the limit is "
+                  << settings.maxAverageMs << " ms" << std::endl;
+    if (imagesPassed && !settings.referenceDirectory.empty())
+        std::cout << "Headless: every frame matches " << settings.referenceDirectory << std::endl;
+    return imagesPassed && fastEnough ? 0 : 1;
+}
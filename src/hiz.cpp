@@ -0,0 +1,165 @@
+#include <hiz.hpp>
+#include <memory_stats.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+int levelSize(int size, int level) {
+    return std::max(1, size >> level);
+}
+
+void resizeHiZ(HiZPyramid& hiz, int width, int height) {
+    if (hiz.width == width && hiz.height == height)
+        return;
+    hiz.width = width;
+    hiz.height = height;
+    hiz.levels = 1;
+    while ((std::max(width, height) >> hiz.levels) > 0)
+        ++hiz.levels;
+    hiz.readbackLevel = 0;
+    while (levelSize(width, hiz.readbackLevel) > HIZ_READBACK_WIDTH && hiz.readbackLevel + 1 < hiz.levels)
+        ++hiz.readbackLevel;
+
+    glBindTexture(GL_TEXTURE_2D, hiz.texture);
+    size_t bytes = 0;
+    for (int level = 0; level < hiz.levels; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, levelSize(width, level), levelSize(height, level), 0,
+                     GL_RED, GL_FLOAT, nullptr);
+        bytes += static_cast<size_t>(levelSize(width, level)) * levelSize(height, level) * texelBytes(GL_R32F);
+    }
+    trackTextureMemory(MEMORY_TARGETS, hiz.texture, bytes);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, hiz.levels - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    hiz.valid = false;
+}
+
+} // namespace
+
+bool initHiZ(HiZPyramid& hiz) {
+    hiz.copyProgram.stages = {{GL_VERTEX_SHADER, shaderPath("fullscreen.vert")},
+                              {GL_FRAGMENT_SHADER, shaderPath("hiz_copy.frag")}};
+    hiz.downsampleProgram.stages = {{GL_VERTEX_SHADER, shaderPath("fullscreen.vert")},
+                                    {GL_FRAGMENT_SHADER, shaderPath("hiz_downsample.frag")}};
+    if (!buildShaderProgram(hiz.copyProgram) || !buildShaderProgram(hiz.downsampleProgram))
+        return false;
+
+    glGenTextures(1, &hiz.texture);
+    glGenFramebuffers(1, &hiz.fbo);
+    glGenVertexArrays(1, &hiz.emptyVao);
+    for (HiZReadback& readback : hiz.readbacks)
+        glGenBuffers(1, &readback.pbo);
+    return true;
+}
+
+void buildHiZ(HiZPyramid& hiz, const RenderTarget& scene, const glm::mat4& viewProjection) {
+    resizeHiZ(hiz, scene.width, scene.height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, hiz.fbo);
+    glBindVertexArray(hiz.emptyVao);
+    glDisable(GL_DEPTH_TEST);
+    glActiveTexture(GL_TEXTURE0);
+
+    // level 0: copy of the scene depth
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, hiz.texture, 0);
+    glViewport(0, 0, hiz.width, hiz.height);
+    glUseProgram(hiz.copyProgram.id);
+    glUniform1i(glGetUniformLocation(hiz.copyProgram.id, "sceneDepth"), 0);
+    glBindTexture(GL_TEXTURE_2D, scene.depthTexture);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // every other level reads the one above it; restricting base/max level to
+    // the source keeps the level being rendered out of the sampled range
+    glUseProgram(hiz.downsampleProgram.id);
+    glUniform1i(glGetUniformLocation(hiz.downsampleProgram.id, "previousLevel"), 0);
+    GLint previousSizeLoc = glGetUniformLocation(hiz.downsampleProgram.id, "previousSize");
+    glBindTexture(GL_TEXTURE_2D, hiz.texture);
+    for (int level = 1; level < hiz.levels; ++level) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, hiz.texture, level);
+        glViewport(0, 0, levelSize(hiz.width, level), levelSize(hiz.height, level));
+        glUniform2i(previousSizeLoc, levelSize(hiz.width, level - 1), levelSize(hiz.height, level - 1));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, hiz.levels - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glEnable(GL_DEPTH_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    hiz.viewProjection = viewProjection;
+    hiz.valid = true;
+}
+
+void requestHiZReadback(HiZPyramid& hiz) {
+    HiZReadback& slot = hiz.readbacks[hiz.readbackWrite];
+    if (!hiz.valid || slot.fence)
+        return; // ring full: the GPU is behind, skip rather than wait
+
+    int width = levelSize(hiz.width, hiz.readbackLevel);
+    int height = levelSize(hiz.height, hiz.readbackLevel);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, width * height * sizeof(float), nullptr, GL_STREAM_READ);
+    trackBufferMemory(MEMORY_TARGETS, slot.pbo, width * height * sizeof(float));
+    glBindTexture(GL_TEXTURE_2D, hiz.texture);
+    glGetTexImage(GL_TEXTURE_2D, hiz.readbackLevel, GL_RED, GL_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = width;
+    slot.height = height;
+    slot.viewProjection = hiz.viewProjection;
+    hiz.readbackWrite = (hiz.readbackWrite + 1) % HIZ_READBACK_SLOTS;
+}
+
+void pollHiZReadback(HiZPyramid& hiz, OcclusionBuffer& occlusion) {
+    for (;;) {
+        HiZReadback& slot = hiz.readbacks[hiz.readbackRead];
+        if (!slot.fence || glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return;
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        hiz.readbackRead = (hiz.readbackRead + 1) % HIZ_READBACK_SLOTS;
+
+        int width = slot.width, height = slot.height;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, width * height * sizeof(float), GL_MAP_READ_BIT);
+        if (data) {
+            occlusion.depth.resize(width * height);
+            std::memcpy(occlusion.depth.data(), data, occlusion.depth.size() * sizeof(float));
+            occlusion.width = width;
+            occlusion.height = height;
+            occlusion.viewProjection = slot.viewProjection;
+            occlusion.valid = true;
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+void deleteHiZ(HiZPyramid& hiz) {
+    for (HiZReadback& readback : hiz.readbacks) {
+        if (readback.fence)
+            glDeleteSync(readback.fence);
+        untrackBufferMemory(readback.pbo);
+        glDeleteBuffers(1, &readback.pbo);
+        readback = HiZReadback();
+    }
+    deleteShaderProgram(hiz.copyProgram);
+    deleteShaderProgram(hiz.downsampleProgram);
+    untrackTextureMemory(hiz.texture);
+    glDeleteTextures(1, &hiz.texture);
+    glDeleteFramebuffers(1, &hiz.fbo);
+    glDeleteVertexArrays(1, &hiz.emptyVao);
+    hiz.texture = hiz.fbo = hiz.emptyVao = 0;
+    hiz.width = hiz.height = hiz.levels = 0;
+    hiz.valid = false;
+}
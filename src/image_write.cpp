@@ -0,0 +1,20 @@
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <image_write.hpp>
+
+#include <iostream>
+
+bool writePng(const std::string& path, int width, int height, const void* rgba, bool bottomUp) {
+    // a negative stride walks the rows from the last one up, so bottom-up
+    // data needs no flipped copy
+    const int stride = width * 4;
+    const unsigned char* first = static_cast<const unsigned char*>(rgba);
+    if (bottomUp)
+        first += static_cast<size_t>(height - 1) * stride;
+    if (!stbi_write_png(path.c_str(), width, height, 4, first, bottomUp ? -stride : stride)) {
+        std::cout << "ERROR::IMAGE::PNG_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,96 @@
+#include <impostors.hpp>
+#include <memory_stats.hpp>
+#include <maze_texture.hpp>
+
+namespace {
+
+void setChunkUniforms(GLuint program, const MazeMesh& mesh) {
+    glUniform1i(glGetUniformLocation(program, "chunkSize"), CHUNK_SIZE);
+    glUniform1i(glGetUniformLocation(program, "chunksX"), mesh.chunksX);
+    glUniform1f(glGetUniformLocation(program, "wallBottom"), WALL_BOTTOM);
+    glUniform1f(glGetUniformLocation(program, "wallTop"), WALL_TOP);
+}
+
+} // namespace
+
+bool initChunkImpostors(ChunkImpostors& impostors, const MazeMesh& mesh) {
+    impostors.program.stages = {{GL_VERTEX_SHADER, shaderPath("impostor.vert")},
+                                {GL_FRAGMENT_SHADER, shaderPath("impostor.frag")}};
+    if (!buildShaderProgram(impostors.program))
+        return false;
+
+    impostors.capacity = static_cast<GLsizei>(mesh.chunks.size());
+    glGenVertexArrays(1, &impostors.vao);
+    glGenBuffers(1, &impostors.instanceBuffer);
+    glGenBuffers(1, &impostors.indirectBuffer);
+
+    glBindVertexArray(impostors.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, impostors.instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, impostors.capacity * sizeof(GLuint), nullptr, GL_STREAM_DRAW);
+    trackBufferMemory(MEMORY_CULLING, impostors.instanceBuffer, impostors.capacity * sizeof(GLuint));
+    glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void *) 0);
+    glVertexAttribDivisor(0, 1);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    // count, instanceCount, first, baseInstance
+    const GLuint command[4] = {IMPOSTOR_VERTICES, 0, 0, 0};
+    glBindBuffer(GL_ARRAY_BUFFER, impostors.indirectBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(command), command, GL_DYNAMIC_COPY);
+    trackBufferMemory(MEMORY_CULLING, impostors.indirectBuffer, sizeof(command));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void drawChunkImpostors(ChunkImpostors& impostors, const MazeMesh& mesh, const std::vector<GLuint>& chunks,
+                        GLuint bitsTexture, const MazeBits& bits) {
+    if (chunks.empty())
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, impostors.instanceBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, chunks.size() * sizeof(GLuint), chunks.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glUseProgram(impostors.program.id);
+    bindMazeBitsTexture(impostors.program.id, bitsTexture, bits, 0);
+    setChunkUniforms(impostors.program.id, mesh);
+    glEnable(GL_CULL_FACE);
+    glBindVertexArray(impostors.vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, IMPOSTOR_VERTICES, static_cast<GLsizei>(chunks.size()));
+    glDisable(GL_CULL_FACE);
+}
+
+void drawChunkImpostorsIndirect(ChunkImpostors& impostors, const MazeMesh& mesh, GLuint bitsTexture,
+                                const MazeBits& bits) {
+    glUseProgram(impostors.program.id);
+    bindMazeBitsTexture(impostors.program.id, bitsTexture, bits, 0);
+    setChunkUniforms(impostors.program.id, mesh);
+    glEnable(GL_CULL_FACE);
+    glBindVertexArray(impostors.vao);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, impostors.indirectBuffer);
+    glDrawArraysIndirect(GL_TRIANGLES, nullptr);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glDisable(GL_CULL_FACE);
+}
+
+void setLodUniforms(GLuint program, const LodSettings& lod, const glm::vec3& cameraPosition, bool fade) {
+    glUniform3f(glGetUniformLocation(program, "cameraPosition"), cameraPosition.x, cameraPosition.y, cameraPosition.z);
+    glUniform3f(glGetUniformLocation(program, "fogColor"), lod.fogColor.x, lod.fogColor.y, lod.fogColor.z);
+    glUniform1f(glGetUniformLocation(program, "fogStart"), lod.fogStart);
+    glUniform1f(glGetUniformLocation(program, "fogEnd"), lod.fogEnd);
+    // smoothstep needs lodStart < lodEnd, so "never" is a band far away
+    bool impostors = fade && lod.impostors;
+    glUniform1f(glGetUniformLocation(program, "lodStart"), impostors ? lod.impostorStart : 1e9f);
+    glUniform1f(glGetUniformLocation(program, "lodEnd"), impostors ? lod.impostorEnd : 2e9f);
+}
+
+void deleteChunkImpostors(ChunkImpostors& impostors) {
+    deleteShaderProgram(impostors.program);
+    glDeleteVertexArrays(1, &impostors.vao);
+    untrackBufferMemory(impostors.instanceBuffer);
+    untrackBufferMemory(impostors.indirectBuffer);
+    glDeleteBuffers(1, &impostors.instanceBuffer);
+    glDeleteBuffers(1, &impostors.indirectBuffer);
+    impostors.vao = impostors.instanceBuffer = impostors.indirectBuffer = 0;
+    impostors.capacity = 0;
+}
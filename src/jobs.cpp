@@ -0,0 +1,311 @@
+#include <jobs.hpp>
+#include <frame_arena.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+// Which queue the calling thread owns; 0 for threads that are not workers
+thread_local const JobSystem* currentSystem = nullptr;
+thread_local int currentQueue = 0;
+
+int queueOfCaller(const JobSystem& jobs) {
+    return currentSystem == &jobs ? currentQueue : 0;
+}
+
+// Freed blocks of one size, shared by every thread: a job is often released
+// by a different thread than the one that created it
+struct FreeList {
+    std::mutex mutex;
+    std::vector<void*> blocks;
+};
+
+// Allocator for allocate_shared, so a job and its control block come from
+// (and go back to) a free list instead of the heap
+template <typename T>
+struct JobPoolAllocator {
+    using value_type = T;
+
+    JobPoolAllocator() = default;
+    template <typename U>
+    JobPoolAllocator(const JobPoolAllocator<U>&) {}
+
+    static FreeList& freeList() {
+        static FreeList* list = new FreeList(); // outlives every job, even at exit
+        return *list;
+    }
+
+    T* allocate(size_t n) {
+        if (n == 1) {
+            FreeList& list = freeList();
+            std::lock_guard<std::mutex> lock(list.mutex);
+            if (!list.blocks.empty()) {
+                void* block = list.blocks.back();
+                list.blocks.pop_back();
+                return static_cast<T*>(block);
+            }
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* block, size_t n) {
+        if (n != 1) {
+            ::operator delete(block);
+            return;
+        }
+        FreeList& list = freeList();
+        std::lock_guard<std::mutex> lock(list.mutex);
+        list.blocks.push_back(block);
+    }
+
+    template <typename U>
+    bool operator==(const JobPoolAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const JobPoolAllocator<U>&) const { return false; }
+};
+
+void pushBack(JobQueue& queue, const JobHandle& job) {
+    if (queue.size == queue.ring.size()) {
+        // unroll into a larger ring, oldest first
+        std::vector<JobHandle> grown(std::max<size_t>(queue.ring.size() * 2, 64));
+        for (size_t i = 0; i < queue.size; ++i)
+            grown[i] = std::move(queue.ring[(queue.head + i) % queue.ring.size()]);
+        queue.ring.swap(grown);
+        queue.head = 0;
+    }
+    queue.ring[(queue.head + queue.size) % queue.ring.size()] = job;
+    ++queue.size;
+}
+
+JobHandle popBack(JobQueue& queue) {
+    --queue.size;
+    return std::move(queue.ring[(queue.head + queue.size) % queue.ring.size()]);
+}
+
+JobHandle popFront(JobQueue& queue) {
+    JobHandle job = std::move(queue.ring[queue.head]);
+    queue.head = (queue.head + 1) % queue.ring.size();
+    --queue.size;
+    return job;
+}
+
+void pushJob(JobSystem& jobs, const JobHandle& job) {
+    JobQueue& queue = *jobs.queues[queueOfCaller(jobs)];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        pushBack(queue, job);
+    }
+    jobs.queuedJobs.fetch_add(1, std::memory_order_release);
+    jobs.wake.notify_one();
+}
+
+JobHandle takeJob(JobSystem& jobs, int self) {
+    {
+        JobQueue& own = *jobs.queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.size > 0) {
+            JobHandle job = popBack(own);
+            jobs.queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    // steal, starting with the next queue so thieves spread out
+    int count = static_cast<int>(jobs.queues.size());
+    for (int i = 1; i < count; ++i) {
+        JobQueue& victim = *jobs.queues[(self + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.size > 0) {
+            JobHandle job = popFront(victim);
+            jobs.queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            jobs.counters[self]->steals.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void finishJob(JobSystem& jobs, const JobHandle& job) {
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    std::vector<JobHandle> continuations;
+    {
+        std::lock_guard<std::mutex> lock(job->continuationMutex);
+        job->finished = true;
+        continuations.swap(job->continuations);
+    }
+    for (const JobHandle& next : continuations)
+        runJob(jobs, next);
+    if (job->parent)
+        finishJob(jobs, job->parent);
+}
+
+void executeJob(JobSystem& jobs, const JobHandle& job, int self) {
+    if (job->function)
+        job->function();
+    jobs.counters[self]->executed.fetch_add(1, std::memory_order_relaxed);
+    finishJob(jobs, job);
+}
+
+void workerLoop(JobSystem& jobs, int self) {
+    currentSystem = &jobs;
+    currentQueue = self;
+    JobCounters& counters = *jobs.counters[self];
+
+    while (true) {
+        if (JobHandle job = takeJob(jobs, self)) {
+            executeJob(jobs, job, self);
+            continue;
+        }
+        if (jobs.stopping.load(std::memory_order_acquire) && jobs.queuedJobs.load() == 0)
+            break;
+
+        // the timeout covers a push racing with going to sleep
+        auto idleStart = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(jobs.wakeMutex);
+            jobs.wake.wait_for(lock, std::chrono::milliseconds(1), [&] {
+                return jobs.queuedJobs.load(std::memory_order_acquire) > 0 || jobs.stopping.load();
+            });
+        }
+        auto idle = std::chrono::steady_clock::now() - idleStart;
+        counters.idleMicroseconds.fetch_add(
+            std::chrono::duration_cast<std::chrono::microseconds>(idle).count(), std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+void initJobSystem(JobSystem& jobs, int workerCount) {
+    if (workerCount <= 0)
+        workerCount = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    workerCount = std::max(workerCount, 1);
+
+    jobs.stopping = false;
+    jobs.queuedJobs = 0;
+    for (int i = 0; i <= workerCount; ++i) {
+        jobs.queues.push_back(std::make_unique<JobQueue>());
+        jobs.counters.push_back(std::make_unique<JobCounters>());
+    }
+    for (int i = 1; i <= workerCount; ++i)
+        jobs.workers.emplace_back(workerLoop, std::ref(jobs), i);
+}
+
+JobHandle createJob(std::function<void()> function, const JobHandle& parent) {
+    JobHandle job = std::allocate_shared<Job>(JobPoolAllocator<Job>());
+    job->function = std::move(function);
+    job->parent = parent;
+    if (parent)
+        parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+    return job;
+}
+
+void addContinuation(JobSystem& jobs, const JobHandle& job, const JobHandle& next) {
+    {
+        std::lock_guard<std::mutex> lock(job->continuationMutex);
+        if (!job->finished) {
+            job->continuations.push_back(next);
+            return;
+        }
+    }
+    runJob(jobs, next);
+}
+
+void runJob(JobSystem& jobs, const JobHandle& job) {
+    pushJob(jobs, job);
+}
+
+bool jobFinished(const JobHandle& job) {
+    return job->unfinished.load(std::memory_order_acquire) == 0;
+}
+
+void waitForJob(JobSystem& jobs, const JobHandle& job) {
+    int self = queueOfCaller(jobs);
+    while (!jobFinished(job)) {
+        if (JobHandle other = takeJob(jobs, self))
+            executeJob(jobs, other, self);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void parallelFor(JobSystem& jobs, const GridRange& range, int grain,
+                 const std::function<void(const GridRange&)>& function) {
+    grain = std::max(grain, 1);
+    int tilesX = (std::max(range.colEnd - range.colBegin, 0) + grain - 1) / grain;
+    int tilesZ = (std::max(range.rowEnd - range.rowBegin, 0) + grain - 1) / grain;
+
+    // the tiles live in the caller's arena until every job is done; the jobs
+    // only capture a pointer, which keeps them in std::function's inline
+    // storage
+    FrameArena& arena = threadFrameArena();
+    ArenaMark mark = arenaMark(arena);
+    GridRange* tiles = static_cast<GridRange*>(
+        arenaAllocate(arena, sizeof(GridRange) * std::max(tilesX * tilesZ, 1), alignof(GridRange)));
+
+    JobHandle root = createJob(nullptr);
+    int count = 0;
+    for (int row = range.rowBegin; row < range.rowEnd; row += grain) {
+        for (int col = range.colBegin; col < range.colEnd; col += grain) {
+            GridRange* tile = &tiles[count++];
+            tile->rowBegin = row;
+            tile->rowEnd = std::min(row + grain, range.rowEnd);
+            tile->colBegin = col;
+            tile->colEnd = std::min(col + grain, range.colEnd);
+            runJob(jobs, createJob([&function, tile] { function(*tile); }, root));
+        }
+    }
+    // the root itself has no work; finishing it leaves only the tiles pending
+    executeJob(jobs, root, queueOfCaller(jobs));
+    waitForJob(jobs, root);
+    arenaRewind(arena, mark);
+}
+
+void parallelFor(JobSystem& jobs, int begin, int end, int grain, const std::function<void(int, int)>& function) {
+    GridRange range;
+    range.rowBegin = 0;
+    range.rowEnd = 1;
+    range.colBegin = begin;
+    range.colEnd = end;
+    parallelFor(jobs, range, grain, [&function](const GridRange& tile) { function(tile.colBegin, tile.colEnd); });
+}
+
+JobSystemStats readJobSystemStats(const JobSystem& jobs) {
+    JobSystemStats stats;
+    stats.threads = static_cast<int>(jobs.workers.size());
+    uint64_t idle = 0;
+    for (const auto& counters : jobs.counters) {
+        stats.executed += counters->executed.load(std::memory_order_relaxed);
+        stats.steals += counters->steals.load(std::memory_order_relaxed);
+        idle += counters->idleMicroseconds.load(std::memory_order_relaxed);
+    }
+    stats.idleSeconds = idle / 1e6;
+    return stats;
+}
+
+void printJobSystemStats(const JobSystem& jobs) {
+    JobSystemStats stats = readJobSystemStats(jobs);
+    std::cout << "Jobs: " << stats.threads << " workers, " << stats.executed << " executed, " << stats.steals
+              << " stolen, " << stats.idleSeconds << " s idle" << std::endl;
+    for (size_t i = 0; i < jobs.counters.size(); ++i) {
+        const JobCounters& counters = *jobs.counters[i];
+        std::cout << "  " << (i == 0 ? std::string("external") : "worker " + std::to_string(i)) << ": "
+                  << counters.executed.load() << " executed, " << counters.steals.load() << " stolen, "
+                  << counters.idleMicroseconds.load() / 1e6 << " s idle" << std::endl;
+    }
+}
+
+void deleteJobSystem(JobSystem& jobs) {
+    {
+        std::lock_guard<std::mutex> lock(jobs.wakeMutex);
+        jobs.stopping = true;
+    }
+    jobs.wake.notify_all();
+    for (std::thread& worker : jobs.workers)
+        worker.join();
+    jobs.workers.clear();
+    jobs.queues.clear();
+    jobs.counters.clear();
+}
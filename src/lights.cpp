@@ -0,0 +1,324 @@
+#include <lights.hpp>
+#include <memory_stats.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+const float TORCH_RADIUS = 4.5f;
+const float TORCH_HEIGHT = 1.5f;
+
+bool wallAt(const MazeBits& bits, int row, int col) {
+    if (row < 0 || col < 0 || row >= bits.rows || col >= bits.cols)
+        return true;
+    return bits.isWall(row, col);
+}
+
+// Walk the cells between two cell centres (supercover DDA) and report
+// whether any cell strictly between them is a wall
+bool lineOfSight(const MazeBits& bits, int fromRow, int fromCol, int toRow, int toCol) {
+    int dx = std::abs(toCol - fromCol), dz = std::abs(toRow - fromRow);
+    int stepX = toCol > fromCol ? 1 : -1, stepZ = toRow > fromRow ? 1 : -1;
+    int col = fromCol, row = fromRow;
+    // compare 2 * error terms so the diagonal case stays exact
+    for (int ix = 0, iz = 0; ix < dx || iz < dz;) {
+        long decision = static_cast<long>(1 + 2 * ix) * dz - static_cast<long>(1 + 2 * iz) * dx;
+        if (decision == 0) {
+            // passing exactly through a corner: both side cells block
+            if (wallAt(bits, row, col + stepX) && wallAt(bits, row + stepZ, col))
+                return false;
+            col += stepX;
+            row += stepZ;
+            ++ix;
+            ++iz;
+        } else if (decision < 0) {
+            col += stepX;
+            ++ix;
+        } else {
+            row += stepZ;
+            ++iz;
+        }
+        if ((row != toRow || col != toCol) && wallAt(bits, row, col))
+            return false;
+    }
+    return true;
+}
+
+// World-space xz of the cell's centre, matching mazeCellPosition()
+glm::vec2 cellCentre(const MazeBits& bits, int row, int col) {
+    glm::vec3 p = mazeCellPosition(row, col, bits.rows, bits.cols);
+    return glm::vec2(p.x, p.z);
+}
+
+// The cell a light hangs in; false outside the grid
+bool lightCell(const MazeBits& bits, const PointLight& light, int& row, int& col) {
+    col = static_cast<int>(std::floor(light.position.x + 0.5f)) + bits.cols / 2;
+    row = static_cast<int>(std::floor(light.position.z + 0.5f)) + bits.rows / 2;
+    return row >= 0 && col >= 0 && row < bits.rows && col < bits.cols;
+}
+
+bool lightReachesCell(const MazeBits& bits, const PointLight& light, int lightRow, int lightCol, int row, int col) {
+    // distance from the light to the nearest point of the cell
+    glm::vec2 offset = glm::abs(glm::vec2(light.position.x, light.position.z) - cellCentre(bits, row, col));
+    glm::vec2 outside = glm::max(offset - glm::vec2(0.5f), glm::vec2(0.0f));
+    if (glm::dot(outside, outside) > light.radius * light.radius)
+        return false;
+    return lineOfSight(bits, lightRow, lightCol, row, col);
+}
+
+// Index buffer room for this many indices, with headroom for re-binning
+size_t indexCapacityFor(size_t indices) {
+    return indices + indices / 2 + 1024;
+}
+
+} // namespace
+
+void placeTorches(const MazeBits& bits, int count, uint32_t seed, std::vector<PointLight>& lights) {
+    lights.clear();
+    std::vector<std::pair<int, int>> open;
+    for (int row = 0; row < bits.rows; ++row)
+        for (int col = 0; col < bits.cols; ++col)
+            if (!bits.isWall(row, col))
+                open.push_back({row, col});
+
+    std::mt19937 rng(seed);
+    std::shuffle(open.begin(), open.end(), rng);
+    const int dirs[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (const auto& cell : open) {
+        if (static_cast<int>(lights.size()) >= count)
+            break;
+        // hang the torch on a wall next to the cell
+        int start = static_cast<int>(rng() % 4);
+        for (int k = 0; k < 4; ++k) {
+            const int* dir = dirs[(start + k) % 4];
+            if (!wallAt(bits, cell.first + dir[0], cell.second + dir[1]))
+                continue;
+            glm::vec2 centre = cellCentre(bits, cell.first, cell.second);
+            PointLight light;
+            light.position = glm::vec3(centre.x + 0.4f * dir[1], TORCH_HEIGHT, centre.y + 0.4f * dir[0]);
+            light.radius = TORCH_RADIUS;
+            float warmth = unit(rng);
+            light.color = glm::vec3(1.0f, 0.55f + 0.2f * warmth, 0.25f + 0.1f * warmth);
+            light.intensity = 1.2f + 0.6f * unit(rng);
+            lights.push_back(light);
+            break;
+        }
+    }
+}
+
+void binLights(const MazeBits& bits, const std::vector<PointLight>& lights, LightGrid& grid, JobSystem* jobs) {
+    grid.rows = bits.rows;
+    grid.cols = bits.cols;
+    grid.cells.assign(static_cast<size_t>(bits.rows) * bits.cols * 2, 0);
+    grid.indices.clear();
+    grid.maxPerCell = 0;
+
+    // bucket lights by the cell they hang in
+    std::vector<std::vector<uint32_t>> byCell(static_cast<size_t>(bits.rows) * bits.cols);
+    float maxRadius = 0.0f;
+    for (size_t i = 0; i < lights.size(); ++i) {
+        int row, col;
+        if (!lightCell(bits, lights[i], row, col))
+            continue;
+        byCell[row * bits.cols + col].push_back(static_cast<uint32_t>(i));
+        maxRadius = std::max(maxRadius, lights[i].radius);
+    }
+    int reach = static_cast<int>(std::ceil(maxRadius)) + 1;
+    grid.reach = reach;
+    grid.unusedIndices = 0;
+
+    // each row collects its own lists; they are concatenated afterwards
+    std::vector<std::vector<uint32_t>> rowIndices(bits.rows);
+    std::vector<std::vector<uint32_t>> rowCounts(bits.rows);
+    auto binRows = [&](int rowBegin, int rowEnd) {
+        for (int row = rowBegin; row < rowEnd; ++row) {
+            rowCounts[row].assign(bits.cols, 0);
+            for (int col = 0; col < bits.cols; ++col) {
+                uint32_t count = 0;
+                for (int lr = std::max(row - reach, 0); lr <= std::min(row + reach, bits.rows - 1); ++lr) {
+                    for (int lc = std::max(col - reach, 0); lc <= std::min(col + reach, bits.cols - 1); ++lc) {
+                        for (uint32_t index : byCell[lr * bits.cols + lc]) {
+                            if (!lightReachesCell(bits, lights[index], lr, lc, row, col))
+                                continue;
+                            rowIndices[row].push_back(index);
+                            ++count;
+                        }
+                    }
+                }
+                rowCounts[row][col] = count;
+            }
+        }
+    };
+    if (jobs)
+        parallelFor(*jobs, 0, bits.rows, 4, binRows);
+    else
+        binRows(0, bits.rows);
+
+    for (int row = 0; row < bits.rows; ++row) {
+        uint32_t first = static_cast<uint32_t>(grid.indices.size());
+        for (int col = 0; col < bits.cols; ++col) {
+            uint32_t count = rowCounts[row][col];
+            grid.cells[(row * bits.cols + col) * 2] = first;
+            grid.cells[(row * bits.cols + col) * 2 + 1] = std::min<uint32_t>(count, MAX_LIGHTS_PER_CELL);
+            grid.maxPerCell = std::max(grid.maxPerCell, static_cast<int>(count));
+            first += count;
+        }
+        grid.indices.insert(grid.indices.end(), rowIndices[row].begin(), rowIndices[row].end());
+    }
+}
+
+CellRect rebinLightsAround(const MazeBits& bits, const std::vector<PointLight>& lights, LightGrid& grid, int row,
+                           int col) {
+    CellRect rect;
+    rect.rowBegin = std::max(row - grid.reach, 0);
+    rect.rowEnd = std::min(row + grid.reach + 1, bits.rows);
+    rect.colBegin = std::max(col - grid.reach, 0);
+    rect.colEnd = std::min(col + grid.reach + 1, bits.cols);
+    if (rect.empty())
+        return rect;
+
+    // only lights within reach of the rectangle can be listed in it
+    std::vector<uint32_t> candidates;
+    std::vector<glm::ivec2> candidateCells;
+    for (size_t i = 0; i < lights.size(); ++i) {
+        int lightRow, lightCol;
+        if (!lightCell(bits, lights[i], lightRow, lightCol) || lightRow < rect.rowBegin - grid.reach ||
+            lightRow >= rect.rowEnd + grid.reach || lightCol < rect.colBegin - grid.reach ||
+            lightCol >= rect.colEnd + grid.reach)
+            continue;
+        candidates.push_back(static_cast<uint32_t>(i));
+        candidateCells.push_back(glm::ivec2(lightRow, lightCol));
+    }
+
+    for (int r = rect.rowBegin; r < rect.rowEnd; ++r) {
+        for (int c = rect.colBegin; c < rect.colEnd; ++c) {
+            uint32_t* cell = &grid.cells[(r * bits.cols + c) * 2];
+            grid.unusedIndices += cell[1];
+            uint32_t first = static_cast<uint32_t>(grid.indices.size()), count = 0;
+            for (size_t k = 0; k < candidates.size(); ++k) {
+                const glm::ivec2& lightAt = candidateCells[k];
+                if (std::abs(lightAt.x - r) > grid.reach || std::abs(lightAt.y - c) > grid.reach ||
+                    !lightReachesCell(bits, lights[candidates[k]], lightAt.x, lightAt.y, r, c))
+                    continue;
+                grid.indices.push_back(candidates[k]);
+                ++count;
+            }
+            cell[0] = first;
+            cell[1] = std::min<uint32_t>(count, MAX_LIGHTS_PER_CELL);
+            grid.unusedIndices += count - cell[1];
+            grid.maxPerCell = std::max(grid.maxPerCell, static_cast<int>(count));
+        }
+    }
+    return rect;
+}
+
+void uploadLights(LightBuffers& buffers, const std::vector<PointLight>& lights, const LightGrid& grid) {
+    if (!buffers.lightBuffer) {
+        glGenBuffers(1, &buffers.lightBuffer);
+        glGenBuffers(1, &buffers.indexBuffer);
+        glGenTextures(1, &buffers.lightTexture);
+        glGenTextures(1, &buffers.indexTexture);
+        glGenTextures(1, &buffers.cellTexture);
+    }
+
+    // texel 0: position + radius, texel 1: colour * intensity + unused
+    std::vector<glm::vec4> texels;
+    texels.reserve(lights.size() * 2);
+    for (const PointLight& light : lights) {
+        texels.push_back(glm::vec4(light.position, light.radius));
+        texels.push_back(glm::vec4(light.color * light.intensity, 0.0f));
+    }
+    if (texels.empty())
+        texels.push_back(glm::vec4(0.0f)); // buffer textures need storage
+    glBindBuffer(GL_TEXTURE_BUFFER, buffers.lightBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, texels.size() * sizeof(glm::vec4), texels.data(), GL_STATIC_DRAW);
+    trackBufferMemory(MEMORY_LIGHTS, buffers.lightBuffer, texels.size() * sizeof(glm::vec4));
+
+    buffers.indexCapacity = indexCapacityFor(grid.indices.size());
+    glBindBuffer(GL_TEXTURE_BUFFER, buffers.indexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, buffers.indexCapacity * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, grid.indices.size() * sizeof(uint32_t), grid.indices.data());
+    trackBufferMemory(MEMORY_LIGHTS, buffers.indexBuffer, buffers.indexCapacity * sizeof(uint32_t));
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, buffers.lightTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffers.lightBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, buffers.indexTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, buffers.indexBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_2D, buffers.cellTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, grid.cols, grid.rows, 0, GL_RG_INTEGER, GL_UNSIGNED_INT,
+                 grid.cells.data());
+    trackTextureMemory(MEMORY_LIGHTS, buffers.cellTexture,
+                       static_cast<size_t>(grid.cols) * grid.rows * texelBytes(GL_RG32UI));
+    // integer textures must not be filtered
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    buffers.lightCount = static_cast<int>(lights.size());
+    buffers.rows = grid.rows;
+    buffers.cols = grid.cols;
+}
+
+void updateLightCells(LightBuffers& buffers, const std::vector<PointLight>& lights, const LightGrid& grid,
+                      const CellRect& rect, size_t firstIndex) {
+    if (grid.indices.size() > buffers.indexCapacity) {
+        uploadLights(buffers, lights, grid);
+        return;
+    }
+    if (grid.indices.size() > firstIndex) {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers.indexBuffer);
+        glBufferSubData(GL_TEXTURE_BUFFER, firstIndex * sizeof(uint32_t),
+                        (grid.indices.size() - firstIndex) * sizeof(uint32_t), grid.indices.data() + firstIndex);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+    if (rect.empty())
+        return;
+
+    // the rectangle's rows are strided within the full grid
+    glBindTexture(GL_TEXTURE_2D, buffers.cellTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, grid.cols);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.colBegin, rect.rowBegin, rect.colEnd - rect.colBegin,
+                    rect.rowEnd - rect.rowBegin, GL_RG_INTEGER, GL_UNSIGNED_INT,
+                    &grid.cells[(rect.rowBegin * grid.cols + rect.colBegin) * 2]);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void bindLights(GLuint program, const LightBuffers& buffers, int firstUnit, float time) {
+    glActiveTexture(GL_TEXTURE0 + firstUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, buffers.lightTexture);
+    glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+    glBindTexture(GL_TEXTURE_BUFFER, buffers.indexTexture);
+    glActiveTexture(GL_TEXTURE0 + firstUnit + 2);
+    glBindTexture(GL_TEXTURE_2D, buffers.cellTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glUniform1i(glGetUniformLocation(program, "lightData"), firstUnit);
+    glUniform1i(glGetUniformLocation(program, "lightIndices"), firstUnit + 1);
+    glUniform1i(glGetUniformLocation(program, "lightCells"), firstUnit + 2);
+    glUniform2i(glGetUniformLocation(program, "lightGridSize"), buffers.cols, buffers.rows);
+    glUniform1i(glGetUniformLocation(program, "lightingEnabled"), buffers.cellTexture != 0);
+    glUniform1f(glGetUniformLocation(program, "time"), time);
+}
+
+void deleteLights(LightBuffers& buffers) {
+    untrackTextureMemory(buffers.cellTexture);
+    untrackBufferMemory(buffers.lightBuffer);
+    untrackBufferMemory(buffers.indexBuffer);
+    glDeleteTextures(1, &buffers.lightTexture);
+    glDeleteTextures(1, &buffers.indexTexture);
+    glDeleteTextures(1, &buffers.cellTexture);
+    glDeleteBuffers(1, &buffers.lightBuffer);
+    glDeleteBuffers(1, &buffers.indexBuffer);
+    buffers = LightBuffers();
+}
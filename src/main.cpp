@@ -1,44 +1,58 @@
 #include <OpenGLPrj.hpp>
+#include <agents.hpp>
+#include <allocation_counter.hpp>
+#include <benchmarks.hpp>
+#include <culling.hpp>
+#include <fixed_maze.hpp>
+#include <frame_arena.hpp>
+#include <frame_capture.hpp>
+#include <headless.hpp>
+#include <jobs.hpp>
+#include <maze.hpp>
+#include <maze_edit.hpp>
+#include <maze_mesh.hpp>
+#include <memory_stats.hpp>
+#include <renderer.hpp>
+#include <replication.hpp>
+#include <triple_buffer.hpp>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <cmath>
 #include <vector>
 #include <cmath>
+#include <cstdio>
 #include <cstdlib> //for rand()
-#include <algorithm>
-#include <functional>
-#include <random>
+#include <string>
+#include <thread>
 
 
 const std::string program_name = ("GLSL shaders & uniforms");
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
+void networkInput(GLFWwindow *window);
+void shiftWalls();
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 800;
 
+// the level's size; camera collision runs on a Maze of it (fixed_maze.hpp)
+const int MAZE_SIZE = 19;
+
+// the simulation runs at a fixed rate, independent of how fast frames render
+const double SIMULATION_STEP = 1.0 / 120.0;
+
+// --check-allocations: ticks and frames after this many must not allocate
+// (chunks and textures stream in during the first ones)
+const uint64_t ALLOCATION_WARMUP = 600;
+std::atomic<bool> steadyStateAllocated{false};
 
-static const char *vertexShaderSource ="#version 330 core\n"
-                                       "layout (location = 0) in vec3 aPos;\n"
-                                       "uniform mat4 model;\n"
-                                       "uniform mat4 view;\n"
-                                       "uniform mat4 projection;"
-                                       "void main()\n"
-                                       "{\n"
-                                       "   gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
-                                       "}\0";
-
-static const char *fragmentShaderSource = "#version 330 core\n"
-                                          "out vec4 FragColor;\n"
-                                          "uniform vec4 ourColor;\n"
-                                          "void main()\n"
-                                          "{\n"
-                                          "   FragColor = ourColor;\n"
-                                          "}\n\0";
 
 glm::mat4 view = glm::mat4(1.0f);
 glm::vec3 cameraPos   = glm::vec3(10.0f, 0.0f,  7.0f);
@@ -49,38 +63,241 @@ float deltaTime = 0.0f;	// Time between current frame and last frame
 float lastFrame = 0.0f; // Time of last frame
 
 std::vector<std::vector<int>> maze;
+Maze<MAZE_SIZE, MAZE_SIZE> levelWalls; // the same walls, for collision
+bool fixedLevel = false; // levelWalls holds the level; false when it is not MAZE_SIZE square
+MazeEditQueue mazeEdits; // wall edits for the renderer
+AgentSystem agents;
+std::vector<uint32_t> nearbyAgents; // query results, reused every move
+float wallShiftInterval = 0.0f; // --shifting-walls SECONDS; 0 = walls stay put
+float nextWallShift = 0.0f;
+bool networked = false;     // --connect HOST:PORT: the server moves the camera
+ReplicationClient network;
+std::vector<glm::vec4> remotePlayers; // the other players, as agent instances
+
+// Advance the simulation one step and describe the result for the renderer.
+// Only reads renderer state that is fixed after initRenderer (settings and
+// chunk bounds), so it is safe next to a running render thread.
+void simulateTick(GLFWwindow *window, const Renderer& renderer, uint64_t tick, RenderSnapshot& snapshot)
+{
+    // scratch data of the previous tick is dead by now
+    resetFrameArena(threadFrameArena());
+
+    float currentFrame = glfwGetTime();
+    deltaTime = currentFrame - lastFrame;
+    lastFrame = currentFrame;
+    if (networked)
+        networkInput(window);
+    else
+        processInput(window);
+    // the server's walls are the ones players collide with; they do not shift
+    if (!networked && wallShiftInterval > 0.0f && currentFrame >= nextWallShift) {
+        shiftWalls();
+        nextWallShift = currentFrame + wallShiftInterval;
+    }
+    // a long stall (window drag, debugger) must not tunnel agents through walls
+    updateAgents(agents, std::min(deltaTime, 0.1f));
+
+    const LodSettings& lod = renderer.settings.lod;
+    view = glm::lookAt(cameraPos, cameraFront + cameraPos, cameraUp);
+    // everything past fogEnd is fully fogged, so it can be the far plane
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 800.0f, 0.1f, lod.fogEnd);
+
+    snapshot.tick = tick;
+    snapshot.time = currentFrame;
+    snapshot.cameraPos = cameraPos;
+    snapshot.cameraFront = cameraFront;
+    snapshot.view = view;
+    snapshot.projection = projection;
+    glfwGetFramebufferSize(window, &snapshot.framebufferWidth, &snapshot.framebufferHeight);
+
+    snapshot.meshChunks.clear();
+    snapshot.impostorChunks.clear();
+    snapshot.cullStats = CullStats();
+    if (rendererWantsChunkLists(renderer))
+        cullMazeChunks(renderer.mazeMesh, extractFrustum(projection * view), lod, cameraPos,
+                       snapshot.meshChunks, snapshot.impostorChunks, snapshot.cullStats);
+    writeAgentInstances(agents, snapshot.agents);
+    snapshot.agents.insert(snapshot.agents.end(), remotePlayers.begin(), remotePlayers.end());
+}
 
-void generateMaze(std::vector<std::vector<int>>& maze, int rows, int cols) {
-    // Initialize the maze with walls
-    maze.resize(rows, std::vector<int>(cols, 1));
+// Send input to the server until its first full snapshot tells us the level;
+// false after five seconds without one
+bool joinServer()
+{
+    PlayerInput idle;
+    for (int tick = 0; tick < 5 * REPLICATION_TICK_RATE && !network.joined; ++tick) {
+        sendPlayerInput(network, idle);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000 / REPLICATION_TICK_RATE));
+        receiveSnapshots(network);
+    }
+    return network.joined;
+}
 
-    // Start recursive backtracking from a random cell
-    std::function<void(int, int)> carve = [&](int x, int y) {
-        maze[x][y] = 0; // Mark the current cell as a path
+// Report a tick or frame past the warm-up that went to the heap
+void checkSteadyState(const char* what, uint64_t index, uint64_t allocations)
+{
+    if (index <= ALLOCATION_WARMUP || allocations == 0)
+        return;
+    std::cout << "ERROR::ALLOCATIONS::STEADY_STATE " << what << " " << index << " allocated " << allocations
+              << " times" << std::endl;
+    steadyStateAllocated.store(true, std::memory_order_relaxed);
+}
 
-        // Directions for moving (right, down, left, up)
-        std::vector<std::pair<int, int>> directions = {{0, 2}, {2, 0}, {0, -2}, {-2, 0}};
-        std::shuffle(directions.begin(), directions.end(), std::default_random_engine(std::random_device{}()));
+void showRenderStats(GLFWwindow *window, const RenderStats& stats)
+{
+    const CullStats& cullStats = stats.cull;
+    // formatted on the stack; the title changes twice a second
+    char title[256];
+    int length = std::snprintf(title, sizeof(title),
+                               "%s | %d fps | chunks %d drawn %d frustum-culled %d occluded %d impostors %d",
+                               program_name.c_str(), static_cast<int>(stats.fps), cullStats.chunks, cullStats.drawn,
+                               cullStats.frustumRejected, cullStats.occlusionRejected, cullStats.impostors);
+
+    // a truncated first part leaves nothing to append to
+    length = std::clamp(length, 0, static_cast<int>(sizeof(title)) - 1);
+    MemoryUsage memory;
+    readMemoryUsage(memory);
+    const double megabyte = 1024.0 * 1024.0;
+    length += std::snprintf(title + length, sizeof(title) - length, " | mem cpu %.1f gpu %.1f MB",
+                            memory.cpuTotal / megabyte, memory.gpuTotal / megabyte);
+    for (int i = 0; i < MEMORY_TAG_COUNT && length < static_cast<int>(sizeof(title)); ++i) {
+        MemoryTag tag = static_cast<MemoryTag>(i);
+        if (memoryOverBudget(memory, tag))
+            length += std::snprintf(title + length, sizeof(title) - length, " | %s over budget", memoryTagName(tag));
+    }
+    glfwSetWindowTitle(window, title);
+}
 
-        for (auto& [dx, dy] : directions) {
-            int nx = x + dx, ny = y + dy;
-            if (nx > 0 && nx < rows - 1 && ny > 0 && ny < cols - 1 && maze[nx][ny] == 1) {
-                // Break the wall between cells
-                maze[x + dx / 2][y + dy / 2] = 0;
-                carve(nx, ny);
+int main(int argc, char **argv) {
+    // glfw: initialize and configure
+    // ------------------------------
+    // command line switches
+    RenderSettings settings;
+    bool singleThread = false;  // --single-thread: simulate and render in one loop
+    int jobWorkers = 0;         // --jobs N: worker threads (0 = one per core)
+    bool showJobStats = false;  // --job-stats: print scheduler counters on exit
+    int agentCount = 1000;      // --agents N: NPCs wandering the maze
+    int seekerCount = 0;        // --seekers N: of those, agents walking planned paths to goals
+    bool checkAllocations = false; // --check-allocations: fail if a steady-state tick or frame allocates
+    std::string memoryReport;   // --memory-report FILE: usage per subsystem as JSON, written on exit
+    std::string capturePath;    // --capture FILE: record every frame (see frame_capture.hpp)
+    bool captureRaw = false;    // --capture-raw: no delta frames
+    HeadlessSettings headless;  // --headless N: render N frames without a window, then exit
+    int serverPort = 0;         // --server PORT: host a game without a window (--seed picks the maze)
+    NetAddress serverAddress;   // --connect HOST:PORT: join one
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--cpu-culling")
+            settings.forceCpuCulling = true;
+        else if (arg == "--no-hiz")
+            settings.useOcclusionCulling = false;
+        else if (arg == "--vertex-pulling")
+            settings.useVertexPulling = true;
+        else if (arg == "--no-lod")
+            settings.lod.impostors = false;
+        else if (arg == "--no-minimap")
+            settings.showMinimap = false;
+        else if (arg == "--single-thread")
+            singleThread = true;
+        else if (arg == "--jobs" && i + 1 < argc)
+            jobWorkers = std::atoi(argv[++i]);
+        else if (arg == "--job-stats")
+            showJobStats = true;
+        else if (arg == "--torches" && i + 1 < argc)
+            settings.torches = std::atoi(argv[++i]);
+        else if (arg == "--no-shadows")
+            settings.sunShadows = false;
+        else if (arg == "--agents" && i + 1 < argc)
+            agentCount = std::atoi(argv[++i]);
+        else if (arg == "--seekers" && i + 1 < argc)
+            seekerCount = std::atoi(argv[++i]);
+        else if (arg == "--shifting-walls" && i + 1 < argc)
+            wallShiftInterval = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--check-allocations")
+            checkAllocations = true;
+        else if (arg == "--cpu-renderer")
+            settings.cpuRaycast = true;
+        else if (arg == "--headless" && i + 1 < argc)
+            headless.frames = std::atoi(argv[++i]);
+        else if (arg == "--output" && i + 1 < argc)
+            headless.outputDirectory = argv[++i];
+        else if (arg == "--reference" && i + 1 < argc)
+            headless.referenceDirectory = argv[++i];
+        else if (arg == "--timings" && i + 1 < argc)
+            headless.timingsFile = argv[++i];
+        else if (arg == "--max-frame-ms" && i + 1 < argc)
+            headless.maxAverageMs = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            headless.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--osmesa")
+            headless.osmesa = true;
+        else if (arg == "--size" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &headless.width, &headless.height) != 2 || headless.width <= 0 ||
+                headless.height <= 0) {
+                std::cout << "ERROR::ARGUMENTS::BAD_SIZE " << argv[i] << std::endl;
+                return -1;
             }
         }
-    };
+        else if (arg == "--server" && i + 1 < argc) {
+            unsigned port = 0;
+            char extra;
+            if (std::sscanf(argv[++i], "%u%c", &port, &extra) != 1 || port == 0 || port > 65535) {
+                std::cout << "ERROR::ARGUMENTS::BAD_PORT " << argv[i] << std::endl;
+                return -1;
+            }
+            serverPort = static_cast<int>(port);
+        }
+        else if (arg == "--connect" && i + 1 < argc) {
+            if (!parseNetAddress(argv[++i], serverAddress)) {
+                std::cout << "ERROR::ARGUMENTS::BAD_ADDRESS " << argv[i] << std::endl;
+                return -1;
+            }
+            networked = true;
+        }
+        else if (arg == "--bench" && i + 1 < argc)
+            return runBenchmark(argv[++i]) ? 0 : 1; // no window needed
+        else if (arg == "--upload-budget-kb" && i + 1 < argc)
+            settings.uploadBudget = static_cast<GLsizeiptr>(std::atoi(argv[++i])) << 10;
+        else if (arg == "--memory-report" && i + 1 < argc)
+            memoryReport = argv[++i];
+        else if (arg == "--capture" && i + 1 < argc)
+            capturePath = argv[++i];
+        else if (arg == "--capture-raw")
+            captureRaw = true;
+        else if (arg == "--memory-budget" && i + 1 < argc) {
+            // TAG=MB, e.g. meshes=16; repeat for more tags
+            std::string budget = argv[++i];
+            size_t split = budget.find('=');
+            MemoryTag tag;
+            if (split == std::string::npos || !parseMemoryTag(budget.substr(0, split), tag)) {
+                std::cout << "ERROR::ARGUMENTS::BAD_MEMORY_BUDGET " << budget << std::endl;
+                return -1;
+            }
+            setMemoryBudget(tag, static_cast<size_t>(std::atof(budget.c_str() + split + 1) * 1024.0 * 1024.0));
+        }
+    }
 
-    carve(1, 1); // Start carving from (1, 1)
-}
+    if (checkAllocations && !allocationCountingAvailable()) {
+        std::cout << "--check-allocations needs a development build (NDEBUG not defined)" << std::endl;
+        checkAllocations = false;
+    }
+
+    if (headless.frames > 0) {
+        headless.agentCount = agentCount;
+        return runHeadless(headless, settings, jobWorkers);
+    }
+    if (serverPort > 0)
+        return runReplicationServer(static_cast<uint16_t>(serverPort), headless.seed, MAZE_SIZE);
+    if (networked) {
+        if (!connectReplicationClient(network, serverAddress) || !joinServer()) {
+            std::cout << "ERROR::NET::NO_SERVER" << std::endl;
+            return -1;
+        }
+        // NPCs are not replicated, and would differ between players
+        agentCount = 0;
+    }
 
-int main() {
-    // glfw: initialize and configure
-    // ------------------------------
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef __APPLE__
@@ -89,7 +306,16 @@ int main() {
 
     // glfw window creation
     // --------------------
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, program_name.c_str(), nullptr, nullptr);
+    // 4.3 enables the GPU-driven path; 3.3 is the minimum we can run on
+    GLFWwindow *window = nullptr;
+    const int contextVersions[][2] = {{4, 3}, {3, 3}};
+    for (const auto& version : contextVersions) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, program_name.c_str(), nullptr, nullptr);
+        if (window != nullptr)
+            break;
+    }
     if (window == nullptr) {
         std::cout << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -105,202 +331,232 @@ int main() {
         return -1;
     }
 
-    // build and compile our shader program
-    // ------------------------------------
-    // vertex shader
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vertexShader);
-
-    // check for shader compile errors
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-    // fragment shader
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fragmentShader);
-    // check for shader compile errors
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-    // link shaders
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    // check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+    if (networked) // the same maze as the server's
+        generateMaze(maze, network.mazeRows, network.mazeCols, network.mazeSeed);
+    else
+        generateMaze(maze, MAZE_SIZE, MAZE_SIZE);
+    size_t mazeBytes = maze.capacity() * sizeof(std::vector<int>);
+    for (const auto& row : maze)
+        mazeBytes += row.capacity() * sizeof(int);
+    reportCpuMemory(MEMORY_MAZE, &maze, mazeBytes);
+
+    JobSystem jobs;
+    initJobSystem(jobs, jobWorkers);
+
+    Renderer renderer;
+    if (!initRenderer(renderer, maze, settings, &jobs)) {
+        deleteJobSystem(jobs);
+        glfwTerminate();
+        return -1;
     }
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    // set up vertex data (and buffer(s)) and configure vertex attributes
-    // ------------------------------------------------------------------
-
-    float cubeVertices[] = {
-            // Define the vertices of the cube (each cube is 1x1)
-            -0.5f, -0.9f, -0.5f,
-            0.5f, -0.9f, -0.5f,
-            0.5f, 5.0f, -0.5f,
-            -0.5f, 5.0f, -0.5f,
-            -0.5f, -0.9f, 0.5f,
-            0.5f, -0.9f, 0.5f,
-            0.5f, 5.0f, 0.5f,
-            -0.5f, 5.0f, 0.5f
-    };
-
-    unsigned int cubeIndices[] = {
-            0, 1, 2, 2, 3, 0,  // back face
-            4, 5, 6, 6, 7, 5,  // front face
-            0, 4, 1, 4, 1, 5,  // left face
-            3, 7, 2, 2, 7, 6,  // right face
-            0, 4, 3, 4, 3, 7,  // bottom face
-            1, 5, 2, 5, 2, 6   // top face
-    };
-
-    generateMaze(maze, 19, 19);
-
-
-    unsigned int cubeVAO, cubeVBO, cubeEBO;
-    glGenVertexArrays(1, &cubeVAO);
-    glGenBuffers(1, &cubeVBO);
-    glGenBuffers(1, &cubeEBO);
-    glBindVertexArray(cubeVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIndices), cubeIndices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *) 0);
-    glEnableVertexAttribArray(0);
-
-    // Set up some OpenGL state
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL); // Wireframe mode
-    glEnable(GL_DEPTH_TEST);
+    // a server's level may have another size; then collision runs on the
+    // agents' copy of the walls, which every edit keeps current too
+    fixedLevel = loadFixedMaze(renderer.mazeBits, levelWalls);
+    if (!fixedLevel)
+        std::cout << "Level is " << renderer.mazeBits.rows << "x" << renderer.mazeBits.cols << ", not "
+                  << MAZE_SIZE << "x" << MAZE_SIZE << "; colliding against the runtime-sized walls" << std::endl;
+    initAgents(agents, renderer.mazeBits, agentCount, 4321u, &jobs);
+    setAgentSeekers(agents, seekerCount);
+    renderer.edits = &mazeEdits;
+
+    // read back on the render thread, encoded and written on a thread of its own
+    FrameCapture capture;
+    if (!capturePath.empty() && startFrameCapture(capture, capturePath, !captureRaw))
+        std::cout << "Capturing frames to " << capturePath << std::endl;
 
     // hide the cursor
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     void mouse_callback(GLFWwindow *window, double xpos, double ypos);
-    // render loop
-
-    // -----------
-    while (!glfwWindowShouldClose(window)) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        // Handle input and update frame timing
-        glfwSetCursorPosCallback(window, mouse_callback);
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-        processInput(window);
-
-        // Clear screen and set up matrices
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glUseProgram(shaderProgram);
-
-        glm::mat4 model = glm::mat4(1.0f);
-        view = glm::lookAt(cameraPos, cameraFront + cameraPos, cameraUp);
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 800.0f, 0.1f, 100.0f);
-
-        unsigned int modelLoc = glGetUniformLocation(shaderProgram, "model");
-        unsigned int viewLoc = glGetUniformLocation(shaderProgram, "view");
-        unsigned int projLoc = glGetUniformLocation(shaderProgram, "projection");
-
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projection[0][0]);
-
-        int vertexColorLocation = glGetUniformLocation(shaderProgram, "ourColor");
-        glUniform4f(vertexColorLocation, 0.0f, 0.75f, 1.0f, 1.0f);
-
-        // Render maze
-        for (int i = 0; i < maze.size(); ++i) {
-            for (int j = 0; j < maze[i].size(); ++j) {
-                if (maze[i][j] == 1) { // Wall
-                    glm::mat4 cubeModel = glm::mat4(1.0f);
-                    cubeModel = glm::translate(cubeModel,
-                                               glm::vec3(j - maze[0].size() / 2, -0.5f, i - maze.size() / 2));
-                    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(cubeModel));
-                    glBindVertexArray(cubeVAO);
-                    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+    glfwSetCursorPosCallback(window, mouse_callback);
+
+    uint64_t tick = 0;
+    if (singleThread) {
+        // render loop
+        // -----------
+        RenderSnapshot snapshot;
+        RenderStats stats;
+        while (!glfwWindowShouldClose(window)) {
+            uint64_t allocations = threadAllocationCount();
+            simulateTick(window, renderer, ++tick, snapshot);
+            bool drawn = renderFrame(renderer, snapshot);
+            if (drawn)
+                captureFrame(capture, 0, snapshot.framebufferWidth, snapshot.framebufferHeight);
+            if (checkAllocations)
+                checkSteadyState("frame", tick, threadAllocationCount() - allocations);
+            if (drawn)
+                glfwSwapBuffers(window);
+            if (updateRenderStats(renderer, snapshot.time, stats))
+                showRenderStats(window, stats);
+            glfwPollEvents();
+        }
+    } else {
+        // GLFW wants window events and input handled on the main thread, so
+        // the main thread simulates and the GL context moves to a render
+        // thread. Each side only ever sees the other's latest published state.
+        TripleBuffer<RenderSnapshot> snapshots;
+        TripleBuffer<RenderStats> stats;
+        std::atomic<bool> stopRendering{false};
+
+        glfwMakeContextCurrent(nullptr);
+        std::thread renderThread([&]() {
+            glfwMakeContextCurrent(window);
+            uint64_t frame = 0;
+            while (!stopRendering.load(std::memory_order_acquire)) {
+                snapshots.update();
+                const RenderSnapshot& snapshot = snapshots.readBuffer();
+                if (snapshot.tick == 0) {
+                    std::this_thread::yield(); // nothing simulated yet
+                    continue;
                 }
+                uint64_t allocations = threadAllocationCount();
+                bool drawn = renderFrame(renderer, snapshot);
+                if (drawn)
+                    captureFrame(capture, 0, snapshot.framebufferWidth, snapshot.framebufferHeight);
+                if (checkAllocations)
+                    checkSteadyState("frame", ++frame, threadAllocationCount() - allocations);
+                if (drawn)
+                    glfwSwapBuffers(window);
+                else
+                    std::this_thread::yield();
+                if (updateRenderStats(renderer, static_cast<float>(glfwGetTime()), stats.writeBuffer()))
+                    stats.publish();
             }
+            glfwMakeContextCurrent(nullptr);
+        });
+
+        double nextTick = glfwGetTime();
+        while (!glfwWindowShouldClose(window)) {
+            // sleep in the event queue until the next step is due
+            glfwWaitEventsTimeout(std::max(0.0, nextTick - glfwGetTime()));
+            double now = glfwGetTime();
+            if (now < nextTick)
+                continue;
+            // after a stall, resume from now instead of replaying missed steps
+            nextTick = std::max(nextTick + SIMULATION_STEP, now);
+
+            uint64_t allocations = threadAllocationCount();
+            simulateTick(window, renderer, ++tick, snapshots.writeBuffer());
+            if (checkAllocations)
+                checkSteadyState("tick", tick, threadAllocationCount() - allocations);
+            snapshots.publish();
+            if (stats.update())
+                showRenderStats(window, stats.readBuffer());
         }
 
-        // Swap buffers and poll events (only once per frame)
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        stopRendering.store(true, std::memory_order_release);
+        renderThread.join();
+        glfwMakeContextCurrent(window);
     }
 
+        // while everything is still allocated
+        if (!memoryReport.empty() && writeMemoryReport(memoryReport))
+            std::cout << "Memory report written to " << memoryReport << std::endl;
+
+        if (networked)
+            disconnectReplicationClient(network);
+
         // Optional: de-allocate all resources once they've outlived their purpose
-        glDeleteVertexArrays(1, &cubeVAO);
-        glDeleteBuffers(1, &cubeVBO);
-        glDeleteBuffers(1, &cubeEBO);
-        glDeleteProgram(shaderProgram);
+        stopFrameCapture(capture);
+        deleteRenderer(renderer);
+        if (showJobStats)
+            printJobSystemStats(jobs);
+        deleteJobSystem(jobs);
 
         // glfw: terminate, clearing all previously allocated GLFW resources.
         glfwTerminate();
+        if (checkAllocations) {
+            if (steadyStateAllocated.load())
+                return 1;
+            std::cout << "Allocation check passed (" << tick << " ticks)" << std::endl;
+        }
         return 0;
     }
 
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
-void processMovement(glm::vec3 direction, float speed, glm::vec3& position, const std::vector<glm::vec3>& walls, float wallSize = 1.0f)
+void processMovement(glm::vec3 direction, float speed, glm::vec3& position)
 {
     glm::vec3 newPos = position + direction * speed;
 
-    for (const auto& wall : walls)
-    {
-        float distanceX = std::abs(newPos.x - wall.x);
-        float distanceZ = std::abs(newPos.z - wall.z);
-
-        // Only check collisions on the X-Z plane
-        if (distanceX < wallSize / 2.0f && distanceZ < wallSize / 2.0f)
-        {
-            return; // Collision detected, do not update position
-        }
-    }
+    // Only check collisions on the X-Z plane
+    bool blocked = fixedLevel ? circleHitsWall(levelWalls, newPos.x, newPos.z, 0.0f)
+                              : circleHitsWall(agents.walls, newPos.x, newPos.z, 0.0f);
+    if (blocked)
+        return; // Collision detected, do not update position
+
+    // agents block the way too, unless one already walked into us
+    const float cameraRadius = 0.2f;
+    nearbyAgents.clear();
+    if (querySpatialHashRadius(agents.nearby, glm::vec2(newPos.x, newPos.z), AGENT_RADIUS + cameraRadius,
+                               nearbyAgents) > 0 &&
+        querySpatialHashRadius(agents.nearby, glm::vec2(position.x, position.z), AGENT_RADIUS + cameraRadius,
+                               nearbyAgents) == 0)
+        return;
 
     // Update position if no collision is detected
     position.x = newPos.x;
     position.z = newPos.z;
 }
-void processInput(GLFWwindow *window)
+// Put up or knock down one wall: the grid, the collision walls and the
+// agents' walls change now, the renderer catches up on its next frame
+void editMazeCell(int row, int col, bool wall)
 {
-    std::vector<glm::vec3> wallCoordinates;
-
-
-    for (int i = 0; i < maze.size(); ++i) {
-        for (int j = 0; j < maze[i].size(); ++j) {
-            if (maze[i][j] == 1) { // If it's a wall
-                // Calculate the world coordinates
-                glm::vec3 wallPosition(
-                        j - maze[0].size() / 2, // X coordinate (adjusted for centering)
-                        0.0f,                  // Y coordinate (fixed at ground level)
-                        i - maze.size() / 2    // Z coordinate (adjusted for centering)
-                );
+    MazeEdit edit;
+    edit.row = row;
+    edit.col = col;
+    edit.wall = wall;
+    if (!applyMazeEdit(maze, agents.walls, edit))
+        return;
+    if (fixedLevel)
+        levelWalls.setWall(row, col, wall);
+    agentWallChanged(agents, row, col);
+    queueMazeEdit(mazeEdits, edit);
+}
 
-                // Store the wall position
-                wallCoordinates.push_back(wallPosition);
-            }
-        }
+// One wall between two corridor cells comes down and another goes up,
+// somewhere in the maze; rooms and the pillars between them stay. The maze
+// may split for a while, until a later shift joins it again.
+void shiftWalls()
+{
+    int rows = static_cast<int>(maze.size());
+    int cols = rows ? static_cast<int>(maze[0].size()) : 0;
+    if (rows < 3 || cols < 3)
+        return;
+    int cameraRow = static_cast<int>(std::floor(cameraPos.z + 0.5f)) + rows / 2;
+    int cameraCol = static_cast<int>(std::floor(cameraPos.x + 0.5f)) + cols / 2;
+    bool opened = false, closed = false;
+    for (int attempt = 0; attempt < 64 && !(opened && closed); ++attempt) {
+        int row = 1 + rand() % (rows - 2);
+        int col = 1 + rand() % (cols - 2);
+        if ((row + col) % 2 == 0)
+            continue;
+        bool wall = maze[row][col] == 1;
+        if ((wall && opened) || (!wall && (closed || (row == cameraRow && col == cameraCol))))
+            continue;
+        editMazeCell(row, col, !wall);
+        (wall ? opened : closed) = true;
     }
+}
 
+// The cell one step ahead of the camera flips between wall and corridor; the
+// outer wall and the camera's own cell stay as they are
+void toggleWallInFront()
+{
+    int rows = static_cast<int>(maze.size());
+    int cols = rows ? static_cast<int>(maze[0].size()) : 0;
+    glm::vec3 ahead = cameraPos + glm::normalize(glm::vec3(cameraFront.x, 0.0f, cameraFront.z));
+    int row = static_cast<int>(std::floor(ahead.z + 0.5f)) + rows / 2;
+    int col = static_cast<int>(std::floor(ahead.x + 0.5f)) + cols / 2;
+    int cameraRow = static_cast<int>(std::floor(cameraPos.z + 0.5f)) + rows / 2;
+    int cameraCol = static_cast<int>(std::floor(cameraPos.x + 0.5f)) + cols / 2;
+    if (row <= 0 || col <= 0 || row >= rows - 1 || col >= cols - 1 || (row == cameraRow && col == cameraCol))
+        return;
+    editMazeCell(row, col, maze[row][col] == 0);
+}
 
-
-
-
+void processInput(GLFWwindow *window)
+{
     //ogranichuvanje za dvizhenje
     float minX = -10.0f;
     float maxX = 10.0f;
@@ -334,21 +590,26 @@ void processInput(GLFWwindow *window)
     }
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
+    static bool editHeld = false;
+    bool editPressed = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
+    if (editPressed && !editHeld)
+        toggleWallInFront();
+    editHeld = editPressed;
     if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
     {
-        processMovement(cameraFront, cameraSpeed, cameraPos, wallCoordinates);
+        processMovement(cameraFront, cameraSpeed, cameraPos);
     }
     if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
     {
-        processMovement(-cameraFront, cameraSpeed, cameraPos, wallCoordinates);
+        processMovement(-cameraFront, cameraSpeed, cameraPos);
     }
     if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
     {
-        processMovement(-glm::normalize(glm::cross(cameraFront, cameraUp)), cameraSpeed, cameraPos, wallCoordinates);
+        processMovement(-glm::normalize(glm::cross(cameraFront, cameraUp)), cameraSpeed, cameraPos);
     }
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
     {
-        processMovement(glm::normalize(glm::cross(cameraFront, cameraUp)), cameraSpeed, cameraPos, wallCoordinates);
+        processMovement(glm::normalize(glm::cross(cameraFront, cameraUp)), cameraSpeed, cameraPos);
     }
     if (!isJumping && glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
     {
@@ -387,11 +648,11 @@ void processInput(GLFWwindow *window)
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 // ---------------------------------------------------------------------------------------------
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+void framebuffer_size_callback(GLFWwindow*, int, int)
 {
-    // make sure the viewport matches the new window dimensions; note that width and
-    // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    // nothing to do here: the renderer reads the framebuffer size from every
+    // snapshot and sets the viewport itself (this runs on the main thread,
+    // which does not own the GL context)
 }
 bool firstMouse = true;
 float lastX = 400, lastY = 400;
@@ -429,4 +690,36 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos)
     direction.y = sin(glm::radians(pitch));
     direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
     cameraFront = glm::normalize(direction);
-}
\ No newline at end of file
+}
+// --connect: the keys and the view go to the server, the camera comes back
+// from it. There is no prediction, so moving lags by a round trip; looking
+// around does not, as the view angles stay local.
+void networkInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+    const int keys[][2] = {{GLFW_KEY_W, BUTTON_FORWARD}, {GLFW_KEY_S, BUTTON_BACK},
+                           {GLFW_KEY_A, BUTTON_LEFT},    {GLFW_KEY_D, BUTTON_RIGHT},
+                           {GLFW_KEY_SPACE, BUTTON_JUMP}, {GLFW_KEY_LEFT_CONTROL, BUTTON_CROUCH}};
+    PlayerInput input;
+    input.yaw = yaw;
+    input.pitch = pitch;
+    for (const auto& key : keys)
+        if (glfwGetKey(window, key[0]) == GLFW_PRESS)
+            input.buttons |= static_cast<uint8_t>(key[1]);
+    sendPlayerInput(network, input);
+    if (!receiveSnapshots(network))
+        return;
+
+    remotePlayers.clear();
+    for (const NetPlayer& player : latestSnapshot(network).players) {
+        PlayerState state = dequantizePlayer(player, network.mazeRows, network.mazeCols);
+        if (player.id == network.player) {
+            cameraPos = state.position;
+            continue;
+        }
+        glm::vec3 front = playerFront(state.yaw, state.pitch);
+        remotePlayers.push_back(glm::vec4(state.position.x, state.position.z, std::atan2(front.x, front.z),
+                                          (player.id * 37 % 101) / 101.0f));
+    }
+}
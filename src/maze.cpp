@@ -0,0 +1,53 @@
+#include <maze.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <random>
+
+void generateMaze(std::vector<std::vector<int>>& maze, int rows, int cols) {
+    generateMaze(maze, rows, cols, std::random_device{}());
+}
+
+void generateMaze(std::vector<std::vector<int>>& maze, int rows, int cols, uint32_t seed) {
+    // Initialize the maze with walls
+    maze.resize(rows, std::vector<int>(cols, 1));
+
+    // one engine for the whole maze rather than a freshly seeded one per cell;
+    // the engine and std::shuffle are implementation-defined, so a seed
+    // reproduces a maze with one standard library, not across them
+    std::default_random_engine rng(seed);
+
+    // Start recursive backtracking from a random cell
+    std::function<void(int, int)> carve = [&](int x, int y) {
+        maze[x][y] = 0; // Mark the current cell as a path
+
+        // Directions for moving (right, down, left, up), on the stack
+        std::array<std::pair<int, int>, 4> directions = {{{0, 2}, {2, 0}, {0, -2}, {-2, 0}}};
+        std::shuffle(directions.begin(), directions.end(), rng);
+
+        for (auto& [dx, dy] : directions) {
+            int nx = x + dx, ny = y + dy;
+            if (nx > 0 && nx < rows - 1 && ny > 0 && ny < cols - 1 && maze[nx][ny] == 1) {
+                // Break the wall between cells
+                maze[x + dx / 2][y + dy / 2] = 0;
+                carve(nx, ny);
+            }
+        }
+    };
+
+    carve(1, 1); // Start carving from (1, 1)
+}
+
+void packMaze(const std::vector<std::vector<int>>& maze, MazeBits& bits) {
+    bits.rows = static_cast<int>(maze.size());
+    bits.cols = bits.rows ? static_cast<int>(maze[0].size()) : 0;
+    bits.wordsPerRow = (bits.cols + 31) / 32;
+    bits.words.assign(bits.rows * bits.wordsPerRow, 0u);
+    for (int i = 0; i < bits.rows; ++i) {
+        for (int j = 0; j < bits.cols; ++j) {
+            if (maze[i][j] == 1)
+                bits.setWall(i, j, true);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#include <maze_edit.hpp>
+#include <maze_mesh.hpp>
+
+#include <algorithm>
+
+void queueMazeEdit(MazeEditQueue& queue, const MazeEdit& edit) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.edits.push_back(edit);
+}
+
+void takeMazeEdits(MazeEditQueue& queue, std::vector<MazeEdit>& edits) {
+    edits.clear();
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    edits.swap(queue.edits);
+}
+
+bool applyMazeEdit(std::vector<std::vector<int>>& maze, MazeBits& bits, const MazeEdit& edit) {
+    if (edit.row < 0 || edit.col < 0 || edit.row >= bits.rows || edit.col >= bits.cols ||
+        bits.isWall(edit.row, edit.col) == edit.wall)
+        return false;
+    maze[edit.row][edit.col] = edit.wall ? 1 : 0;
+    bits.setWall(edit.row, edit.col, edit.wall);
+    return true;
+}
+
+void chunksTouchingCell(int rows, int cols, int row, int col, std::vector<int>& chunks) {
+    int chunksX = (cols + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    int firstX = std::max(col - 1, 0) / CHUNK_SIZE, lastX = std::min(col + 1, cols - 1) / CHUNK_SIZE;
+    int firstZ = std::max(row - 1, 0) / CHUNK_SIZE, lastZ = std::min(row + 1, rows - 1) / CHUNK_SIZE;
+    for (int chunkZ = firstZ; chunkZ <= lastZ; ++chunkZ) {
+        for (int chunkX = firstX; chunkX <= lastX; ++chunkX) {
+            int chunk = chunkZ * chunksX + chunkX;
+            if (std::find(chunks.begin(), chunks.end(), chunk) == chunks.end())
+                chunks.push_back(chunk);
+        }
+    }
+}
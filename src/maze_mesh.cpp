@@ -0,0 +1,310 @@
+#include <maze_mesh.hpp>
+#include <maze.hpp>
+#include <memory_stats.hpp>
+
+#include <algorithm>
+
+namespace {
+
+// Each wall cell gets its four sides and its top as separate quads, so every
+// face has its own vertices (and occlusion values). Sides that touch another
+// wall and the bottom, which is below the floor, are never visible.
+const int maxFacesPerCell = 5;
+const int faceVertexCount = 4;
+const int faceIndexCount = 6;
+
+// Occlusion level (0 = darkest, 3 = open) to brightness; matches
+// occlusionCurve in shaders/pulled_walls.vert
+const float occlusionCurve[4] = {0.45f, 0.65f, 0.85f, 1.0f};
+
+// Outward side directions as (row, col) steps
+const int sideDirections[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+// Same convention as isWall() in shaders/maze_bits.glsl: outside is open
+bool wallAt(const std::vector<std::vector<int>>& maze, int rows, int cols, int row, int col) {
+    return row >= 0 && col >= 0 && row < rows && col < cols && maze[row][col] == 1;
+}
+
+struct FaceVertex {
+    glm::vec3 position;
+    float occlusion;
+};
+
+// Append one quad (corners in order around the face) with `normal` facing
+// out; the split diagonal follows the occlusion so gradients stay symmetric
+void appendFace(ChunkGeometry& geometry, GLuint& localVertex, const FaceVertex (&corners)[4], const glm::vec3& normal) {
+    int order[4] = {0, 1, 2, 3};
+    glm::vec3 faceNormal = glm::cross(corners[1].position - corners[0].position,
+                                      corners[2].position - corners[0].position);
+    if (glm::dot(faceNormal, normal) < 0.0f)
+        std::swap(order[1], order[3]); // keep counter-clockwise from outside
+
+    for (int k : order) {
+        const FaceVertex& corner = corners[k];
+        geometry.vertices.push_back(corner.position.x);
+        geometry.vertices.push_back(corner.position.y);
+        geometry.vertices.push_back(corner.position.z);
+        geometry.vertices.push_back(corner.occlusion);
+        geometry.boundsMin = glm::min(geometry.boundsMin, corner.position);
+        geometry.boundsMax = glm::max(geometry.boundsMax, corner.position);
+    }
+
+    const FaceVertex* v[4] = {&corners[order[0]], &corners[order[1]], &corners[order[2]], &corners[order[3]]};
+    static const unsigned int along02[faceIndexCount] = {0, 1, 2, 2, 3, 0};
+    static const unsigned int along13[faceIndexCount] = {1, 2, 3, 3, 0, 1};
+    bool flip = v[0]->occlusion + v[2]->occlusion < v[1]->occlusion + v[3]->occlusion;
+    for (unsigned int index : flip ? along13 : along02)
+        geometry.indices.push_back(localVertex + index);
+    localVertex += faceVertexCount;
+}
+
+} // namespace
+
+void initMazeMesh(MazeMesh& mesh, int rows, int cols, int slotCount) {
+    mesh.rows = rows;
+    mesh.cols = cols;
+    mesh.chunksX = (cols + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    mesh.chunksZ = (rows + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    mesh.slotVertices = CHUNK_SIZE * CHUNK_SIZE * maxFacesPerCell * faceVertexCount;
+    mesh.slotIndices = CHUNK_SIZE * CHUNK_SIZE * maxFacesPerCell * faceIndexCount;
+    mesh.nonEmptyChunks = 0;
+
+    int chunkCount = mesh.chunksX * mesh.chunksZ;
+    mesh.slotCount = slotCount > 0 ? std::min(slotCount, chunkCount) : chunkCount;
+    mesh.chunks.assign(chunkCount, MazeChunk());
+    for (MazeChunk& chunk : mesh.chunks) {
+        chunk.boundsMin = chunk.boundsMax = glm::vec3(0.0f);
+        chunk.firstIndex = 0;
+        chunk.indexCount = 0;
+        chunk.baseVertex = 0;
+        chunk.slot = -1;
+        chunk.state = CHUNK_UNMESHED;
+    }
+    // popped from the back, so slots fill up from the start of the buffers
+    mesh.freeSlots.resize(mesh.slotCount);
+    for (int i = 0; i < mesh.slotCount; ++i)
+        mesh.freeSlots[i] = mesh.slotCount - 1 - i;
+    reportCpuMemory(MEMORY_MESHES, &mesh,
+                    mesh.chunks.capacity() * sizeof(MazeChunk) + mesh.freeSlots.capacity() * sizeof(int));
+
+    if (!mesh.vao) {
+        glGenVertexArrays(1, &mesh.vao);
+        glGenBuffers(1, &mesh.vbo);
+        glGenBuffers(1, &mesh.ebo);
+    }
+    glBindVertexArray(mesh.vao);
+
+    GLsizeiptr vertexBytes = static_cast<GLsizeiptr>(mesh.slotCount) * mesh.slotVertices * MESH_VERTEX_FLOATS *
+                             sizeof(float);
+    GLsizeiptr indexBytes = static_cast<GLsizeiptr>(mesh.slotCount) * mesh.slotIndices * sizeof(unsigned int);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, nullptr, GL_STATIC_DRAW);
+    trackBufferMemory(MEMORY_MESHES, mesh.vbo, vertexBytes);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, nullptr, GL_STATIC_DRAW);
+    trackBufferMemory(MEMORY_MESHES, mesh.ebo, indexBytes);
+
+    const GLsizei stride = MESH_VERTEX_FLOATS * sizeof(float);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *) 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, stride, (void *) (3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+}
+
+size_t mazeMeshSlotBytes() {
+    size_t faces = CHUNK_SIZE * CHUNK_SIZE * maxFacesPerCell;
+    return faces * (faceVertexCount * MESH_VERTEX_FLOATS * sizeof(float) + faceIndexCount * sizeof(unsigned int));
+}
+
+bool acquireChunkSlot(MazeMesh& mesh, int index) {
+    MazeChunk& chunk = mesh.chunks[index];
+    if (chunk.slot >= 0)
+        return true;
+    if (mesh.freeSlots.empty())
+        return false;
+    chunk.slot = mesh.freeSlots.back();
+    mesh.freeSlots.pop_back();
+    chunk.firstIndex = static_cast<GLuint>(chunk.slot * mesh.slotIndices);
+    chunk.baseVertex = static_cast<GLint>(chunk.slot * mesh.slotVertices);
+    return true;
+}
+
+void evictMazeChunk(MazeMesh& mesh, int index) {
+    MazeChunk& chunk = mesh.chunks[index];
+    if (chunk.state != CHUNK_RESIDENT)
+        return;
+    --mesh.nonEmptyChunks;
+    chunk.indexCount = 0;
+    chunk.state = CHUNK_EVICTED;
+    mesh.freeSlots.push_back(chunk.slot);
+    chunk.slot = -1;
+}
+
+void meshMazeChunk(const std::vector<std::vector<int>>& maze, int chunkX, int chunkZ, ChunkGeometry& geometry) {
+    int rows = static_cast<int>(maze.size());
+    int cols = rows ? static_cast<int>(maze[0].size()) : 0;
+    geometry = ChunkGeometry();
+
+    GLuint localVertex = 0;
+    for (int i = chunkZ * CHUNK_SIZE; i < std::min(rows, (chunkZ + 1) * CHUNK_SIZE); ++i) {
+        for (int j = chunkX * CHUNK_SIZE; j < std::min(cols, (chunkX + 1) * CHUNK_SIZE); ++j) {
+            if (maze[i][j] != 1)
+                continue;
+            glm::vec3 centre = mazeCellPosition(i, j, rows, cols);
+
+            // sides: baked ambient occlusion from the grid. Along a vertical
+            // edge the face meets a perpendicular wall when the cell beside
+            // the open neighbour is a wall; the bottom edge also meets the floor.
+            for (const int* dir : sideDirections) {
+                int openRow = i + dir[0], openCol = j + dir[1];
+                if (wallAt(maze, rows, cols, openRow, openCol))
+                    continue;
+                glm::vec3 normal(static_cast<float>(dir[1]), 0.0f, static_cast<float>(dir[0]));
+                glm::vec3 tangent(normal.z, 0.0f, normal.x);
+                glm::vec3 faceCentre = centre + normal * 0.5f;
+
+                FaceVertex corners[4];
+                for (int side = 0; side < 2; ++side) {
+                    int s = side == 0 ? -1 : 1;
+                    bool corner = wallAt(maze, rows, cols, openRow + s * static_cast<int>(tangent.z),
+                                         openCol + s * static_cast<int>(tangent.x));
+                    glm::vec3 edge = faceCentre + tangent * (0.5f * s);
+                    FaceVertex& bottom = corners[side == 0 ? 0 : 1];
+                    FaceVertex& top = corners[side == 0 ? 3 : 2];
+                    bottom.position = glm::vec3(edge.x, WALL_BOTTOM, edge.z);
+                    bottom.occlusion = occlusionCurve[corner ? 0 : 2];
+                    top.position = glm::vec3(edge.x, WALL_TOP, edge.z);
+                    top.occlusion = occlusionCurve[corner ? 2 : 3];
+                }
+                appendFace(geometry, localVertex, corners, normal);
+            }
+
+            // top: nothing above it, never occluded
+            FaceVertex corners[4] = {
+                {centre + glm::vec3(-0.5f, WALL_TOP, -0.5f), 1.0f},
+                {centre + glm::vec3(0.5f, WALL_TOP, -0.5f), 1.0f},
+                {centre + glm::vec3(0.5f, WALL_TOP, 0.5f), 1.0f},
+                {centre + glm::vec3(-0.5f, WALL_TOP, 0.5f), 1.0f},
+            };
+            appendFace(geometry, localVertex, corners, glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+    }
+}
+
+void setMazeChunkGeometry(MazeMesh& mesh, int index, const ChunkGeometry& geometry) {
+    MazeChunk& chunk = mesh.chunks[index];
+    if (chunk.state == CHUNK_RESIDENT)
+        --mesh.nonEmptyChunks;
+    chunk.indexCount = static_cast<GLuint>(geometry.indices.size());
+    if (chunk.indexCount == 0) {
+        chunk.boundsMin = chunk.boundsMax = glm::vec3(0.0f);
+        chunk.state = CHUNK_EMPTY;
+        // walls removed: the slot can go to another chunk
+        if (chunk.slot >= 0) {
+            mesh.freeSlots.push_back(chunk.slot);
+            chunk.slot = -1;
+        }
+    } else {
+        chunk.boundsMin = geometry.boundsMin;
+        chunk.boundsMax = geometry.boundsMax;
+        chunk.state = CHUNK_RESIDENT;
+        ++mesh.nonEmptyChunks;
+    }
+}
+
+void mazeChunkFootprint(const MazeMesh& mesh, int index, glm::vec3& boundsMin, glm::vec3& boundsMax) {
+    int chunkX = index % mesh.chunksX;
+    int chunkZ = index / mesh.chunksX;
+    int lastRow = std::min(mesh.rows, (chunkZ + 1) * CHUNK_SIZE) - 1;
+    int lastCol = std::min(mesh.cols, (chunkX + 1) * CHUNK_SIZE) - 1;
+    boundsMin = mazeCellPosition(chunkZ * CHUNK_SIZE, chunkX * CHUNK_SIZE, mesh.rows, mesh.cols, WALL_BOTTOM) -
+                glm::vec3(0.5f, 0.0f, 0.5f);
+    boundsMax = mazeCellPosition(lastRow, lastCol, mesh.rows, mesh.cols, WALL_TOP) + glm::vec3(0.5f, 0.0f, 0.5f);
+}
+
+void deleteMazeMesh(MazeMesh& mesh) {
+    untrackBufferMemory(mesh.vbo);
+    untrackBufferMemory(mesh.ebo);
+    forgetCpuMemory(&mesh);
+    glDeleteVertexArrays(1, &mesh.vao);
+    glDeleteBuffers(1, &mesh.vbo);
+    glDeleteBuffers(1, &mesh.ebo);
+    mesh.vao = mesh.vbo = mesh.ebo = 0;
+    mesh.chunks.clear();
+    mesh.freeSlots.clear();
+}
+
+void cullMazeChunks(const MazeMesh& mesh, const Frustum& frustum, const LodSettings& lod,
+                    const glm::vec3& cameraPosition, std::vector<GLuint>& meshChunks,
+                    std::vector<GLuint>& impostorChunks, CullStats& stats) {
+    meshChunks.clear();
+    impostorChunks.clear();
+    stats = CullStats();
+    int chunkCount = mesh.chunksX * mesh.chunksZ;
+    stats.chunks = chunkCount;
+    for (int i = 0; i < chunkCount; ++i) {
+        glm::vec3 boundsMin, boundsMax;
+        mazeChunkFootprint(mesh, i, boundsMin, boundsMax);
+        if (!aabbInFrustum(frustum, boundsMin, boundsMax)) {
+            ++stats.frustumRejected;
+            continue;
+        }
+
+        float nearest = 0.0f, farthest = 0.0f;
+        if (lod.impostors)
+            aabbDistanceRangeXZ(cameraPosition, boundsMin, boundsMax, nearest, farthest);
+        if (!lod.impostors || nearest < lod.impostorEnd) {
+            meshChunks.push_back(static_cast<GLuint>(i));
+            ++stats.drawn;
+        }
+        if (lod.impostors && farthest > lod.impostorStart) {
+            impostorChunks.push_back(static_cast<GLuint>(i));
+            ++stats.impostors;
+        }
+    }
+}
+
+int occlusionCullChunks(const MazeMesh& mesh, const OcclusionBuffer& occlusion, std::vector<GLuint>& chunks) {
+    size_t kept = 0;
+    for (GLuint index : chunks) {
+        const MazeChunk& chunk = mesh.chunks[index];
+        if (!aabbOccluded(occlusion, chunk.boundsMin, chunk.boundsMax))
+            chunks[kept++] = index;
+    }
+    int dropped = static_cast<int>(chunks.size() - kept);
+    chunks.resize(kept);
+    return dropped;
+}
+
+int dropEmptyChunks(const MazeMesh& mesh, std::vector<GLuint>& chunks) {
+    size_t kept = 0;
+    for (GLuint index : chunks) {
+        if (mesh.chunks[index].indexCount > 0)
+            chunks[kept++] = index;
+    }
+    int dropped = static_cast<int>(chunks.size() - kept);
+    chunks.resize(kept);
+    return dropped;
+}
+
+int dropChunksWithoutWalls(const MazeMesh& mesh, std::vector<GLuint>& chunks) {
+    size_t kept = 0;
+    for (GLuint index : chunks) {
+        ChunkState state = mesh.chunks[index].state;
+        if (state == CHUNK_RESIDENT || state == CHUNK_EVICTED)
+            chunks[kept++] = index;
+    }
+    int dropped = static_cast<int>(chunks.size() - kept);
+    chunks.resize(kept);
+    return dropped;
+}
+
+void drawMazeChunkList(const MazeMesh& mesh, const std::vector<GLuint>& chunks) {
+    glBindVertexArray(mesh.vao);
+    for (GLuint index : chunks) {
+        const MazeChunk& chunk = mesh.chunks[index];
+        glDrawElementsBaseVertex(GL_TRIANGLES, chunk.indexCount, GL_UNSIGNED_INT,
+                                 (void *) (chunk.firstIndex * sizeof(unsigned int)), chunk.baseVertex);
+    }
+}
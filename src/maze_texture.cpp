@@ -0,0 +1,33 @@
+#include <maze_texture.hpp>
+#include <memory_stats.hpp>
+
+GLuint createMazeBitsTexture(const MazeBits& bits) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, bits.wordsPerRow, bits.rows, 0, GL_RED_INTEGER, GL_UNSIGNED_INT,
+                 bits.words.data());
+    trackTextureMemory(MEMORY_MAZE, texture, static_cast<size_t>(bits.wordsPerRow) * bits.rows * texelBytes(GL_R32UI));
+    // integer textures must not be filtered
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+void updateMazeBitsTexel(GLuint texture, const MazeBits& bits, int row, int col) {
+    int word = col >> 5;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, word, row, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT,
+                    &bits.words[row * bits.wordsPerRow + word]);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void bindMazeBitsTexture(GLuint program, GLuint texture, const MazeBits& bits, int unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glUniform1i(glGetUniformLocation(program, "mazeBits"), unit);
+    glUniform2i(glGetUniformLocation(program, "mazeSize"), bits.cols, bits.rows);
+}
@@ -0,0 +1,162 @@
+#include <memory_stats.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+const char* const tagNames[MEMORY_TAG_COUNT] = {
+    "maze", "meshes", "streaming", "paths", "textures", "lights", "shadows", "agents", "culling", "targets",
+};
+
+struct MemoryRecord {
+    MemoryTag tag;
+    size_t bytes;
+};
+
+// Buffers and textures have separate name spaces
+const uint64_t TEXTURE_KEY = uint64_t(1) << 32;
+
+struct MemoryRegistry {
+    std::mutex mutex;
+    std::unordered_map<const void*, MemoryRecord> cpu;
+    std::unordered_map<uint64_t, MemoryRecord> gpu;
+    size_t budget[MEMORY_TAG_COUNT] = {};
+};
+
+MemoryRegistry& registry() {
+    static MemoryRegistry instance;
+    return instance;
+}
+
+void trackGpu(MemoryTag tag, uint64_t key, size_t bytes) {
+    MemoryRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.gpu[key] = MemoryRecord{tag, bytes};
+}
+
+void untrackGpu(uint64_t key) {
+    MemoryRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.gpu.erase(key);
+}
+
+} // namespace
+
+const char* memoryTagName(MemoryTag tag) {
+    return tagNames[tag];
+}
+
+bool parseMemoryTag(const std::string& name, MemoryTag& tag) {
+    for (int i = 0; i < MEMORY_TAG_COUNT; ++i) {
+        if (name == tagNames[i]) {
+            tag = static_cast<MemoryTag>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void reportCpuMemory(MemoryTag tag, const void* owner, size_t bytes) {
+    MemoryRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.cpu[owner] = MemoryRecord{tag, bytes};
+}
+
+void forgetCpuMemory(const void* owner) {
+    MemoryRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.cpu.erase(owner);
+}
+
+void trackBufferMemory(MemoryTag tag, GLuint buffer, size_t bytes) {
+    trackGpu(tag, buffer, bytes);
+}
+
+void trackTextureMemory(MemoryTag tag, GLuint texture, size_t bytes) {
+    trackGpu(tag, TEXTURE_KEY | texture, bytes);
+}
+
+void untrackBufferMemory(GLuint buffer) {
+    if (buffer)
+        untrackGpu(buffer);
+}
+
+void untrackTextureMemory(GLuint texture) {
+    if (texture)
+        untrackGpu(TEXTURE_KEY | texture);
+}
+
+size_t texelBytes(GLenum internalFormat) {
+    switch (internalFormat) {
+    case GL_R8:
+        return 1;
+    case GL_RGBA8:
+    case GL_R32F:
+    case GL_R32UI:
+    case GL_DEPTH_COMPONENT32F:
+        return 4;
+    case GL_RG32UI:
+        return 8;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        std::cout << "ERROR::MEMORY_STATS::UNKNOWN_FORMAT " << internalFormat << std::endl;
+        return 4;
+    }
+}
+
+void setMemoryBudget(MemoryTag tag, size_t bytes) {
+    MemoryRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.budget[tag] = bytes;
+}
+
+size_t memoryBudget(MemoryTag tag) {
+    MemoryRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    return r.budget[tag];
+}
+
+void readMemoryUsage(MemoryUsage& usage) {
+    usage = MemoryUsage();
+    MemoryRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto& entry : r.cpu)
+        usage.cpu[entry.second.tag] += entry.second.bytes;
+    for (const auto& entry : r.gpu)
+        usage.gpu[entry.second.tag] += entry.second.bytes;
+    for (int i = 0; i < MEMORY_TAG_COUNT; ++i) {
+        usage.budget[i] = r.budget[i];
+        usage.cpuTotal += usage.cpu[i];
+        usage.gpuTotal += usage.gpu[i];
+    }
+}
+
+bool memoryOverBudget(const MemoryUsage& usage, MemoryTag tag) {
+    return usage.budget[tag] > 0 && usage.cpu[tag] + usage.gpu[tag] > usage.budget[tag];
+}
+
+bool writeMemoryReport(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cout << "ERROR::MEMORY_STATS::FILE_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+
+    MemoryUsage usage;
+    readMemoryUsage(usage);
+    file << "{\n  \"tags\": {\n";
+    for (int i = 0; i < MEMORY_TAG_COUNT; ++i) {
+        MemoryTag tag = static_cast<MemoryTag>(i);
+        file << "    \"" << tagNames[i] << "\": {\"cpu\": " << usage.cpu[i] << ", \"gpu\": " << usage.gpu[i]
+             << ", \"budget\": " << usage.budget[i] << ", \"overBudget\": "
+             << (memoryOverBudget(usage, tag) ? "true" : "false") << "}" << (i + 1 < MEMORY_TAG_COUNT ? "," : "")
+             << "\n";
+    }
+    file << "  },\n  \"total\": {\"cpu\": " << usage.cpuTotal << ", \"gpu\": " << usage.gpuTotal << "}\n}\n";
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,120 @@
+#include <minimap.hpp>
+#include <memory_stats.hpp>
+#include <maze_texture.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// continuous (col, row) of a world position; inverse of mazeCellPosition
+glm::vec2 worldToCell(const glm::vec3& position, int rows, int cols) {
+    return glm::vec2(position.x + cols / 2 + 0.5f, position.z + rows / 2 + 0.5f);
+}
+
+} // namespace
+
+bool initMinimap(Minimap& minimap, const MazeBits& bits) {
+    minimap.program.stages = {{GL_VERTEX_SHADER, shaderPath("fullscreen.vert")},
+                              {GL_FRAGMENT_SHADER, shaderPath("minimap.frag")}};
+    if (!buildShaderProgram(minimap.program))
+        return false;
+
+    minimap.rows = bits.rows;
+    minimap.cols = bits.cols;
+    minimap.explored.assign(bits.rows * bits.cols, 0);
+
+    glGenVertexArrays(1, &minimap.emptyVao);
+    glGenTextures(1, &minimap.exploredTexture);
+    glBindTexture(GL_TEXTURE_2D, minimap.exploredTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, bits.cols, bits.rows, 0, GL_RED, GL_UNSIGNED_BYTE,
+                 minimap.explored.data());
+    trackTextureMemory(MEMORY_MAZE, minimap.exploredTexture, static_cast<size_t>(bits.cols) * bits.rows);
+    reportCpuMemory(MEMORY_MAZE, &minimap, minimap.explored.capacity());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return true;
+}
+
+void updateMinimapExplored(Minimap& minimap, const glm::vec3& playerPosition) {
+    glm::vec2 cell = worldToCell(playerPosition, minimap.rows, minimap.cols);
+    int row = static_cast<int>(std::floor(cell.y));
+    int col = static_cast<int>(std::floor(cell.x));
+    if (row == minimap.lastRow && col == minimap.lastCol)
+        return;
+    minimap.lastRow = row;
+    minimap.lastCol = col;
+
+    int row0 = std::max(0, row - MINIMAP_REVEAL_RADIUS);
+    int row1 = std::min(minimap.rows - 1, row + MINIMAP_REVEAL_RADIUS);
+    int col0 = std::max(0, col - MINIMAP_REVEAL_RADIUS);
+    int col1 = std::min(minimap.cols - 1, col + MINIMAP_REVEAL_RADIUS);
+    if (row0 > row1 || col0 > col1)
+        return; // outside the maze
+
+    bool changed = false;
+    for (int i = row0; i <= row1; ++i) {
+        for (int j = col0; j <= col1; ++j) {
+            uint8_t& seen = minimap.explored[i * minimap.cols + j];
+            changed |= seen == 0;
+            seen = 255;
+        }
+    }
+    if (!changed)
+        return;
+
+    // upload only the revealed rectangle, straight out of the CPU mirror
+    glBindTexture(GL_TEXTURE_2D, minimap.exploredTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, minimap.cols);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, col0, row0, col1 - col0 + 1, row1 - row0 + 1, GL_RED, GL_UNSIGNED_BYTE,
+                    &minimap.explored[row0 * minimap.cols + col0]);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void drawMinimap(const Minimap& minimap, GLuint bitsTexture, const MazeBits& bits,
+                 const glm::vec3& playerPosition, const glm::vec3& playerFront,
+                 int framebufferWidth, int framebufferHeight) {
+    int size = std::min(minimap.sizePixels, std::min(framebufferWidth, framebufferHeight) / 3);
+    int margin = 10;
+    // keep the maze's aspect ratio inside the square
+    int width = bits.cols >= bits.rows ? size : size * bits.cols / bits.rows;
+    int height = bits.rows >= bits.cols ? size : size * bits.rows / bits.cols;
+    glViewport(framebufferWidth - width - margin, framebufferHeight - height - margin, width, height);
+
+    GLuint program = minimap.program.id;
+    glUseProgram(program);
+    bindMazeBitsTexture(program, bitsTexture, bits, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, minimap.exploredTexture);
+    glUniform1i(glGetUniformLocation(program, "explored"), 1);
+
+    glm::vec2 cell = worldToCell(playerPosition, bits.rows, bits.cols);
+    glm::vec2 heading(playerFront.x, playerFront.z);
+    heading = glm::length(heading) > 1e-4f ? glm::normalize(heading) : glm::vec2(0.0f, -1.0f);
+    glUniform2f(glGetUniformLocation(program, "playerCell"), cell.x, cell.y);
+    glUniform2f(glGetUniformLocation(program, "playerHeading"), heading.x, heading.y);
+
+    glDisable(GL_DEPTH_TEST);
+    glBindVertexArray(minimap.emptyVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEnable(GL_DEPTH_TEST);
+    glActiveTexture(GL_TEXTURE0);
+    glViewport(0, 0, framebufferWidth, framebufferHeight);
+}
+
+void deleteMinimap(Minimap& minimap) {
+    deleteShaderProgram(minimap.program);
+    untrackTextureMemory(minimap.exploredTexture);
+    forgetCpuMemory(&minimap);
+    glDeleteTextures(1, &minimap.exploredTexture);
+    glDeleteVertexArrays(1, &minimap.emptyVao);
+    minimap.exploredTexture = minimap.emptyVao = 0;
+    minimap.explored.clear();
+}
@@ -0,0 +1,171 @@
+#include <net.hpp>
+
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using NativeSocket = SOCKET;
+using SocketLength = int;
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using NativeSocket = int;
+using SocketLength = socklen_t;
+#endif
+
+namespace {
+
+// A server hears from every client every tick; at the default size (about
+// 256 datagrams on Linux) the kernel drops what arrives past that
+const int RECEIVE_BUFFER_BYTES = 1 << 20;
+
+#ifdef _WIN32
+const intptr_t NO_SOCKET = static_cast<intptr_t>(INVALID_SOCKET);
+
+bool startNetworking() {
+    static std::once_flag once;
+    static bool started = false;
+    std::call_once(once, [] {
+        WSADATA data;
+        started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    });
+    return started;
+}
+
+// Nothing to read. A datagram that bounced off a closed port shows up as an
+// error on a later read; the socket is fine, so that counts as nothing too.
+bool wouldBlock() {
+    int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAECONNRESET;
+}
+
+void closeHandle(intptr_t handle) {
+    closesocket(static_cast<NativeSocket>(handle));
+}
+#else
+const intptr_t NO_SOCKET = -1;
+
+bool startNetworking() {
+    return true;
+}
+
+bool wouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+void closeHandle(intptr_t handle) {
+    close(static_cast<NativeSocket>(handle));
+}
+#endif
+
+sockaddr_in toSockaddr(const NetAddress& address) {
+    sockaddr_in socketAddress = {};
+    socketAddress.sin_family = AF_INET;
+    socketAddress.sin_addr.s_addr = htonl(address.ip);
+    socketAddress.sin_port = htons(address.port);
+    return socketAddress;
+}
+
+} // namespace
+
+NetAddress loopbackAddress(uint16_t port) {
+    NetAddress address;
+    address.ip = 0x7f000001u;
+    address.port = port;
+    return address;
+}
+
+bool parseNetAddress(const std::string& text, NetAddress& address) {
+    size_t split = text.rfind(':');
+    if (split == std::string::npos)
+        return false;
+    std::string host = text.substr(0, split);
+    unsigned port = 0;
+    if (std::sscanf(text.c_str() + split + 1, "%u", &port) != 1 || port == 0 || port > 65535)
+        return false;
+    unsigned a, b, c, d;
+    char extra;
+    if (host == "localhost") {
+        address = loopbackAddress(static_cast<uint16_t>(port));
+        return true;
+    }
+    if (std::sscanf(host.c_str(), "%u.%u.%u.%u%c", &a, &b, &c, &d, &extra) != 4 || a > 255 || b > 255 ||
+        c > 255 || d > 255)
+        return false;
+    address.ip = a << 24 | b << 16 | c << 8 | d;
+    address.port = static_cast<uint16_t>(port);
+    return true;
+}
+
+bool openUdpSocket(UdpSocket& socket, uint16_t port) {
+    if (!startNetworking()) {
+        std::cout << "ERROR::NET::STARTUP_FAILED" << std::endl;
+        return false;
+    }
+    intptr_t handle = static_cast<intptr_t>(::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP));
+    if (handle == NO_SOCKET) {
+        std::cout << "ERROR::NET::SOCKET_NOT_CREATED" << std::endl;
+        return false;
+    }
+    NetAddress any;
+    any.port = port;
+    sockaddr_in address = toSockaddr(any);
+    NativeSocket native = static_cast<NativeSocket>(handle);
+    bool ok = bind(native, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ok = ok && ioctlsocket(native, FIONBIO, &nonBlocking) == 0;
+#else
+    ok = ok && fcntl(native, F_SETFL, fcntl(native, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+    if (!ok) {
+        std::cout << "ERROR::NET::BIND_FAILED port " << port << std::endl;
+        closeHandle(handle);
+        return false;
+    }
+    // best effort: the system may cap it lower
+    int receiveBuffer = RECEIVE_BUFFER_BYTES;
+    setsockopt(native, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receiveBuffer), sizeof(receiveBuffer));
+    socket.handle = handle;
+    return true;
+}
+
+uint16_t udpSocketPort(const UdpSocket& socket) {
+    sockaddr_in address = {};
+    SocketLength length = sizeof(address);
+    if (getsockname(static_cast<NativeSocket>(socket.handle), reinterpret_cast<sockaddr*>(&address), &length) != 0)
+        return 0;
+    return ntohs(address.sin_port);
+}
+
+bool sendPacket(UdpSocket& socket, const NetAddress& to, const void* data, size_t bytes) {
+    sockaddr_in address = toSockaddr(to);
+    auto sent = sendto(static_cast<NativeSocket>(socket.handle), static_cast<const char*>(data),
+                       static_cast<int>(bytes), 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    return sent == static_cast<decltype(sent)>(bytes);
+}
+
+int receivePacket(UdpSocket& socket, NetAddress& from, void* buffer, size_t capacity) {
+    sockaddr_in address = {};
+    SocketLength length = sizeof(address);
+    auto received = recvfrom(static_cast<NativeSocket>(socket.handle), static_cast<char*>(buffer),
+                             static_cast<int>(capacity), 0, reinterpret_cast<sockaddr*>(&address), &length);
+    if (received < 0)
+        return wouldBlock() ? 0 : -1;
+    from.ip = ntohl(address.sin_addr.s_addr);
+    from.port = ntohs(address.sin_port);
+    return static_cast<int>(received);
+}
+
+void closeUdpSocket(UdpSocket& socket) {
+    if (socket.handle != NO_SOCKET)
+        closeHandle(socket.handle);
+    socket.handle = NO_SOCKET;
+}
@@ -0,0 +1,280 @@
+#include <pathfinding.hpp>
+#include <memory_stats.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+const int DIRECTIONS[4][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}}; // (drow, dcol)
+
+bool keyLess(const PathKey& a, const PathKey& b) {
+    return a.k1 < b.k1 || (a.k1 == b.k1 && a.k2 < b.k2);
+}
+
+bool keyEqual(const PathKey& a, const PathKey& b) {
+    return a.k1 == b.k1 && a.k2 == b.k2;
+}
+
+// std::*_heap build max-heaps; this ordering makes them min-heaps
+struct EntryAfter {
+    bool operator()(const PathQueueEntry& a, const PathQueueEntry& b) const { return keyLess(b.key, a.key); }
+};
+
+int add(int a, int b) {
+    return a >= PATH_UNREACHABLE || b >= PATH_UNREACHABLE ? PATH_UNREACHABLE : a + b;
+}
+
+int distance(int a, int b, int cols) {
+    return std::abs(a / cols - b / cols) + std::abs(a % cols - b % cols);
+}
+
+bool blocked(const MazeBits& bits, int cell) {
+    return bits.isWall(cell / bits.cols, cell % bits.cols);
+}
+
+// Calls f(neighbour) for the cells next to `cell` inside the grid
+template <typename F>
+void forNeighbours(int rows, int cols, int cell, F f) {
+    int row = cell / cols, col = cell % cols;
+    for (const auto& d : DIRECTIONS) {
+        int r = row + d[0], c = col + d[1];
+        if (r >= 0 && c >= 0 && r < rows && c < cols)
+            f(r * cols + c);
+    }
+}
+
+// Cost of the edge between two neighbours
+int stepCost(const MazeBits& bits, int from, int to) {
+    return blocked(bits, from) || blocked(bits, to) ? PATH_UNREACHABLE : 1;
+}
+
+// -- D* Lite --
+
+PathKey calculateKey(const PathPlanner& planner, int cell) {
+    int best = std::min(planner.g[cell], planner.rhs[cell]);
+    PathKey key;
+    key.k1 = add(add(best, distance(planner.start, cell, planner.cols)), planner.km);
+    key.k2 = best;
+    return key;
+}
+
+bool staleEntry(const PathPlanner& planner, const PathQueueEntry& entry) {
+    return !planner.queued[entry.cell] || !keyEqual(planner.keys[entry.cell], entry.key);
+}
+
+void pushCell(PathPlanner& planner, int cell, const PathKey& key) {
+    if (planner.queued[cell] && keyEqual(planner.keys[cell], key))
+        return; // at most one live entry per cell, so a purge always frees room
+    planner.keys[cell] = key;
+    planner.queued[cell] = 1;
+    if (planner.queue.size() == planner.queue.capacity()) {
+        auto stale = [&planner](const PathQueueEntry& entry) { return staleEntry(planner, entry); };
+        planner.queue.erase(std::remove_if(planner.queue.begin(), planner.queue.end(), stale), planner.queue.end());
+        std::make_heap(planner.queue.begin(), planner.queue.end(), EntryAfter());
+    }
+    PathQueueEntry entry;
+    entry.key = key;
+    entry.cell = cell;
+    planner.queue.push_back(entry);
+    std::push_heap(planner.queue.begin(), planner.queue.end(), EntryAfter());
+}
+
+// The live entry with the lowest key, or null
+const PathQueueEntry* topEntry(PathPlanner& planner) {
+    while (!planner.queue.empty() && staleEntry(planner, planner.queue.front())) {
+        std::pop_heap(planner.queue.begin(), planner.queue.end(), EntryAfter());
+        planner.queue.pop_back();
+    }
+    return planner.queue.empty() ? nullptr : &planner.queue.front();
+}
+
+void popEntry(PathPlanner& planner) {
+    std::pop_heap(planner.queue.begin(), planner.queue.end(), EntryAfter());
+    planner.queue.pop_back();
+}
+
+// Queued exactly while inconsistent (g != rhs)
+void updateCell(PathPlanner& planner, int cell) {
+    if (planner.g[cell] != planner.rhs[cell])
+        pushCell(planner, cell, calculateKey(planner, cell));
+    else
+        planner.queued[cell] = 0;
+}
+
+// Keys queued from here on are relative to the current start; raising the
+// offset by how far it moved keeps the older ones lower bounds, without
+// re-keying the queue
+void followStart(PathPlanner& planner) {
+    if (planner.last != planner.start) {
+        planner.km += distance(planner.last, planner.start, planner.cols);
+        planner.last = planner.start;
+    }
+}
+
+int lookahead(const PathPlanner& planner, const MazeBits& bits, int cell) {
+    if (cell == planner.goal)
+        return 0;
+    int best = PATH_UNREACHABLE;
+    forNeighbours(planner.rows, planner.cols, cell, [&](int next) {
+        best = std::min(best, add(stepCost(bits, cell, next), planner.g[next]));
+    });
+    return best;
+}
+
+} // namespace
+
+void initPathPlanner(PathPlanner& planner, const MazeBits& bits, int startRow, int startCol, int goalRow,
+                     int goalCol) {
+    size_t cells = static_cast<size_t>(bits.rows) * bits.cols;
+    planner.rows = bits.rows;
+    planner.cols = bits.cols;
+    planner.start = planner.last = startRow * bits.cols + startCol;
+    planner.goal = goalRow * bits.cols + goalCol;
+    planner.km = 0;
+    planner.g.assign(cells, PATH_UNREACHABLE);
+    planner.rhs.assign(cells, PATH_UNREACHABLE);
+    planner.keys.resize(cells);
+    planner.queued.assign(cells, 0);
+    planner.queue.clear();
+    // twice the cells: with one live entry per cell, a purge halves it
+    planner.queue.reserve(2 * cells);
+
+    reportCpuMemory(MEMORY_PATHS, &planner,
+                    (planner.g.capacity() + planner.rhs.capacity()) * sizeof(int) +
+                        planner.keys.capacity() * sizeof(PathKey) + planner.queued.capacity() +
+                        planner.queue.capacity() * sizeof(PathQueueEntry));
+
+    planner.rhs[planner.goal] = 0;
+    updateCell(planner, planner.goal);
+}
+
+void movePlannerStart(PathPlanner& planner, int row, int col) {
+    planner.start = row * planner.cols + col;
+}
+
+void plannerCellChanged(PathPlanner& planner, const MazeBits& bits, int row, int col) {
+    followStart(planner);
+    // a wall has no edges in or out, so the edges of the cell and of its
+    // neighbours towards it changed
+    int cell = row * planner.cols + col;
+    auto repair = [&](int changed) {
+        planner.rhs[changed] = lookahead(planner, bits, changed);
+        updateCell(planner, changed);
+    };
+    repair(cell);
+    forNeighbours(planner.rows, planner.cols, cell, repair);
+}
+
+bool planPath(PathPlanner& planner, const MazeBits& bits) {
+    followStart(planner);
+    int start = planner.start;
+    for (;;) {
+        const PathQueueEntry* top = topEntry(planner);
+        if (!top)
+            break;
+        if (!keyLess(top->key, calculateKey(planner, start)) && planner.rhs[start] == planner.g[start])
+            break;
+        int cell = top->cell;
+        PathKey old = top->key;
+        PathKey now = calculateKey(planner, cell);
+        popEntry(planner);
+        planner.queued[cell] = 0;
+        ++planner.expanded;
+
+        if (keyLess(old, now)) {
+            pushCell(planner, cell, now); // queued before the start moved; look again later
+        } else if (planner.g[cell] > planner.rhs[cell]) {
+            // cheaper than known: settle it and offer it to the neighbours
+            planner.g[cell] = planner.rhs[cell];
+            forNeighbours(planner.rows, planner.cols, cell, [&](int next) {
+                if (next != planner.goal)
+                    planner.rhs[next] = std::min(planner.rhs[next], add(stepCost(bits, next, cell), planner.g[cell]));
+                updateCell(planner, next);
+            });
+        } else {
+            // dearer than known: forget it, and re-derive every cell that
+            // went through it
+            int previous = planner.g[cell];
+            planner.g[cell] = PATH_UNREACHABLE;
+            forNeighbours(planner.rows, planner.cols, cell, [&](int next) {
+                if (next != planner.goal && planner.rhs[next] == add(stepCost(bits, next, cell), previous))
+                    planner.rhs[next] = lookahead(planner, bits, next);
+                updateCell(planner, next);
+            });
+            planner.rhs[cell] = lookahead(planner, bits, cell);
+            updateCell(planner, cell);
+        }
+    }
+    return planner.rhs[start] < PATH_UNREACHABLE;
+}
+
+bool nextPathStep(const PathPlanner& planner, const MazeBits& bits, int& row, int& col) {
+    if (planner.start == planner.goal)
+        return false;
+    int best = PATH_UNREACHABLE, bestCell = -1;
+    forNeighbours(planner.rows, planner.cols, planner.start, [&](int next) {
+        int cost = add(stepCost(bits, planner.start, next), planner.g[next]);
+        if (cost < best) {
+            best = cost;
+            bestCell = next;
+        }
+    });
+    if (bestCell < 0)
+        return false;
+    row = bestCell / planner.cols;
+    col = bestCell % planner.cols;
+    return true;
+}
+
+int findPath(const MazeBits& bits, int startRow, int startCol, int goalRow, int goalCol, PathSearch& search) {
+    size_t cells = static_cast<size_t>(bits.rows) * bits.cols;
+    if (search.g.size() != cells) {
+        search.g.assign(cells, PATH_UNREACHABLE);
+        search.seen.assign(cells, 0u);
+        search.stamp = 0;
+    }
+    if (++search.stamp == 0) { // wrapped; old stamps would match again
+        search.seen.assign(cells, 0u);
+        search.stamp = 1;
+    }
+    int start = startRow * bits.cols + startCol, goal = goalRow * bits.cols + goalCol;
+    if (blocked(bits, start) || blocked(bits, goal))
+        return PATH_UNREACHABLE;
+
+    // keyed (g + h, h): among equal estimates, the cell nearer the goal first
+    search.open.clear();
+    PathQueueEntry first;
+    first.key.k1 = first.key.k2 = distance(start, goal, bits.cols);
+    first.cell = start;
+    search.open.push_back(first);
+    search.g[start] = 0;
+    search.seen[start] = search.stamp;
+    while (!search.open.empty()) {
+        std::pop_heap(search.open.begin(), search.open.end(), EntryAfter());
+        PathQueueEntry entry = search.open.back();
+        search.open.pop_back();
+        int cell = entry.cell;
+        if (entry.key.k1 != search.g[cell] + entry.key.k2)
+            continue; // reached more cheaply since it was queued
+        ++search.expanded;
+        if (cell == goal)
+            return search.g[cell];
+        forNeighbours(bits.rows, bits.cols, cell, [&](int next) {
+            if (blocked(bits, next))
+                return;
+            int cost = search.g[cell] + 1;
+            if (search.seen[next] == search.stamp && search.g[next] <= cost)
+                return;
+            search.seen[next] = search.stamp;
+            search.g[next] = cost;
+            PathQueueEntry open;
+            open.key.k2 = distance(next, goal, bits.cols);
+            open.key.k1 = cost + open.key.k2;
+            open.cell = next;
+            search.open.push_back(open);
+            std::push_heap(search.open.begin(), search.open.end(), EntryAfter());
+        });
+    }
+    return PATH_UNREACHABLE;
+}
@@ -0,0 +1,32 @@
+#include <pulled_walls.hpp>
+#include <maze_texture.hpp>
+
+namespace {
+
+// four sides and the top, two triangles each
+const GLsizei verticesPerCell = 5 * 6;
+
+} // namespace
+
+bool initPulledWalls(PulledWalls& walls) {
+    walls.program.stages = {{GL_VERTEX_SHADER, shaderPath("pulled_walls.vert")},
+                            {GL_FRAGMENT_SHADER, shaderPath("maze.frag")}};
+    if (!buildShaderProgram(walls.program))
+        return false;
+
+    glGenVertexArrays(1, &walls.emptyVao);
+    return true;
+}
+
+void drawPulledWalls(const PulledWalls& walls, GLuint bitsTexture, const MazeBits& bits) {
+    glUseProgram(walls.program.id);
+    bindMazeBitsTexture(walls.program.id, bitsTexture, bits, 0);
+    glBindVertexArray(walls.emptyVao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, verticesPerCell, bits.rows * bits.cols);
+}
+
+void deletePulledWalls(PulledWalls& walls) {
+    deleteShaderProgram(walls.program);
+    glDeleteVertexArrays(1, &walls.emptyVao);
+    walls.emptyVao = 0;
+}
@@ -0,0 +1,154 @@
+#include <raycast.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Rays are set up a block at a time in plain loops over arrays, which the
+// compiler vectorizes; the walk itself is per ray
+const int RAY_BLOCK = 64;
+const int RAY_GRAIN = 4096;
+
+// Stands in for 1 / 0 on axis-parallel rays; large enough never to be
+// reached, small enough that adding to it stays finite
+const float NEVER = 1e30f;
+
+// DDA state of one ray in grid space, where cell (row, col) covers
+// [col, col + 1) x [row, row + 1)
+struct RayState {
+    int32_t row, col;
+    int32_t stepRow, stepCol;
+    float sideX, sideZ;   // distance at which the next column / row boundary is crossed
+    float deltaX, deltaZ; // distance between two column / row boundaries
+};
+
+inline void setupRay(const MazeBits& bits, float originX, float originZ, float dirX, float dirZ, RayState& ray) {
+    // mazeCellPosition() puts cell centres on integers, offset by half the grid
+    float gx = originX + static_cast<float>(bits.cols / 2) + 0.5f;
+    float gz = originZ + static_cast<float>(bits.rows / 2) + 0.5f;
+    float cellX = std::floor(gx), cellZ = std::floor(gz);
+    ray.col = static_cast<int32_t>(cellX);
+    ray.row = static_cast<int32_t>(cellZ);
+    ray.deltaX = dirX != 0.0f ? 1.0f / std::abs(dirX) : NEVER;
+    ray.deltaZ = dirZ != 0.0f ? 1.0f / std::abs(dirZ) : NEVER;
+    ray.stepCol = dirX < 0.0f ? -1 : 1;
+    ray.stepRow = dirZ < 0.0f ? -1 : 1;
+    ray.sideX = (dirX < 0.0f ? gx - cellX : cellX + 1.0f - gx) * ray.deltaX;
+    ray.sideZ = (dirZ < 0.0f ? gz - cellZ : cellZ + 1.0f - gz) * ray.deltaZ;
+}
+
+inline bool wallIn(const MazeBits& bits, int32_t row, int32_t col) {
+    return (bits.words[row * bits.wordsPerRow + (col >> 5)] >> (col & 31)) & 1u;
+}
+
+inline bool inside(const MazeBits& bits, int32_t row, int32_t col) {
+    return static_cast<uint32_t>(row) < static_cast<uint32_t>(bits.rows) &&
+           static_cast<uint32_t>(col) < static_cast<uint32_t>(bits.cols);
+}
+
+// Outside the grid and stepping further out: nothing left to hit
+inline bool leaving(const MazeBits& bits, const RayState& ray) {
+    return (ray.col < 0 && ray.stepCol < 0) || (ray.col >= bits.cols && ray.stepCol > 0) ||
+           (ray.row < 0 && ray.stepRow < 0) || (ray.row >= bits.rows && ray.stepRow > 0);
+}
+
+// Walk until a wall, the end of the ray or the edge of the grid; returns the
+// distance of the hit, or a negative value for none
+inline float walkRay(const MazeBits& bits, RayState& ray, float maxDistance, uint8_t& side) {
+    if (inside(bits, ray.row, ray.col) && wallIn(bits, ray.row, ray.col)) {
+        side = RAY_SIDE_X;
+        return 0.0f;
+    }
+    for (;;) {
+        // which boundary comes first decides the step; selects rather than
+        // branches, since the answer flips unpredictably along a ray
+        bool alongX = ray.sideX < ray.sideZ;
+        float distance = alongX ? ray.sideX : ray.sideZ;
+        if (distance > maxDistance)
+            return -1.0f;
+        ray.col += alongX ? ray.stepCol : 0;
+        ray.row += alongX ? 0 : ray.stepRow;
+        ray.sideX += alongX ? ray.deltaX : 0.0f;
+        ray.sideZ += alongX ? 0.0f : ray.deltaZ;
+
+        if (inside(bits, ray.row, ray.col)) {
+            if (wallIn(bits, ray.row, ray.col)) {
+                side = alongX ? RAY_SIDE_X : RAY_SIDE_Z;
+                return distance;
+            }
+        } else if (leaving(bits, ray)) {
+            return -1.0f;
+        }
+    }
+}
+
+} // namespace
+
+void resizeRayBatch(RayBatch& batch, int count) {
+    batch.count = count;
+    if (batch.originX.size() >= static_cast<size_t>(count))
+        return;
+    for (std::vector<float>* array : {&batch.originX, &batch.originZ, &batch.dirX, &batch.dirZ, &batch.maxDistance,
+                                      &batch.hitDistance})
+        array->resize(count);
+    batch.hitRow.resize(count);
+    batch.hitCol.resize(count);
+    batch.hitSide.resize(count);
+}
+
+void setRay(RayBatch& batch, int index, const glm::vec2& origin, const glm::vec2& direction, float maxDistance) {
+    batch.originX[index] = origin.x;
+    batch.originZ[index] = origin.y;
+    batch.dirX[index] = direction.x;
+    batch.dirZ[index] = direction.y;
+    batch.maxDistance[index] = maxDistance;
+}
+
+void setRaySegment(RayBatch& batch, int index, const glm::vec2& from, const glm::vec2& to) {
+    glm::vec2 offset = to - from;
+    float length = glm::length(offset);
+    setRay(batch, index, from, length > 0.0f ? offset / length : glm::vec2(1.0f, 0.0f), length);
+}
+
+void castRays(const MazeBits& bits, RayBatch& batch, int begin, int end) {
+    RayState rays[RAY_BLOCK];
+    for (int block = begin; block < end; block += RAY_BLOCK) {
+        int lanes = std::min(RAY_BLOCK, end - block);
+        const float* originX = batch.originX.data() + block;
+        const float* originZ = batch.originZ.data() + block;
+        const float* dirX = batch.dirX.data() + block;
+        const float* dirZ = batch.dirZ.data() + block;
+        for (int lane = 0; lane < lanes; ++lane)
+            setupRay(bits, originX[lane], originZ[lane], dirX[lane], dirZ[lane], rays[lane]);
+
+        for (int lane = 0; lane < lanes; ++lane) {
+            int i = block + lane;
+            uint8_t side = RAY_SIDE_X;
+            float distance = walkRay(bits, rays[lane], batch.maxDistance[i], side);
+            bool hit = distance >= 0.0f;
+            batch.hitDistance[i] = hit ? distance : batch.maxDistance[i];
+            batch.hitRow[i] = hit ? rays[lane].row : -1;
+            batch.hitCol[i] = hit ? rays[lane].col : -1;
+            batch.hitSide[i] = side;
+        }
+    }
+}
+
+void castRays(const MazeBits& bits, RayBatch& batch, JobSystem* jobs) {
+    if (jobs && batch.count > RAY_GRAIN)
+        parallelFor(*jobs, 0, batch.count, RAY_GRAIN,
+                    [&bits, &batch](int begin, int end) { castRays(bits, batch, begin, end); });
+    else
+        castRays(bits, batch, 0, batch.count);
+}
+
+bool lineOfSight(const MazeBits& bits, const glm::vec2& from, const glm::vec2& to) {
+    glm::vec2 offset = to - from;
+    float length = glm::length(offset);
+    glm::vec2 direction = length > 0.0f ? offset / length : glm::vec2(1.0f, 0.0f);
+    RayState ray;
+    setupRay(bits, from.x, from.y, direction.x, direction.y, ray);
+    uint8_t side;
+    return walkRay(bits, ray, length, side) < 0.0f;
+}
@@ -0,0 +1,160 @@
+#include <raycast_renderer.hpp>
+#include <maze_mesh.hpp>
+#include <memory_stats.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int ROW_GRAIN = 32;
+
+// Shading of the two face orientations, standing in for the GL path's light
+const float SIDE_X_SHADE = 0.85f;
+const float SIDE_Z_SHADE = 0.65f;
+
+// RGBA8 as it sits in memory (R in the lowest byte on little-endian)
+uint32_t packColor(const glm::vec3& color) {
+    glm::vec3 c = glm::clamp(color, glm::vec3(0.0f), glm::vec3(1.0f)) * 255.0f + 0.5f;
+    return static_cast<uint32_t>(c.x) | static_cast<uint32_t>(c.y) << 8 | static_cast<uint32_t>(c.z) << 16 |
+           0xff000000u;
+}
+
+// Every pixel is the column's wall colour inside its span, else background;
+// a select per pixel over contiguous rows, which vectorizes
+void fillRows(RaycastRenderer& renderer, int begin, int end, uint32_t background) {
+    const int32_t* top = renderer.wallTop.data();
+    const int32_t* bottom = renderer.wallBottom.data();
+    const uint32_t* color = renderer.columnColor.data();
+    int width = renderer.width;
+    for (int y = begin; y < end; ++y) {
+        uint32_t* row = renderer.pixels.data() + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x)
+            row[x] = y >= top[x] && y < bottom[x] ? color[x] : background;
+    }
+}
+
+int pixelRow(float y, int height) {
+    // first row whose centre is at or below y
+    return std::clamp(static_cast<int>(std::ceil(y - 0.5f)), 0, height);
+}
+
+} // namespace
+
+void initRaycastRenderer(RaycastRenderer& renderer, const MazeBits& bits, const LodSettings& lod,
+                         JobSystem* jobs) {
+    renderer.jobs = jobs;
+    renderer.bits = bits;
+    renderer.lod = lod;
+    renderer.width = renderer.height = 0;
+}
+
+void drawRaycastFrame(RaycastRenderer& renderer, const glm::vec3& cameraPosition, const glm::vec3& cameraFront,
+                      const glm::mat4& projection, int width, int height) {
+    if (width <= 0 || height <= 0)
+        return;
+    if (renderer.width != width || renderer.height != height) {
+        renderer.width = width;
+        renderer.height = height;
+        renderer.pixels.resize(static_cast<size_t>(width) * height);
+        renderer.wallTop.resize(width);
+        renderer.wallBottom.resize(width);
+        renderer.columnColor.resize(width);
+        resizeRayBatch(renderer.rays, width);
+        reportCpuMemory(MEMORY_TARGETS, &renderer, renderer.pixels.capacity() * sizeof(uint32_t));
+    }
+
+    // camera basis on the ground plane; right = cross(front, up), as in the
+    // GL path's strafing
+    glm::vec2 forward(cameraFront.x, cameraFront.z);
+    float flat = glm::length(forward);
+    forward = flat > 1e-6f ? forward / flat : glm::vec2(0.0f, -1.0f);
+    glm::vec2 right(-forward.y, forward.x);
+    float tanHalfX = 1.0f / projection[0][0];
+    float focal = projection[1][1]; // 1 / tan(half the vertical field of view)
+    float halfHeight = 0.5f * height;
+    // looking up or down shifts the horizon instead of tilting the walls
+    float horizon = halfHeight + (flat > 1e-6f ? cameraFront.y / flat : 0.0f) * focal * halfHeight;
+
+    // one ray per column; everything past fogEnd is fog anyway
+    RayBatch& rays = renderer.rays;
+    glm::vec2 origin(cameraPosition.x, cameraPosition.z);
+    for (int x = 0; x < width; ++x) {
+        float u = (2.0f * x + 1.0f) / width - 1.0f;
+        glm::vec2 direction = forward + right * (u * tanHalfX);
+        setRay(rays, x, origin, direction / glm::length(direction), renderer.lod.fogEnd);
+    }
+    castRays(renderer.bits, rays, renderer.jobs);
+
+    const LodSettings& lod = renderer.lod;
+    glm::vec3 shaded[2] = {renderer.wallColor * SIDE_X_SHADE, renderer.wallColor * SIDE_Z_SHADE};
+    for (int x = 0; x < width; ++x) {
+        if (rays.hitRow[x] < 0) {
+            renderer.wallTop[x] = renderer.wallBottom[x] = 0;
+            continue;
+        }
+        // distance along the view axis, so walls do not bulge at the edges
+        float u = (2.0f * x + 1.0f) / width - 1.0f;
+        float along = rays.hitDistance[x] / std::sqrt(1.0f + u * u * tanHalfX * tanHalfX);
+        float scale = focal * halfHeight / std::max(along, 1e-3f);
+        renderer.wallTop[x] = pixelRow(horizon - (WALL_TOP - cameraPosition.y) * scale, height);
+        renderer.wallBottom[x] = pixelRow(horizon - (WALL_BOTTOM - cameraPosition.y) * scale, height);
+
+        float fog = std::clamp((rays.hitDistance[x] - lod.fogStart) / (lod.fogEnd - lod.fogStart), 0.0f, 1.0f);
+        renderer.columnColor[x] = packColor(glm::mix(shaded[rays.hitSide[x]], lod.fogColor, fog));
+    }
+
+    uint32_t background = packColor(lod.fogColor);
+    if (renderer.jobs)
+        parallelFor(*renderer.jobs, 0, height, ROW_GRAIN,
+                    [&renderer, background](int begin, int end) { fillRows(renderer, begin, end, background); });
+    else
+        fillRows(renderer, 0, height, background);
+}
+
+void presentRaycastFrame(RaycastRenderer& renderer, int screenWidth, int screenHeight, GLuint destination) {
+    if (renderer.width == 0 || renderer.height == 0)
+        return;
+    if (!renderer.texture) {
+        glGenTextures(1, &renderer.texture);
+        glGenFramebuffers(1, &renderer.fbo);
+    }
+    glBindTexture(GL_TEXTURE_2D, renderer.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (renderer.textureWidth != renderer.width || renderer.textureHeight != renderer.height) {
+        renderer.textureWidth = renderer.width;
+        renderer.textureHeight = renderer.height;
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, renderer.width, renderer.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     nullptr);
+        trackTextureMemory(MEMORY_TARGETS, renderer.texture,
+                           static_cast<size_t>(renderer.width) * renderer.height * texelBytes(GL_RGBA8));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, renderer.fbo);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, renderer.texture, 0);
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, renderer.width, renderer.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                    renderer.pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // the pixels are top row first, GL textures bottom row first: blit with
+    // the destination upside down
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, renderer.fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination);
+    glBlitFramebuffer(0, 0, renderer.width, renderer.height, 0, screenHeight, screenWidth, 0, GL_COLOR_BUFFER_BIT,
+                      GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, destination);
+}
+
+void deleteRaycastRenderer(RaycastRenderer& renderer) {
+    if (renderer.texture) {
+        untrackTextureMemory(renderer.texture);
+        glDeleteTextures(1, &renderer.texture);
+        glDeleteFramebuffers(1, &renderer.fbo);
+    }
+    forgetCpuMemory(&renderer);
+    renderer.texture = renderer.fbo = 0;
+    renderer.textureWidth = renderer.textureHeight = 0;
+    renderer.pixels.clear();
+    renderer.width = renderer.height = 0;
+}
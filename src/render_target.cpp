@@ -0,0 +1,66 @@
+#include <render_target.hpp>
+#include <memory_stats.hpp>
+
+#include <iostream>
+
+bool resizeRenderTarget(RenderTarget& target, int width, int height) {
+    if (target.fbo && target.width == width && target.height == height)
+        return true;
+
+    if (!target.fbo) {
+        glGenFramebuffers(1, &target.fbo);
+        glGenTextures(1, &target.colorTexture);
+        glGenTextures(1, &target.depthTexture);
+    }
+    target.width = width;
+    target.height = height;
+
+    glBindTexture(GL_TEXTURE_2D, target.colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    trackTextureMemory(MEMORY_TARGETS, target.colorTexture, static_cast<size_t>(width) * height * texelBytes(GL_RGBA8));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glBindTexture(GL_TEXTURE_2D, target.depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    trackTextureMemory(MEMORY_TARGETS, target.depthTexture,
+                       static_cast<size_t>(width) * height * texelBytes(GL_DEPTH_COMPONENT32F));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.colorTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, target.depthTexture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete)
+        std::cout << "ERROR::FRAMEBUFFER::INCOMPLETE " << width << "x" << height << std::endl;
+    return complete;
+}
+
+void bindRenderTarget(const RenderTarget& target) {
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glViewport(0, 0, target.width, target.height);
+}
+
+void blitRenderTargetToScreen(const RenderTarget& target, int screenWidth, int screenHeight, GLuint destination) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target.fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination);
+    glBlitFramebuffer(0, 0, target.width, target.height, 0, 0, screenWidth, screenHeight,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, destination);
+}
+
+void deleteRenderTarget(RenderTarget& target) {
+    glDeleteFramebuffers(1, &target.fbo);
+    untrackTextureMemory(target.colorTexture);
+    untrackTextureMemory(target.depthTexture);
+    glDeleteTextures(1, &target.colorTexture);
+    glDeleteTextures(1, &target.depthTexture);
+    target.fbo = target.colorTexture = target.depthTexture = 0;
+    target.width = target.height = 0;
+}
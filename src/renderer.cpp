@@ -0,0 +1,418 @@
+#include <renderer.hpp>
+#include <maze_texture.hpp>
+#include <frame_arena.hpp>
+#include <memory_stats.hpp>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+
+bool initRenderer(Renderer& renderer, const std::vector<std::vector<int>>& maze, const RenderSettings& settings,
+                  JobSystem* jobs) {
+    renderer.settings = settings;
+    renderer.jobs = jobs;
+    RenderSettings& s = renderer.settings;
+
+    // no GPU worth the name: the CPU draws the walls and GL only presents
+    // them, so none of the GL path below is set up
+    if (s.cpuRaycast) {
+        packMaze(maze, renderer.mazeBits);
+        reportCpuMemory(MEMORY_MAZE, &renderer.mazeBits, renderer.mazeBits.words.capacity() * sizeof(uint32_t));
+        initRaycastRenderer(renderer.raycaster, renderer.mazeBits, s.lod, jobs);
+        std::cout << "Render path: CPU raycaster" << std::endl;
+        return true;
+    }
+
+    // build and compile our shader program
+    // ------------------------------------
+    // sources live in shaders/; a program binary cached on disk is used when
+    // neither the sources nor the driver changed since the last launch
+    renderer.mazeShader.stages = {{GL_VERTEX_SHADER, shaderPath("maze.vert")},
+                                  {GL_FRAGMENT_SHADER, shaderPath("maze.frag")}};
+    if (!buildShaderProgram(renderer.mazeShader)) {
+        std::cout << "Failed to build shader program" << std::endl;
+        return false;
+    }
+
+    // set up vertex data (and buffer(s)) and configure vertex attributes
+    // ------------------------------------------------------------------
+    // chunks are meshed on the job system and stream in over the first
+    // frames, within the per-frame upload budget. A mesh memory budget caps
+    // the chunk slots; then only the chunks nearest to the camera are
+    // requested (see updateChunkResidency) and far ones are evicted.
+    int rows = static_cast<int>(maze.size());
+    int slots = 0;
+    if (size_t meshBudget = memoryBudget(MEMORY_MESHES))
+        slots = std::max(1, static_cast<int>(meshBudget / mazeMeshSlotBytes()));
+    initMazeMesh(renderer.mazeMesh, rows, rows ? static_cast<int>(maze[0].size()) : 0, slots);
+    initChunkStreamer(renderer.chunkStreamer, renderer.mazeMesh, jobs, s.uploadBudget);
+    std::vector<int> requested;
+    if (renderer.mazeMesh.slotCount == static_cast<int>(renderer.mazeMesh.chunks.size())) {
+        requested.resize(renderer.mazeMesh.chunks.size());
+        for (size_t i = 0; i < requested.size(); ++i)
+            requested[i] = static_cast<int>(i);
+    } else {
+        std::cout << "Mesh budget: " << renderer.mazeMesh.slotCount << " of " << renderer.mazeMesh.chunks.size()
+                  << " chunks resident" << std::endl;
+    }
+    renderer.grid = std::make_shared<MazeGrid>(maze);
+    requestChunkMeshes(renderer.chunkStreamer, renderer.grid, requested);
+
+    // wall variants, one array layer each; walls stay flat-coloured until
+    // they have been decoded
+    startTextureArrayLoad(renderer.wallTextureLoad, jobs,
+                          {texturePath("wall_brick.png"), texturePath("wall_stone.png"),
+                           texturePath("wall_panel.png")});
+
+    // one bit per cell on the GPU, for vertex pulling, impostors and the map
+    packMaze(maze, renderer.mazeBits);
+    renderer.mazeBitsTexture = createMazeBitsTexture(renderer.mazeBits);
+    reportCpuMemory(MEMORY_MAZE, &renderer.mazeBits, renderer.mazeBits.words.capacity() * sizeof(uint32_t));
+
+    // torches along the corridors, binned per cell so each fragment only
+    // evaluates the lights that can actually reach it
+    if (s.torches > 0) {
+        placeTorches(renderer.mazeBits, s.torches, 1234u, renderer.lights);
+        binLights(renderer.mazeBits, renderer.lights, renderer.lightGrid, jobs);
+        uploadLights(renderer.lightBuffers, renderer.lights, renderer.lightGrid);
+        const LightGrid& grid = renderer.lightGrid;
+        reportCpuMemory(MEMORY_LIGHTS, &renderer.lights,
+                        renderer.lights.capacity() * sizeof(PointLight) +
+                            (grid.cells.capacity() + grid.indices.capacity()) * sizeof(uint32_t));
+        std::cout << "Lights: " << renderer.lights.size() << " torches, up to " << renderer.lightGrid.maxPerCell
+                  << " per cell" << std::endl;
+    }
+
+    // the sun's shadows are rendered once per chunk and cached; a chunk that
+    // streams in (or changes later) only redraws the tiles it covers
+    if (s.sunShadows && !initShadowMaps(renderer.shadows, renderer.mazeMesh, glm::vec3(-0.45f, -1.0f, -0.3f))) {
+        std::cout << "Sun shadows disabled" << std::endl;
+        s.sunShadows = false;
+    }
+
+    if (!initAgentInstances(renderer.agentInstances)) {
+        std::cout << "Agents will not be drawn" << std::endl;
+        deleteAgentInstances(renderer.agentInstances);
+    }
+
+    if (s.useVertexPulling && !initPulledWalls(renderer.pulledWalls)) {
+        std::cout << "Vertex pulling unavailable, using chunk meshes" << std::endl;
+        s.useVertexPulling = false;
+    }
+    if (s.useVertexPulling) {
+        // nothing per-chunk left to cull or swap for impostors
+        s.useOcclusionCulling = false;
+        s.lod.impostors = false;
+    }
+
+    if (s.lod.impostors && !initChunkImpostors(renderer.impostors, renderer.mazeMesh)) {
+        std::cout << "Impostors unavailable, drawing every chunk at full detail" << std::endl;
+        s.lod.impostors = false;
+    }
+
+    // GPU-driven culling on 4.3+, CPU frustum culling per chunk otherwise
+    renderer.useGpuCulling = !s.forceCpuCulling && gpuCullingSupported() &&
+                             initGpuCuller(renderer.gpuCuller, renderer.mazeMesh);
+    std::cout << "Culling path: " << (renderer.useGpuCulling ? "GPU (compute + multi-draw indirect)" : "CPU")
+              << std::endl;
+
+    // the scene is rendered offscreen so its depth can feed next frame's Hi-Z
+    if (s.useOcclusionCulling && !initHiZ(renderer.hiz)) {
+        std::cout << "Hi-Z occlusion culling disabled" << std::endl;
+        s.useOcclusionCulling = false;
+    }
+
+    if (s.showMinimap && !initMinimap(renderer.minimap, renderer.mazeBits))
+        s.showMinimap = false;
+
+    // Set up some OpenGL state
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glEnable(GL_DEPTH_TEST);
+    return true;
+}
+
+bool rendererWantsChunkLists(const Renderer& renderer) {
+    return !renderer.settings.cpuRaycast && !renderer.settings.useVertexPulling && !renderer.useGpuCulling;
+}
+
+bool renderFrame(Renderer& renderer, const RenderSnapshot& snapshot) {
+    const RenderSettings& s = renderer.settings;
+    // per-frame scratch on this thread (when rendering on the simulation
+    // thread, the tick that produced `snapshot` is done with its own)
+    resetFrameArena(threadFrameArena());
+    const LodSettings& lod = s.lod;
+
+    if (renderer.edits) {
+        takeMazeEdits(*renderer.edits, renderer.takenEdits);
+        if (!renderer.takenEdits.empty())
+            applyMazeEdits(renderer, renderer.takenEdits);
+    }
+
+    if (s.cpuRaycast) {
+        if (snapshot.framebufferWidth == 0 || snapshot.framebufferHeight == 0)
+            return false;
+        drawRaycastFrame(renderer.raycaster, snapshot.cameraPos, snapshot.cameraFront, snapshot.projection,
+                         snapshot.framebufferWidth, snapshot.framebufferHeight);
+        presentRaycastFrame(renderer.raycaster, snapshot.framebufferWidth, snapshot.framebufferHeight,
+                            renderer.outputFramebuffer);
+        ++renderer.framesSinceStats;
+        return true;
+    }
+
+#ifndef NDEBUG
+    // development builds pick up shader edits without a restart
+    if (snapshot.time - renderer.lastShaderCheck > 0.5f) {
+        renderer.lastShaderCheck = snapshot.time;
+        reloadShaderProgramIfChanged(renderer.mazeShader);
+        if (s.useVertexPulling)
+            reloadShaderProgramIfChanged(renderer.pulledWalls.program);
+        if (lod.impostors)
+            reloadShaderProgramIfChanged(renderer.impostors.program);
+        if (s.showMinimap)
+            reloadShaderProgramIfChanged(renderer.minimap.program);
+        if (s.sunShadows)
+            reloadShaderProgramIfChanged(renderer.shadows.depthProgram);
+        if (renderer.agentInstances.vao) {
+            reloadShaderProgramIfChanged(renderer.agentInstances.program);
+            reloadShaderProgramIfChanged(renderer.agentInstances.depthProgram);
+        }
+        if (renderer.useGpuCulling)
+            reloadShaderProgramIfChanged(renderer.gpuCuller.program);
+        if (s.useOcclusionCulling) {
+            reloadShaderProgramIfChanged(renderer.hiz.copyProgram);
+            reloadShaderProgramIfChanged(renderer.hiz.downsampleProgram);
+        }
+    }
+#endif
+
+    if (!renderer.wallTextures.id && textureArrayLoadFinished(renderer.wallTextureLoad))
+        uploadTextureArray(renderer.wallTextureLoad, renderer.wallTextures);
+    int evicted = updateChunkResidency(renderer.chunkStreamer, renderer.mazeMesh, snapshot.cameraPos);
+    int uploaded = streamChunkUploads(renderer.chunkStreamer, renderer.mazeMesh);
+    if ((evicted > 0 || uploaded > 0) && renderer.useGpuCulling)
+        updateGpuCullerChunks(renderer.gpuCuller, renderer.mazeMesh);
+    AgentInstances& agents = renderer.agentInstances;
+    if (agents.vao)
+        uploadAgentInstances(agents, snapshot.agents);
+    if (s.sunShadows) {
+        for (int chunk : renderer.chunkStreamer.uploadedChunks)
+            invalidateShadowChunk(renderer.shadows, chunk);
+        ShadowCasterCallback dynamicCasters;
+        if (agents.count > 0)
+            dynamicCasters = [&agents](GLuint, const glm::mat4& lightMatrix) {
+                drawAgentShadows(agents, lightMatrix);
+            };
+        updateShadowMaps(renderer.shadows, renderer.mazeMesh, dynamicCasters);
+    }
+
+    int framebufferWidth = snapshot.framebufferWidth;
+    int framebufferHeight = snapshot.framebufferHeight;
+    if (framebufferWidth == 0 || framebufferHeight == 0)
+        return false; // minimized: nothing to draw into
+    resizeRenderTarget(renderer.sceneTarget, framebufferWidth, framebufferHeight);
+    bindRenderTarget(renderer.sceneTarget);
+
+    // Clear screen (to the fog colour)
+    glClearColor(lod.fogColor.x, lod.fogColor.y, lod.fogColor.z, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glm::mat4 model = glm::mat4(1.0f);
+    const glm::mat4& view = snapshot.view;
+    const glm::mat4& projection = snapshot.projection;
+
+    // camera, colour and fog/LOD uniforms shared by every scene program
+    auto setSceneUniforms = [&](GLuint program, bool lodFade) {
+        glUseProgram(program);
+        unsigned int modelLoc = glGetUniformLocation(program, "model");
+        unsigned int viewLoc = glGetUniformLocation(program, "view");
+        unsigned int projLoc = glGetUniformLocation(program, "projection");
+
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, &view[0][0]);
+        glUniformMatrix4fv(projLoc, 1, GL_FALSE, &projection[0][0]);
+
+        int vertexColorLocation = glGetUniformLocation(program, "ourColor");
+        glUniform4f(vertexColorLocation, 0.0f, 0.75f, 1.0f, 1.0f);
+        setLodUniforms(program, lod, snapshot.cameraPos, lodFade);
+        bindTextureArray(program, renderer.wallTextures, "wallTextures", "wallTextureLayers", 1);
+        bindLights(program, renderer.lightBuffers, 2, snapshot.time);
+        bindShadowMaps(program, renderer.shadows, 5);
+    };
+
+    // Render maze; chunk geometry is already in world space
+    glm::mat4 viewProjection = projection * view;
+    if (s.useVertexPulling) {
+        // one instanced draw over the whole grid, no per-chunk culling
+        setSceneUniforms(renderer.pulledWalls.program.id, false);
+        drawPulledWalls(renderer.pulledWalls, renderer.mazeBitsTexture, renderer.mazeBits);
+    } else if (renderer.useGpuCulling) {
+        dispatchGpuCulling(renderer.gpuCuller, extractFrustum(viewProjection),
+                           s.useOcclusionCulling ? &renderer.hiz : nullptr, lod, snapshot.cameraPos,
+                           lod.impostors ? &renderer.impostors : nullptr);
+        setSceneUniforms(renderer.mazeShader.id, true);
+        drawGpuCulledChunks(renderer.gpuCuller, renderer.mazeMesh);
+        if (lod.impostors) {
+            setSceneUniforms(renderer.impostors.program.id, true);
+            drawChunkImpostorsIndirect(renderer.impostors, renderer.mazeMesh, renderer.mazeBitsTexture,
+                                       renderer.mazeBits);
+        }
+        readGpuCullStats(renderer.gpuCuller, renderer.cullStats);
+    } else {
+        renderer.visibleChunks = snapshot.meshChunks;
+        renderer.impostorChunks = snapshot.impostorChunks;
+        renderer.cullStats = snapshot.cullStats;
+        // the snapshot was culled against chunk footprints; skip chunks
+        // that have not streamed in or have no walls (evicted chunks still
+        // get their impostors)
+        renderer.cullStats.chunks = renderer.mazeMesh.nonEmptyChunks;
+        renderer.cullStats.drawn -= dropEmptyChunks(renderer.mazeMesh, renderer.visibleChunks);
+        renderer.cullStats.impostors -= dropChunksWithoutWalls(renderer.mazeMesh, renderer.impostorChunks);
+        if (s.useOcclusionCulling) {
+            pollHiZReadback(renderer.hiz, renderer.occlusionBuffer);
+            int meshDropped = occlusionCullChunks(renderer.mazeMesh, renderer.occlusionBuffer, renderer.visibleChunks);
+            int impostorDropped = occlusionCullChunks(renderer.mazeMesh, renderer.occlusionBuffer,
+                                                      renderer.impostorChunks);
+            renderer.cullStats.drawn -= meshDropped;
+            renderer.cullStats.impostors -= impostorDropped;
+            renderer.cullStats.occlusionRejected = meshDropped + impostorDropped;
+        }
+        setSceneUniforms(renderer.mazeShader.id, true);
+        drawMazeChunkList(renderer.mazeMesh, renderer.visibleChunks);
+        if (lod.impostors) {
+            setSceneUniforms(renderer.impostors.program.id, true);
+            drawChunkImpostors(renderer.impostors, renderer.mazeMesh, renderer.impostorChunks,
+                               renderer.mazeBitsTexture, renderer.mazeBits);
+        }
+    }
+
+    // this frame's depth is what the next frame culls against
+    if (s.useOcclusionCulling) {
+        buildHiZ(renderer.hiz, renderer.sceneTarget, viewProjection);
+        if (!renderer.useGpuCulling)
+            requestHiZReadback(renderer.hiz);
+    }
+
+    // agents go in after the Hi-Z build: they move, so they must not hide
+    // walls from next frame's occlusion test. Every agent is one instance of
+    // a single draw.
+    if (agents.count > 0) {
+        bindRenderTarget(renderer.sceneTarget);
+        setSceneUniforms(agents.program.id, false);
+        drawAgentInstances(agents);
+    }
+    blitRenderTargetToScreen(renderer.sceneTarget, framebufferWidth, framebufferHeight, renderer.outputFramebuffer);
+
+    if (s.showMinimap) {
+        updateMinimapExplored(renderer.minimap, snapshot.cameraPos);
+        drawMinimap(renderer.minimap, renderer.mazeBitsTexture, renderer.mazeBits, snapshot.cameraPos,
+                    snapshot.cameraFront, framebufferWidth, framebufferHeight);
+    }
+    ++renderer.framesSinceStats;
+    return true;
+}
+
+void applyMazeEdits(Renderer& renderer, const std::vector<MazeEdit>& edits) {
+    const RenderSettings& s = renderer.settings;
+    MazeBits& bits = renderer.mazeBits;
+    if (s.cpuRaycast) {
+        for (const MazeEdit& edit : edits) {
+            if (edit.row < 0 || edit.col < 0 || edit.row >= bits.rows || edit.col >= bits.cols)
+                continue;
+            bits.setWall(edit.row, edit.col, edit.wall);
+            renderer.raycaster.bits.setWall(edit.row, edit.col, edit.wall);
+        }
+        return;
+    }
+
+    // the grid is edited in place unless a meshing job still reads it (the
+    // streamer holds the only other reference); then a copy is edited
+    if (renderer.grid.use_count() > 2)
+        renderer.grid = std::make_shared<MazeGrid>(*renderer.grid);
+    MazeGrid& grid = *renderer.grid;
+
+    renderer.editedChunks.clear();
+    bool rebinAllLights = false;
+    for (const MazeEdit& edit : edits) {
+        if (!applyMazeEdit(grid, bits, edit))
+            continue;
+        updateMazeBitsTexel(renderer.mazeBitsTexture, bits, edit.row, edit.col);
+        chunksTouchingCell(bits.rows, bits.cols, edit.row, edit.col, renderer.editedChunks);
+
+        if (s.torches <= 0 || rebinAllLights)
+            continue;
+        LightGrid& lightGrid = renderer.lightGrid;
+        size_t firstIndex = lightGrid.indices.size();
+        CellRect rebinned = rebinLightsAround(bits, renderer.lights, lightGrid, edit.row, edit.col);
+        // once most of the index list is stale, start over
+        if (lightGrid.unusedIndices > lightGrid.indices.size() / 2)
+            rebinAllLights = true;
+        else
+            updateLightCells(renderer.lightBuffers, renderer.lights, lightGrid, rebinned, firstIndex);
+    }
+    if (rebinAllLights) {
+        binLights(bits, renderer.lights, renderer.lightGrid, renderer.jobs);
+        uploadLights(renderer.lightBuffers, renderer.lights, renderer.lightGrid);
+    }
+    if (!renderer.editedChunks.empty())
+        requestChunkMeshes(renderer.chunkStreamer, renderer.grid, renderer.editedChunks);
+}
+
+bool rendererSettled(Renderer& renderer) {
+    if (renderer.settings.cpuRaycast)
+        return true;
+    ChunkStreamer& streamer = renderer.chunkStreamer;
+    {
+        std::lock_guard<std::mutex> lock(streamer.mutex);
+        if (streamer.meshing.load() > 0 || !streamer.finished.empty())
+            return false;
+    }
+    if (!streamer.waiting.empty() || !renderer.wallTextures.id)
+        return false;
+    return !renderer.settings.sunShadows || renderer.shadows.dirtyCount == 0;
+}
+
+bool updateRenderStats(Renderer& renderer, float time, RenderStats& stats) {
+    if (time - renderer.lastStatsUpdate < 0.5f)
+        return false;
+    stats.fps = renderer.framesSinceStats / (time - renderer.lastStatsUpdate);
+    stats.cull = renderer.cullStats;
+    renderer.lastStatsUpdate = time;
+    renderer.framesSinceStats = 0;
+    return true;
+}
+
+void deleteRenderer(Renderer& renderer) {
+    const RenderSettings& s = renderer.settings;
+    if (s.cpuRaycast) {
+        deleteRaycastRenderer(renderer.raycaster);
+        forgetCpuMemory(&renderer.mazeBits);
+        return;
+    }
+    if (renderer.useGpuCulling)
+        deleteGpuCuller(renderer.gpuCuller);
+    if (s.useOcclusionCulling)
+        deleteHiZ(renderer.hiz);
+    if (s.useVertexPulling)
+        deletePulledWalls(renderer.pulledWalls);
+    if (s.lod.impostors)
+        deleteChunkImpostors(renderer.impostors);
+    if (s.showMinimap)
+        deleteMinimap(renderer.minimap);
+    if (s.sunShadows)
+        deleteShadowMaps(renderer.shadows);
+    deleteAgentInstances(renderer.agentInstances);
+    deleteLights(renderer.lightBuffers);
+    cancelTextureArrayLoad(renderer.wallTextureLoad);
+    deleteTextureArray(renderer.wallTextures);
+    untrackTextureMemory(renderer.mazeBitsTexture);
+    glDeleteTextures(1, &renderer.mazeBitsTexture);
+    renderer.mazeBitsTexture = 0;
+    forgetCpuMemory(&renderer.mazeBits);
+    forgetCpuMemory(&renderer.lights);
+    deleteRenderTarget(renderer.sceneTarget);
+    deleteChunkStreamer(renderer.chunkStreamer);
+    deleteMazeMesh(renderer.mazeMesh);
+    deleteShaderProgram(renderer.mazeShader);
+}
@@ -0,0 +1,735 @@
+#include <replication.hpp>
+#include <fixed_maze.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMilliseconds(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+enum PacketType : uint8_t {
+    PACKET_INPUT = 1,    // client -> server, every client tick
+    PACKET_SNAPSHOT = 2, // server -> client, every server tick
+    PACKET_LEAVE = 3,    // client -> server, once
+};
+
+// which fields of a player a snapshot entry carries
+enum PlayerField : uint8_t {
+    FIELD_X = 1,
+    FIELD_Z = 2,
+    FIELD_Y = 4,
+    FIELD_YAW = 8,
+    FIELD_PITCH = 16,
+    FIELD_FLAGS = 32,
+};
+
+// processInput's numbers
+const float WALK_SPEED = 3.0f;
+const float JUMP_HEIGHT = 0.5f;
+const float JUMP_DURATION = 0.5f;
+const float CROUCH_DEPTH = 0.5f;
+const float MAX_PITCH = 89.0f;
+
+const float POSITION_STEPS = 64.0f; // per cell
+const float HEIGHT_STEPS = 100.0f;  // per unit
+
+// -- packet bytes --
+
+// Little-endian fixed-size fields and LEB128 varints. A write that does not
+// fit sets `overflow` and leaves the bytes alone; the caller rolls back.
+struct PacketWriter {
+    uint8_t* data = nullptr;
+    size_t capacity = 0, size = 0;
+    bool overflow = false;
+};
+
+void writeByte(PacketWriter& writer, uint8_t value) {
+    if (writer.size >= writer.capacity) {
+        writer.overflow = true;
+        return;
+    }
+    writer.data[writer.size++] = value;
+}
+
+void writeU16(PacketWriter& writer, uint16_t value) {
+    writeByte(writer, static_cast<uint8_t>(value));
+    writeByte(writer, static_cast<uint8_t>(value >> 8));
+}
+
+void writeU32(PacketWriter& writer, uint32_t value) {
+    writeU16(writer, static_cast<uint16_t>(value));
+    writeU16(writer, static_cast<uint16_t>(value >> 16));
+}
+
+void writeVarint(PacketWriter& writer, uint32_t value) {
+    for (; value >= 0x80; value >>= 7)
+        writeByte(writer, static_cast<uint8_t>(value | 0x80));
+    writeByte(writer, static_cast<uint8_t>(value));
+}
+
+// small differences either way in few bytes: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+void writeSigned(PacketWriter& writer, int32_t value) {
+    writeVarint(writer, (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31));
+}
+
+// Reads past the end give zeros and set `failed`; check it once at the end
+struct PacketReader {
+    const uint8_t* data = nullptr;
+    size_t size = 0, offset = 0;
+    bool failed = false;
+};
+
+uint8_t readByte(PacketReader& reader) {
+    if (reader.offset >= reader.size) {
+        reader.failed = true;
+        return 0;
+    }
+    return reader.data[reader.offset++];
+}
+
+uint16_t readU16(PacketReader& reader) {
+    uint16_t low = readByte(reader);
+    return static_cast<uint16_t>(low | readByte(reader) << 8);
+}
+
+uint32_t readU32(PacketReader& reader) {
+    uint32_t low = readU16(reader);
+    return low | static_cast<uint32_t>(readU16(reader)) << 16;
+}
+
+uint32_t readVarint(PacketReader& reader) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t byte = readByte(reader);
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+    reader.failed = true; // longer than any uint32_t
+    return 0;
+}
+
+int32_t readSigned(PacketReader& reader) {
+    uint32_t value = readVarint(reader);
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+// -- quantization --
+
+uint16_t quantizeYaw(float yaw) {
+    float turns = yaw / 360.0f;
+    turns -= std::floor(turns);
+    return static_cast<uint16_t>(static_cast<uint32_t>(std::lround(turns * 65536.0f)) & 0xffffu);
+}
+
+int16_t quantizePitch(float pitch) {
+    return static_cast<int16_t>(std::clamp(std::lround(pitch / 90.0f * 32767.0f), -32767l, 32767l));
+}
+
+float yawDegrees(uint16_t yaw) {
+    return yaw * (360.0f / 65536.0f);
+}
+
+float pitchDegrees(int16_t pitch) {
+    return pitch * (90.0f / 32767.0f);
+}
+
+// world x (or z) of the maze's corner is -(cells / 2) - 0.5
+uint16_t quantizeCoordinate(float value, int cells) {
+    float fromCorner = value + static_cast<float>(cells / 2) + 0.5f;
+    return static_cast<uint16_t>(std::clamp(std::lround(fromCorner * POSITION_STEPS), 0l, 65535l));
+}
+
+float coordinate(uint16_t value, int cells) {
+    return value / POSITION_STEPS - static_cast<float>(cells / 2) - 0.5f;
+}
+
+bool dropPacket(std::mt19937& rng, float loss) {
+    return loss > 0.0f && std::uniform_real_distribution<float>(0.0f, 1.0f)(rng) < loss;
+}
+
+// -- server --
+
+ServerClient* findClient(ReplicationServer& server, const NetAddress& address) {
+    for (ServerClient& client : server.clients)
+        if (client.address == address)
+            return &client;
+    return nullptr;
+}
+
+// A player for a new address, in a random corridor; null when every id is taken
+ServerClient* addClient(ReplicationServer& server, const NetAddress& address) {
+    auto freeId = std::find(server.active.begin(), server.active.end(), 0);
+    if (freeId == server.active.end()) {
+        if (server.players.size() > 0xffff)
+            return nullptr;
+        server.players.emplace_back();
+        server.active.push_back(0);
+        server.playerRegion.push_back(0);
+        freeId = server.active.end() - 1;
+    }
+    uint16_t id = static_cast<uint16_t>(freeId - server.active.begin());
+
+    const MazeBits& walls = server.walls;
+    std::uniform_int_distribution<int> row(0, walls.rows - 1), col(0, walls.cols - 1);
+    int spawnRow = 1, spawnCol = 1;
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+        int r = row(server.rng), c = col(server.rng);
+        if (!walls.isWall(r, c)) {
+            spawnRow = r;
+            spawnCol = c;
+            break;
+        }
+    }
+    PlayerState& player = server.players[id];
+    player = PlayerState();
+    player.position = mazeCellPosition(spawnRow, spawnCol, walls.rows, walls.cols);
+    server.active[id] = 1;
+
+    server.clients.emplace_back();
+    ServerClient& client = server.clients.back();
+    client.address = address;
+    client.player = id;
+    client.lastHeard = server.time;
+    for (Snapshot& snapshot : client.history)
+        snapshot.players.reserve(64);
+    return &client;
+}
+
+void removeClient(ReplicationServer& server, ServerClient& client) {
+    server.active[client.player] = 0;
+    std::swap(client, server.clients.back());
+    server.clients.pop_back();
+}
+
+void receiveInputs(ReplicationServer& server) {
+    NetAddress from;
+    int bytes;
+    while ((bytes = receivePacket(server.socket, from, server.packet.data(), server.packet.size())) > 0) {
+        ++server.stats.packetsReceived;
+        server.stats.bytesReceived += static_cast<uint64_t>(bytes);
+        PacketReader reader;
+        reader.data = server.packet.data();
+        reader.size = static_cast<size_t>(bytes);
+        uint8_t type = readByte(reader);
+        ServerClient* client = findClient(server, from);
+        if (type == PACKET_LEAVE) {
+            if (client)
+                removeClient(server, *client);
+            continue;
+        }
+        if (type != PACKET_INPUT)
+            continue;
+        PlayerInput input;
+        input.sequence = readU32(reader);
+        uint32_t ack = readU32(reader);
+        input.yaw = yawDegrees(readU16(reader));
+        input.pitch = pitchDegrees(static_cast<int16_t>(readU16(reader)));
+        input.buttons = readByte(reader);
+        if (reader.failed || input.sequence == 0)
+            continue;
+        if (!client && !(client = addClient(server, from)))
+            continue;
+        client->lastHeard = server.time;
+        // inputs may arrive out of order; only ever move forward
+        if (input.sequence > client->input.sequence)
+            client->input = input;
+        if (ack > client->acked && ack < server.tick)
+            client->acked = ack;
+    }
+}
+
+int playerCell(float value, int cells) {
+    return std::clamp(static_cast<int>(std::floor(value + 0.5f)) + cells / 2, 0, cells - 1);
+}
+
+// Counting sort of the active players by region; ids ascend within each one
+void bucketPlayers(ReplicationServer& server) {
+    const int regions = server.regionRows * server.regionCols;
+    std::fill(server.regionStart.begin(), server.regionStart.end(), 0u);
+    uint32_t count = 0;
+    for (size_t id = 0; id < server.players.size(); ++id) {
+        if (!server.active[id])
+            continue;
+        const glm::vec3& position = server.players[id].position;
+        int row = playerCell(position.z, server.walls.rows) / INTEREST_REGION_CELLS;
+        int col = playerCell(position.x, server.walls.cols) / INTEREST_REGION_CELLS;
+        server.playerRegion[id] = static_cast<uint16_t>(row * server.regionCols + col);
+        ++server.regionStart[server.playerRegion[id] + 1];
+        ++count;
+    }
+    for (int region = 0; region < regions; ++region)
+        server.regionStart[region + 1] += server.regionStart[region];
+    server.regionPlayers.resize(count);
+    // place each at its region's cursor; the cursors end on the next region's
+    // start, so shift them back by one afterwards
+    for (size_t id = 0; id < server.players.size(); ++id)
+        if (server.active[id])
+            server.regionPlayers[server.regionStart[server.playerRegion[id]]++] = static_cast<uint16_t>(id);
+    for (int region = regions; region > 0; --region)
+        server.regionStart[region] = server.regionStart[region - 1];
+    server.regionStart[0] = 0;
+}
+
+// The players in the 3x3 regions around `player`'s, sorted by id
+void gatherVisible(ReplicationServer& server, uint16_t player) {
+    server.visible.clear();
+    int region = server.playerRegion[player];
+    int regionRow = region / server.regionCols, regionCol = region % server.regionCols;
+    for (int row = std::max(regionRow - 1, 0); row <= std::min(regionRow + 1, server.regionRows - 1); ++row) {
+        for (int col = std::max(regionCol - 1, 0); col <= std::min(regionCol + 1, server.regionCols - 1); ++col) {
+            int r = row * server.regionCols + col;
+            server.visible.insert(server.visible.end(), server.regionPlayers.begin() + server.regionStart[r],
+                                  server.regionPlayers.begin() + server.regionStart[r + 1]);
+        }
+    }
+    std::sort(server.visible.begin(), server.visible.end());
+}
+
+// The fields of `now` that differ from `base`, as differences from it
+void writePlayerEntry(PacketWriter& writer, const NetPlayer& now, const NetPlayer& base, uint16_t idGap) {
+    uint8_t mask = (now.x != base.x ? FIELD_X : 0) | (now.z != base.z ? FIELD_Z : 0) |
+                   (now.y != base.y ? FIELD_Y : 0) | (now.yaw != base.yaw ? FIELD_YAW : 0) |
+                   (now.pitch != base.pitch ? FIELD_PITCH : 0) | (now.flags != base.flags ? FIELD_FLAGS : 0);
+    writeVarint(writer, idGap);
+    writeByte(writer, mask);
+    if (mask & FIELD_X)
+        writeSigned(writer, now.x - base.x);
+    if (mask & FIELD_Z)
+        writeSigned(writer, now.z - base.z);
+    if (mask & FIELD_Y)
+        writeSigned(writer, now.y - base.y);
+    if (mask & FIELD_YAW) // the short way round
+        writeSigned(writer, static_cast<int16_t>(static_cast<uint16_t>(now.yaw - base.yaw)));
+    if (mask & FIELD_PITCH)
+        writeSigned(writer, now.pitch - base.pitch);
+    if (mask & FIELD_FLAGS)
+        writeByte(writer, now.flags);
+}
+
+// Encode `client`'s snapshot of this tick against `base` (null = full) into
+// server.packet, and record in its history what the client will decode from
+// it. Returns the packet's size, or 0 when even the list of players that left
+// does not fit; then send a full one instead.
+size_t writeSnapshot(ReplicationServer& server, ServerClient& client, const Snapshot* base) {
+    const MazeBits& walls = server.walls;
+    PacketWriter writer;
+    writer.data = server.packet.data();
+    writer.capacity = server.packet.size();
+    writeByte(writer, PACKET_SNAPSHOT);
+    writeU32(writer, server.tick);
+    writeU32(writer, base ? base->sequence : 0u);
+    writeU16(writer, client.player);
+    if (!base) { // the level, for clients that just joined
+        writeU32(writer, server.seed);
+        writeU16(writer, static_cast<uint16_t>(walls.rows));
+        writeU16(writer, static_cast<uint16_t>(walls.cols));
+    }
+
+    // players the client knew about and no longer sees
+    server.removed.clear();
+    if (base) {
+        size_t v = 0;
+        for (const NetPlayer& old : base->players) {
+            while (v < server.visible.size() && server.visible[v] < old.id)
+                ++v;
+            if (v == server.visible.size() || server.visible[v] != old.id)
+                server.removed.push_back(old.id);
+        }
+    }
+    writeVarint(writer, static_cast<uint32_t>(server.removed.size()));
+    uint16_t previous = 0;
+    for (uint16_t id : server.removed) {
+        writeVarint(writer, static_cast<uint16_t>(id - previous));
+        previous = id;
+    }
+    size_t countAt = writer.size;
+    writeU16(writer, 0); // patched below
+    if (writer.overflow)
+        return 0;
+
+    // the rest, in id order; unchanged players cost nothing. Once the packet
+    // is full, changed players keep their baseline on both sides and new
+    // ones wait, and either goes out in a later snapshot.
+    Snapshot& record = client.history[server.tick % SNAPSHOT_HISTORY];
+    record.sequence = server.tick;
+    record.players.clear();
+    uint16_t written = 0;
+    previous = 0;
+    size_t b = 0;
+    bool full = false;
+    for (uint16_t id : server.visible) {
+        const NetPlayer* old = nullptr;
+        if (base) {
+            while (b < base->players.size() && base->players[b].id < id)
+                ++b;
+            if (b < base->players.size() && base->players[b].id == id)
+                old = &base->players[b];
+        }
+        NetPlayer now = quantizePlayer(server.players[id], id, walls.rows, walls.cols);
+        if (old && *old == now) {
+            record.players.push_back(now);
+            continue;
+        }
+        if (!full) {
+            NetPlayer zero;
+            zero.id = id;
+            size_t mark = writer.size;
+            writePlayerEntry(writer, now, old ? *old : zero, static_cast<uint16_t>(id - previous));
+            if (writer.overflow) {
+                writer.size = mark;
+                full = true;
+            }
+        }
+        if (full) {
+            ++server.stats.playersDeferred;
+            if (old)
+                record.players.push_back(*old);
+            continue;
+        }
+        record.players.push_back(now);
+        previous = id;
+        ++written;
+    }
+    writer.data[countAt] = static_cast<uint8_t>(written);
+    writer.data[countAt + 1] = static_cast<uint8_t>(written >> 8);
+
+    server.stats.playersVisible += server.visible.size();
+    server.stats.playersWritten += written;
+    ++(base ? server.stats.deltaSnapshots : server.stats.fullSnapshots);
+    return writer.size;
+}
+
+void sendSnapshot(ReplicationServer& server, ServerClient& client) {
+    gatherVisible(server, client.player);
+    // the newest snapshot the client has, if it is still in both histories
+    const Snapshot* base = nullptr;
+    if (client.acked != 0 && server.tick - client.acked < SNAPSHOT_HISTORY &&
+        client.history[client.acked % SNAPSHOT_HISTORY].sequence == client.acked)
+        base = &client.history[client.acked % SNAPSHOT_HISTORY];
+    size_t bytes = writeSnapshot(server, client, base);
+    if (bytes == 0)
+        bytes = writeSnapshot(server, client, nullptr);
+    ++server.stats.packetsSent;
+    server.stats.bytesSent += bytes;
+    if (!dropPacket(server.rng, server.simulatedLoss))
+        sendPacket(server.socket, client.address, server.packet.data(), bytes);
+}
+
+} // namespace
+
+glm::vec3 playerFront(float yaw, float pitch) {
+    glm::vec3 direction;
+    direction.x = std::cos(glm::radians(yaw)) * std::cos(glm::radians(pitch));
+    direction.y = std::sin(glm::radians(pitch));
+    direction.z = std::sin(glm::radians(yaw)) * std::cos(glm::radians(pitch));
+    return glm::normalize(direction);
+}
+
+void stepPlayer(PlayerState& player, const PlayerInput& input, const MazeBits& walls, float dt) {
+    player.yaw = input.yaw;
+    player.pitch = std::clamp(input.pitch, -MAX_PITCH, MAX_PITCH);
+
+    bool crouch = input.buttons & BUTTON_CROUCH;
+    if (!(player.flags & (PLAYER_JUMPING | PLAYER_CROUCHING)) && crouch) {
+        player.flags |= PLAYER_CROUCHING;
+        player.position.y -= CROUCH_DEPTH;
+    } else if ((player.flags & PLAYER_CROUCHING) && !crouch) {
+        player.flags &= ~PLAYER_CROUCHING;
+        player.position.y += CROUCH_DEPTH;
+    }
+
+    // each key moves on its own, so walking into a wall at an angle stops
+    // only the blocked part
+    glm::vec3 front = playerFront(player.yaw, player.pitch);
+    glm::vec3 right = glm::normalize(glm::cross(front, glm::vec3(0.0f, 1.0f, 0.0f)));
+    float speed = WALK_SPEED * dt;
+    auto walk = [&](const glm::vec3& direction) {
+        glm::vec3 next = player.position + direction * speed;
+        if (!circleHitsWall(walls, next.x, next.z, 0.0f)) {
+            player.position.x = next.x;
+            player.position.z = next.z;
+        }
+    };
+    if (input.buttons & BUTTON_FORWARD)
+        walk(front);
+    if (input.buttons & BUTTON_BACK)
+        walk(-front);
+    if (input.buttons & BUTTON_LEFT)
+        walk(-right);
+    if (input.buttons & BUTTON_RIGHT)
+        walk(right);
+
+    if (!(player.flags & PLAYER_JUMPING) && (input.buttons & BUTTON_JUMP)) {
+        player.flags |= PLAYER_JUMPING;
+        player.jumpTime = 0.0f;
+    }
+    if (player.flags & PLAYER_JUMPING) {
+        float ground = player.flags & PLAYER_CROUCHING ? -CROUCH_DEPTH : 0.0f;
+        player.jumpTime += dt;
+        if (player.jumpTime <= JUMP_DURATION) {
+            float t = player.jumpTime / JUMP_DURATION - 0.5f;
+            player.position.y = ground + JUMP_HEIGHT * (1.0f - 4.0f * t * t);
+        } else {
+            player.flags &= ~PLAYER_JUMPING;
+            player.jumpTime = 0.0f;
+            player.position.y = ground;
+        }
+    }
+}
+
+bool operator==(const NetPlayer& a, const NetPlayer& b) {
+    return a.id == b.id && a.x == b.x && a.z == b.z && a.y == b.y && a.yaw == b.yaw && a.pitch == b.pitch &&
+           a.flags == b.flags;
+}
+
+NetPlayer quantizePlayer(const PlayerState& player, uint16_t id, int rows, int cols) {
+    NetPlayer net;
+    net.id = id;
+    net.x = quantizeCoordinate(player.position.x, cols);
+    net.z = quantizeCoordinate(player.position.z, rows);
+    net.y = static_cast<int16_t>(std::clamp(std::lround(player.position.y * HEIGHT_STEPS), -32767l, 32767l));
+    net.yaw = quantizeYaw(player.yaw);
+    net.pitch = quantizePitch(player.pitch);
+    net.flags = player.flags;
+    return net;
+}
+
+PlayerState dequantizePlayer(const NetPlayer& player, int rows, int cols) {
+    PlayerState state;
+    state.position = glm::vec3(coordinate(player.x, cols), player.y / HEIGHT_STEPS, coordinate(player.z, rows));
+    state.yaw = yawDegrees(player.yaw);
+    state.pitch = pitchDegrees(player.pitch);
+    state.flags = player.flags;
+    return state;
+}
+
+bool startReplicationServer(ReplicationServer& server, uint32_t seed, int mazeSize, uint16_t port) {
+    if (!openUdpSocket(server.socket, port))
+        return false;
+    std::vector<std::vector<int>> maze;
+    generateMaze(maze, mazeSize, mazeSize, seed);
+    packMaze(maze, server.walls);
+    server.seed = seed;
+    server.rng.seed(seed);
+    server.regionRows = (server.walls.rows + INTEREST_REGION_CELLS - 1) / INTEREST_REGION_CELLS;
+    server.regionCols = (server.walls.cols + INTEREST_REGION_CELLS - 1) / INTEREST_REGION_CELLS;
+    server.regionStart.assign(static_cast<size_t>(server.regionRows) * server.regionCols + 1, 0u);
+    server.packet.resize(MAX_PACKET_BYTES);
+    return true;
+}
+
+void replicationServerTick(ReplicationServer& server, float dt) {
+    Clock::time_point start = Clock::now();
+    ++server.tick;
+    server.time += dt;
+    receiveInputs(server);
+    for (size_t i = server.clients.size(); i-- > 0;)
+        if (server.time - server.clients[i].lastHeard > CLIENT_TIMEOUT_SECONDS)
+            removeClient(server, server.clients[i]);
+    for (const ServerClient& client : server.clients)
+        stepPlayer(server.players[client.player], client.input, server.walls, dt);
+    server.stats.simulateMs += elapsedMilliseconds(start);
+
+    start = Clock::now();
+    bucketPlayers(server);
+    for (ServerClient& client : server.clients)
+        sendSnapshot(server, client);
+    server.stats.replicateMs += elapsedMilliseconds(start);
+    ++server.stats.ticks;
+}
+
+void stopReplicationServer(ReplicationServer& server) {
+    closeUdpSocket(server.socket);
+    server.clients.clear();
+    server.players.clear();
+    server.active.clear();
+}
+
+int runReplicationServer(uint16_t port, uint32_t seed, int mazeSize) {
+    ReplicationServer server;
+    if (!startReplicationServer(server, seed, mazeSize, port))
+        return 1;
+    std::cout << "Serving a " << mazeSize << "x" << mazeSize << " maze (seed " << seed << ") on port "
+              << udpSocketPort(server.socket) << std::endl;
+
+    const float step = 1.0f / REPLICATION_TICK_RATE;
+    const auto tickLength = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(step));
+    const uint32_t reportTicks = 5 * REPLICATION_TICK_RATE;
+    ReplicationStats last = server.stats;
+    Clock::time_point next = Clock::now();
+    for (;;) {
+        std::this_thread::sleep_until(next);
+        // after a stall, resume from now instead of replaying missed ticks
+        next = std::max(next + tickLength, Clock::now());
+        replicationServerTick(server, step);
+
+        if (server.tick % reportTicks == 0) {
+            const ReplicationStats& stats = server.stats;
+            double seconds = static_cast<double>(reportTicks) / REPLICATION_TICK_RATE;
+            double simulateMs = stats.simulateMs - last.simulateMs;
+            double replicateMs = stats.replicateMs - last.replicateMs;
+            std::printf("%zu players | tick %.3f ms (simulate %.3f) | out %.1f kB/s in %.1f kB/s | %llu full "
+                        "snapshots\n",
+                        server.clients.size(), (simulateMs + replicateMs) / reportTicks, simulateMs / reportTicks,
+                        (stats.bytesSent - last.bytesSent) / seconds / 1024.0,
+                        (stats.bytesReceived - last.bytesReceived) / seconds / 1024.0,
+                        static_cast<unsigned long long>(stats.fullSnapshots - last.fullSnapshots));
+            std::fflush(stdout);
+            last = stats;
+        }
+    }
+}
+
+bool connectReplicationClient(ReplicationClient& client, const NetAddress& server) {
+    if (!openUdpSocket(client.socket))
+        return false;
+    client.server = server;
+    client.packet.resize(MAX_PACKET_BYTES);
+    for (Snapshot& snapshot : client.received)
+        snapshot.players.reserve(64);
+    return true;
+}
+
+void sendPlayerInput(ReplicationClient& client, PlayerInput input) {
+    input.sequence = ++client.inputSequence;
+    uint8_t bytes[16];
+    PacketWriter writer;
+    writer.data = bytes;
+    writer.capacity = sizeof(bytes);
+    writeByte(writer, PACKET_INPUT);
+    writeU32(writer, input.sequence);
+    writeU32(writer, client.latest);
+    writeU16(writer, quantizeYaw(input.yaw));
+    writeU16(writer, static_cast<uint16_t>(quantizePitch(input.pitch)));
+    writeByte(writer, input.buttons);
+    ++client.stats.packetsSent;
+    client.stats.bytesSent += writer.size;
+    if (!dropPacket(client.rng, client.simulatedLoss))
+        sendPacket(client.socket, client.server, bytes, writer.size);
+}
+
+bool receiveSnapshots(ReplicationClient& client) {
+    bool newer = false;
+    NetAddress from;
+    int bytes;
+    while ((bytes = receivePacket(client.socket, from, client.packet.data(), client.packet.size())) > 0) {
+        if (!(from == client.server) || dropPacket(client.rng, client.simulatedLoss))
+            continue;
+        ++client.stats.packetsReceived;
+        client.stats.bytesReceived += static_cast<uint64_t>(bytes);
+        PacketReader reader;
+        reader.data = client.packet.data();
+        reader.size = static_cast<size_t>(bytes);
+        if (readByte(reader) != PACKET_SNAPSHOT)
+            continue;
+        uint32_t sequence = readU32(reader);
+        uint32_t baseline = readU32(reader);
+        uint16_t player = readU16(reader);
+        uint32_t seed = 0;
+        int rows = 0, cols = 0;
+        if (baseline == 0) {
+            seed = readU32(reader);
+            rows = readU16(reader);
+            cols = readU16(reader);
+        }
+        if (reader.failed || sequence <= client.latest)
+            continue; // late, duplicated or cut short
+        const Snapshot* base = nullptr;
+        if (baseline != 0) {
+            base = &client.received[baseline % SNAPSHOT_HISTORY];
+            if (base->sequence != baseline || sequence - baseline >= SNAPSHOT_HISTORY) {
+                ++client.stats.undecodable;
+                continue;
+            }
+        }
+
+        client.removed.clear();
+        uint32_t removedCount = readVarint(reader);
+        uint16_t id = 0;
+        for (uint32_t i = 0; i < removedCount && !reader.failed; ++i) {
+            id = static_cast<uint16_t>(id + readVarint(reader));
+            client.removed.push_back(id);
+        }
+
+        // the baseline's players, less the removed ones, with the entries
+        // merged in by id
+        Snapshot& snapshot = client.received[sequence % SNAPSHOT_HISTORY];
+        snapshot.sequence = 0; // until it decoded completely
+        snapshot.players.clear();
+        size_t b = 0, r = 0;
+        auto keepBaseUpTo = [&](uint32_t end) {
+            for (; base && b < base->players.size() && base->players[b].id < end; ++b) {
+                uint16_t baseId = base->players[b].id;
+                while (r < client.removed.size() && client.removed[r] < baseId)
+                    ++r;
+                if (r == client.removed.size() || client.removed[r] != baseId)
+                    snapshot.players.push_back(base->players[b]);
+            }
+        };
+        uint16_t count = readU16(reader);
+        id = 0;
+        for (uint16_t i = 0; i < count && !reader.failed; ++i) {
+            id = static_cast<uint16_t>(id + readVarint(reader));
+            keepBaseUpTo(id);
+            NetPlayer entry;
+            entry.id = id;
+            if (base && b < base->players.size() && base->players[b].id == id)
+                entry = base->players[b++];
+            uint8_t mask = readByte(reader);
+            if (mask & FIELD_X)
+                entry.x = static_cast<uint16_t>(entry.x + readSigned(reader));
+            if (mask & FIELD_Z)
+                entry.z = static_cast<uint16_t>(entry.z + readSigned(reader));
+            if (mask & FIELD_Y)
+                entry.y = static_cast<int16_t>(entry.y + readSigned(reader));
+            if (mask & FIELD_YAW)
+                entry.yaw = static_cast<uint16_t>(entry.yaw + readSigned(reader));
+            if (mask & FIELD_PITCH)
+                entry.pitch = static_cast<int16_t>(entry.pitch + readSigned(reader));
+            if (mask & FIELD_FLAGS)
+                entry.flags = readByte(reader);
+            snapshot.players.push_back(entry);
+        }
+        keepBaseUpTo(0x10000u);
+        if (reader.failed)
+            continue;
+
+        snapshot.sequence = sequence;
+        client.latest = sequence;
+        client.player = player;
+        if (baseline == 0 && rows > 0 && cols > 0) {
+            client.joined = true;
+            client.mazeSeed = seed;
+            client.mazeRows = rows;
+            client.mazeCols = cols;
+        }
+        ++(base ? client.stats.deltaSnapshots : client.stats.fullSnapshots);
+        newer = true;
+    }
+    return newer;
+}
+
+const Snapshot& latestSnapshot(const ReplicationClient& client) {
+    static const Snapshot none;
+    if (client.latest == 0)
+        return none;
+    return client.received[client.latest % SNAPSHOT_HISTORY];
+}
+
+void disconnectReplicationClient(ReplicationClient& client) {
+    uint8_t leave = PACKET_LEAVE;
+    sendPacket(client.socket, client.server, &leave, 1);
+    closeUdpSocket(client.socket);
+    client.joined = false;
+    client.latest = 0;
+}
@@ -0,0 +1,276 @@
+#include <shader.hpp>
+#include <hash.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifndef SHADER_CACHE_DIR
+#define SHADER_CACHE_DIR "shader_cache"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const uint32_t cacheMagic = 0x42505347; // "GSPB"
+const uint32_t cacheVersion = 1;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t binaryFormat;
+    uint32_t length;
+};
+
+std::string glString(GLenum name) {
+    const GLubyte* value = glGetString(name);
+    return value ? reinterpret_cast<const char*>(value) : "";
+}
+
+bool programBinarySupported() {
+    if (!GLAD_GL_VERSION_4_1)
+        return false;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+bool expandIncludes(const fs::path& path, std::string& out, std::vector<std::string>& dependencies,
+                    std::vector<std::string>& stack) {
+    std::string file = path.lexically_normal().string();
+    for (const std::string& open : stack) {
+        if (open == file) {
+            std::cout << "ERROR::SHADER::INCLUDE_CYCLE\n" << file << std::endl;
+            return false;
+        }
+    }
+
+    std::ifstream in(file);
+    if (!in) {
+        std::cout << "ERROR::SHADER::FILE_NOT_READ\n" << file << std::endl;
+        return false;
+    }
+    dependencies.push_back(file);
+    stack.push_back(file);
+
+    // #line's second argument is a source string number; use the dependency
+    // index so driver messages can be mapped back to the right file.
+    int fileIndex = static_cast<int>(dependencies.size()) - 1;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        size_t start = line.find_first_not_of(" \t");
+        if (start != std::string::npos && line.compare(start, 8, "#include") == 0) {
+            size_t open = line.find('"', start);
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if (close == std::string::npos) {
+                std::cout << "ERROR::SHADER::BAD_INCLUDE\n" << file << ":" << lineNumber << std::endl;
+                return false;
+            }
+            fs::path included = path.parent_path() / line.substr(open + 1, close - open - 1);
+            out += "#line 1 " + std::to_string(dependencies.size()) + "\n";
+            if (!expandIncludes(included, out, dependencies, stack))
+                return false;
+            out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+            continue;
+        }
+        out += line;
+        out += '\n';
+    }
+
+    stack.pop_back();
+    return true;
+}
+
+GLuint compileStage(GLenum type, const std::string& source, const std::string& path) {
+    GLuint shader = glCreateShader(type);
+    const char* text = source.c_str();
+    glShaderSource(shader, 1, &text, nullptr);
+    glCompileShader(shader);
+
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        std::cout << "ERROR::SHADER::COMPILATION_FAILED " << path << "\n" << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint loadCachedBinary(const std::string& cacheFile) {
+    std::ifstream in(cacheFile, std::ios::binary);
+    if (!in)
+        return 0;
+
+    CacheHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != cacheMagic || header.version != cacheVersion)
+        return 0;
+
+    std::vector<char> binary(header.length);
+    if (!in.read(binary.data(), binary.size()))
+        return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // driver rejected it (e.g. it was updated in place); fall back to source
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void storeCachedBinary(GLuint program, const std::string& cacheFile) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+    std::error_code ec;
+    fs::create_directories(fs::path(cacheFile).parent_path(), ec);
+    // write to a temporary first so a crash never leaves a truncated entry
+    std::string tmpFile = cacheFile + ".tmp";
+    {
+        std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return;
+        CacheHeader header = {cacheMagic, cacheVersion, format, static_cast<uint32_t>(length)};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(binary.data(), binary.size());
+        if (!out)
+            return;
+    }
+    fs::rename(tmpFile, cacheFile, ec);
+}
+
+std::vector<fs::file_time_type> timestampsOf(const std::vector<fs::path>& files) {
+    std::vector<fs::file_time_type> times;
+    for (const fs::path& file : files) {
+        std::error_code ec;
+        times.push_back(fs::last_write_time(file, ec));
+    }
+    return times;
+}
+
+// Polled every frame or so, so it compares in place and never allocates
+bool timestampsChanged(const ShaderProgram& program) {
+    for (size_t i = 0; i < program.watchedPaths.size(); ++i) {
+        std::error_code ec;
+        if (fs::last_write_time(program.watchedPaths[i], ec) != program.timestamps[i])
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+std::string shaderPath(const std::string& name) {
+    return std::string(PROJECT_SOURCE_DIR) + "/shaders/" + name;
+}
+
+bool loadShaderSource(const std::string& path, std::string& source, std::vector<std::string>& dependencies) {
+    std::vector<std::string> stack;
+    source.clear();
+    return expandIncludes(fs::path(path), source, dependencies, stack);
+}
+
+bool buildShaderProgram(ShaderProgram& program) {
+    std::vector<std::string> dependencies;
+    std::vector<std::string> sources;
+    for (const ShaderStage& stage : program.stages) {
+        std::string source;
+        if (!loadShaderSource(stage.path, source, dependencies))
+            return false;
+        sources.push_back(source);
+    }
+
+    // key = expanded sources + stage types + driver identity
+    uint64_t key = hashBytes(glString(GL_VENDOR) + glString(GL_RENDERER) + glString(GL_VERSION));
+    for (size_t i = 0; i < sources.size(); ++i)
+        key = hashBytes(std::to_string(program.stages[i].type) + sources[i], key);
+    char keyName[32];
+    std::snprintf(keyName, sizeof(keyName), "%016llx.bin", static_cast<unsigned long long>(key));
+    std::string cacheFile = std::string(SHADER_CACHE_DIR) + "/" + keyName;
+
+    bool useCache = programBinarySupported();
+    GLuint id = useCache ? loadCachedBinary(cacheFile) : 0;
+    bool fromCache = id != 0;
+
+    if (!id) {
+        std::vector<GLuint> shaders;
+        for (size_t i = 0; i < sources.size(); ++i) {
+            GLuint shader = compileStage(program.stages[i].type, sources[i], program.stages[i].path);
+            if (!shader) {
+                for (GLuint s : shaders)
+                    glDeleteShader(s);
+                return false;
+            }
+            shaders.push_back(shader);
+        }
+
+        id = glCreateProgram();
+        for (GLuint shader : shaders)
+            glAttachShader(id, shader);
+        if (useCache)
+            glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(id);
+        for (GLuint shader : shaders)
+            glDeleteShader(shader);
+
+        int success;
+        glGetProgramiv(id, GL_LINK_STATUS, &success);
+        if (!success) {
+            char infoLog[1024];
+            glGetProgramInfoLog(id, sizeof(infoLog), nullptr, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+            glDeleteProgram(id);
+            return false;
+        }
+        if (useCache)
+            storeCachedBinary(id, cacheFile);
+    }
+
+    if (program.id)
+        glDeleteProgram(program.id);
+    program.id = id;
+    program.loadedFromCache = fromCache;
+    program.dependencies = dependencies;
+    program.watchedPaths.assign(dependencies.begin(), dependencies.end());
+    program.timestamps = timestampsOf(program.watchedPaths);
+    return true;
+}
+
+bool reloadShaderProgramIfChanged(ShaderProgram& program) {
+    if (!timestampsChanged(program))
+        return false;
+
+    // remember the new stamps even on failure, otherwise a broken file would be
+    // recompiled (and reported) every frame until it is fixed
+    program.timestamps = timestampsOf(program.watchedPaths);
+    if (!buildShaderProgram(program)) {
+        std::cout << "Shader reload failed, keeping previous program" << std::endl;
+        return false;
+    }
+    std::cout << "Reloaded shader program " << program.id << std::endl;
+    return true;
+}
+
+void deleteShaderProgram(ShaderProgram& program) {
+    if (program.id)
+        glDeleteProgram(program.id);
+    program.id = 0;
+}
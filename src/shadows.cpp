@@ -0,0 +1,222 @@
+#include <shadows.hpp>
+#include <memory_stats.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// Every corner of an axis-aligned box
+void boxCorners(const glm::vec3& boundsMin, const glm::vec3& boundsMax, glm::vec3 corners[8]) {
+    for (int i = 0; i < 8; ++i)
+        corners[i] = glm::vec3(i & 1 ? boundsMax.x : boundsMin.x, i & 2 ? boundsMax.y : boundsMin.y,
+                               i & 4 ? boundsMax.z : boundsMin.z);
+}
+
+GLuint createShadowTexture() {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 0, GL_DEPTH_COMPONENT,
+                 GL_FLOAT, nullptr);
+    trackTextureMemory(MEMORY_SHADOWS, texture,
+                       static_cast<size_t>(SHADOW_MAP_SIZE) * SHADOW_MAP_SIZE * texelBytes(GL_DEPTH_COMPONENT32F));
+    // hardware 2x2 PCF through sampler2DShadow
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+// Depth-only framebuffer around `texture`, cleared to "nothing in the way"
+GLuint createShadowFramebuffer(GLuint texture) {
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "ERROR::SHADOWS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+    glViewport(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+    glClearDepth(1.0);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return fbo;
+}
+
+void beginShadowPass(const ShadowMaps& shadows, GLuint fbo) {
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glViewport(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    // slope-scaled bias keeps lit faces from shadowing themselves
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+    glUseProgram(shadows.depthProgram.id);
+    glUniformMatrix4fv(glGetUniformLocation(shadows.depthProgram.id, "lightMatrix"), 1, GL_FALSE,
+                       glm::value_ptr(shadows.lightMatrix));
+}
+
+void endShadowPass() {
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+} // namespace
+
+bool initShadowMaps(ShadowMaps& shadows, const MazeMesh& mesh, const glm::vec3& sunDirection, int tileBudget) {
+    shadows.depthProgram.stages = {{GL_VERTEX_SHADER, shaderPath("shadow_depth.vert")},
+                                   {GL_FRAGMENT_SHADER, shaderPath("shadow_depth.frag")}};
+    if (!buildShaderProgram(shadows.depthProgram))
+        return false;
+    shadows.sunDirection = glm::normalize(sunDirection);
+    shadows.tileBudget = std::max(tileBudget, 1);
+
+    // fit an orthographic projection around the whole maze as the sun sees it
+    glm::vec3 mazeMin(1e30f), mazeMax(-1e30f);
+    for (size_t i = 0; i < mesh.chunks.size(); ++i) {
+        glm::vec3 boundsMin, boundsMax;
+        mazeChunkFootprint(mesh, static_cast<int>(i), boundsMin, boundsMax);
+        mazeMin = glm::min(mazeMin, boundsMin);
+        mazeMax = glm::max(mazeMax, boundsMax);
+    }
+    if (mesh.chunks.empty())
+        mazeMin = mazeMax = glm::vec3(0.0f);
+    glm::vec3 centre = (mazeMin + mazeMax) * 0.5f;
+    float radius = glm::length(mazeMax - mazeMin) * 0.5f + 1.0f;
+    glm::vec3 up = std::abs(shadows.sunDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::mat4 lightView = glm::lookAt(centre - shadows.sunDirection * radius, centre, up);
+
+    glm::vec3 corners[8];
+    boxCorners(mazeMin, mazeMax, corners);
+    glm::vec3 lightMin(1e30f), lightMax(-1e30f);
+    for (const glm::vec3& corner : corners) {
+        glm::vec3 p = glm::vec3(lightView * glm::vec4(corner, 1.0f));
+        lightMin = glm::min(lightMin, p);
+        lightMax = glm::max(lightMax, p);
+    }
+    // view space looks down -z, so the nearest point has the largest z
+    glm::mat4 lightProjection = glm::ortho(lightMin.x, lightMax.x, lightMin.y, lightMax.y, -lightMax.z - 1.0f,
+                                           -lightMin.z + 1.0f);
+    shadows.lightMatrix = lightProjection * lightView;
+
+    // which tiles each chunk's walls can land on
+    shadows.chunkRects.resize(mesh.chunks.size());
+    for (size_t i = 0; i < mesh.chunks.size(); ++i) {
+        glm::vec3 boundsMin, boundsMax;
+        mazeChunkFootprint(mesh, static_cast<int>(i), boundsMin, boundsMax);
+        boxCorners(boundsMin, boundsMax, corners);
+        glm::vec2 rectMin(1e30f), rectMax(-1e30f);
+        for (const glm::vec3& corner : corners) {
+            glm::vec4 clip = shadows.lightMatrix * glm::vec4(corner, 1.0f);
+            glm::vec2 tile = (glm::vec2(clip.x, clip.y) / clip.w * 0.5f + 0.5f) * static_cast<float>(SHADOW_TILES);
+            rectMin = glm::min(rectMin, tile);
+            rectMax = glm::max(rectMax, tile);
+        }
+        shadows.chunkRects[i] = glm::vec4(rectMin.x, rectMin.y, rectMax.x, rectMax.y);
+    }
+
+    shadows.staticMap = createShadowTexture();
+    shadows.dynamicMap = createShadowTexture();
+    shadows.staticFbo = createShadowFramebuffer(shadows.staticMap);
+    shadows.dynamicFbo = createShadowFramebuffer(shadows.dynamicMap);
+
+    // chunks invalidate their tiles as they stream in; nothing to draw yet
+    shadows.dirtyTiles.assign(SHADOW_TILES * SHADOW_TILES, false);
+    shadows.dirtyCount = 0;
+    return true;
+}
+
+void invalidateShadowChunk(ShadowMaps& shadows, int index) {
+    if (index < 0 || index >= static_cast<int>(shadows.chunkRects.size()))
+        return;
+    const glm::vec4& rect = shadows.chunkRects[index];
+    int x0 = std::max(static_cast<int>(std::floor(rect.x)), 0);
+    int y0 = std::max(static_cast<int>(std::floor(rect.y)), 0);
+    int x1 = std::min(static_cast<int>(std::floor(rect.z)), SHADOW_TILES - 1);
+    int y1 = std::min(static_cast<int>(std::floor(rect.w)), SHADOW_TILES - 1);
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            if (shadows.dirtyTiles[y * SHADOW_TILES + x])
+                continue;
+            shadows.dirtyTiles[y * SHADOW_TILES + x] = true;
+            ++shadows.dirtyCount;
+        }
+    }
+}
+
+void updateShadowMaps(ShadowMaps& shadows, const MazeMesh& mesh, const ShadowCasterCallback& dynamicCasters) {
+    shadows.tilesRendered = 0;
+    if (shadows.dirtyCount > 0) {
+        beginShadowPass(shadows, shadows.staticFbo);
+        glEnable(GL_SCISSOR_TEST);
+        std::vector<GLuint> casters;
+        for (int tile = 0; tile < SHADOW_TILES * SHADOW_TILES && shadows.tilesRendered < shadows.tileBudget; ++tile) {
+            if (!shadows.dirtyTiles[tile])
+                continue;
+            int tileX = tile % SHADOW_TILES, tileY = tile / SHADOW_TILES;
+
+            // every chunk whose walls reach into the tile; the scissor keeps
+            // the rest of the cached map untouched
+            casters.clear();
+            for (size_t i = 0; i < mesh.chunks.size(); ++i) {
+                const glm::vec4& rect = shadows.chunkRects[i];
+                if (mesh.chunks[i].indexCount == 0 || rect.z < tileX || rect.x > tileX + 1 || rect.w < tileY ||
+                    rect.y > tileY + 1)
+                    continue;
+                casters.push_back(static_cast<GLuint>(i));
+            }
+            glScissor(tileX * SHADOW_TILE_SIZE, tileY * SHADOW_TILE_SIZE, SHADOW_TILE_SIZE, SHADOW_TILE_SIZE);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            drawMazeChunkList(mesh, casters);
+
+            shadows.dirtyTiles[tile] = false;
+            --shadows.dirtyCount;
+            ++shadows.tilesRendered;
+        }
+        endShadowPass();
+    }
+
+    // moving casters go into a fresh copy of the cached map every frame
+    shadows.hasDynamic = static_cast<bool>(dynamicCasters);
+    if (shadows.hasDynamic) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, shadows.staticFbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, shadows.dynamicFbo);
+        glBlitFramebuffer(0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 0, 0, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE,
+                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        beginShadowPass(shadows, shadows.dynamicFbo);
+        dynamicCasters(shadows.depthProgram.id, shadows.lightMatrix);
+        endShadowPass();
+    }
+}
+
+void bindShadowMaps(GLuint program, const ShadowMaps& shadows, int unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, shadows.hasDynamic ? shadows.dynamicMap : shadows.staticMap);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(program, "sunShadowMap"), unit);
+    glUniformMatrix4fv(glGetUniformLocation(program, "sunMatrix"), 1, GL_FALSE, glm::value_ptr(shadows.lightMatrix));
+    glUniform3fv(glGetUniformLocation(program, "sunDirection"), 1, glm::value_ptr(shadows.sunDirection));
+    glUniform1i(glGetUniformLocation(program, "sunEnabled"), shadows.staticMap != 0);
+}
+
+void deleteShadowMaps(ShadowMaps& shadows) {
+    glDeleteFramebuffers(1, &shadows.staticFbo);
+    glDeleteFramebuffers(1, &shadows.dynamicFbo);
+    untrackTextureMemory(shadows.staticMap);
+    untrackTextureMemory(shadows.dynamicMap);
+    glDeleteTextures(1, &shadows.staticMap);
+    glDeleteTextures(1, &shadows.dynamicMap);
+    deleteShaderProgram(shadows.depthProgram);
+    shadows = ShadowMaps();
+}
@@ -0,0 +1,117 @@
+#include <spatial_hash.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+int32_t cellOf(float position, float cellSize) {
+    return static_cast<int32_t>(std::floor(position / cellSize + 0.5f));
+}
+
+uint32_t bucketOf(const SpatialHash& hash, int32_t cellX, int32_t cellZ) {
+    uint32_t key = static_cast<uint32_t>(cellX) * 73856093u ^ static_cast<uint32_t>(cellZ) * 19349663u;
+    return key & hash.bucketMask;
+}
+
+// Visit the stored entities of every cell overlapping [boxMin, boxMax];
+// `test` decides which of them are appended
+template <typename Test>
+int queryCells(const SpatialHash& hash, const glm::vec2& boxMin, const glm::vec2& boxMax,
+               std::vector<uint32_t>& results, const Test& test) {
+    size_t before = results.size();
+    int32_t x0 = cellOf(boxMin.x, hash.cellSize), x1 = cellOf(boxMax.x, hash.cellSize);
+    int32_t z0 = cellOf(boxMin.y, hash.cellSize), z1 = cellOf(boxMax.y, hash.cellSize);
+
+    // more cells than entities: a straight scan is cheaper than probing
+    if ((static_cast<int64_t>(x1) - x0 + 1) * (static_cast<int64_t>(z1) - z0 + 1) > hash.count) {
+        for (int i = 0; i < hash.count; ++i)
+            if (test(hash.x[i], hash.z[i]))
+                results.push_back(hash.ids[i]);
+        return static_cast<int>(results.size() - before);
+    }
+
+    for (int32_t cz = z0; cz <= z1; ++cz) {
+        for (int32_t cx = x0; cx <= x1; ++cx) {
+            uint32_t bucket = bucketOf(hash, cx, cz);
+            for (uint32_t i = hash.bucketStart[bucket]; i < hash.bucketStart[bucket + 1]; ++i) {
+                // other cells hashed to the same bucket are skipped here, so
+                // nothing is reported twice
+                if (hash.cellX[i] != cx || hash.cellZ[i] != cz)
+                    continue;
+                if (test(hash.x[i], hash.z[i]))
+                    results.push_back(hash.ids[i]);
+            }
+        }
+    }
+    return static_cast<int>(results.size() - before);
+}
+
+} // namespace
+
+void initSpatialHash(SpatialHash& hash, int capacity, float cellSize) {
+    hash.cellSize = cellSize;
+    hash.capacity = std::max(capacity, 1);
+    hash.count = 0;
+
+    // about two buckets per entity keeps collisions rare
+    uint32_t buckets = 1;
+    while (buckets < 2u * static_cast<uint32_t>(hash.capacity))
+        buckets <<= 1;
+    hash.bucketMask = buckets - 1;
+    hash.bucketStart.assign(buckets + 1, 0);
+
+    hash.entityBucket.resize(hash.capacity);
+    hash.ids.resize(hash.capacity);
+    hash.x.resize(hash.capacity);
+    hash.z.resize(hash.capacity);
+    hash.cellX.resize(hash.capacity);
+    hash.cellZ.resize(hash.capacity);
+}
+
+void buildSpatialHash(SpatialHash& hash, const float* x, const float* z, int count) {
+    if (count > hash.capacity)
+        initSpatialHash(hash, count, hash.cellSize);
+    hash.count = count;
+    std::fill(hash.bucketStart.begin(), hash.bucketStart.end(), 0u);
+
+    // counting sort: count per bucket, prefix sum, scatter
+    for (int i = 0; i < count; ++i) {
+        uint32_t bucket = bucketOf(hash, cellOf(x[i], hash.cellSize), cellOf(z[i], hash.cellSize));
+        hash.entityBucket[i] = bucket;
+        ++hash.bucketStart[bucket + 1];
+    }
+    for (size_t bucket = 1; bucket < hash.bucketStart.size(); ++bucket)
+        hash.bucketStart[bucket] += hash.bucketStart[bucket - 1];
+
+    // scatter with bucketStart[bucket] as the write cursor, which walks it
+    // forward onto the next bucket's start; shifting back restores it
+    for (int i = 0; i < count; ++i) {
+        uint32_t slot = hash.bucketStart[hash.entityBucket[i]]++;
+        hash.ids[slot] = static_cast<uint32_t>(i);
+        hash.x[slot] = x[i];
+        hash.z[slot] = z[i];
+        hash.cellX[slot] = cellOf(x[i], hash.cellSize);
+        hash.cellZ[slot] = cellOf(z[i], hash.cellSize);
+    }
+    for (size_t bucket = hash.bucketStart.size() - 1; bucket > 0; --bucket)
+        hash.bucketStart[bucket] = hash.bucketStart[bucket - 1];
+    hash.bucketStart[0] = 0;
+}
+
+int querySpatialHashRadius(const SpatialHash& hash, const glm::vec2& centre, float radius,
+                           std::vector<uint32_t>& results) {
+    float radiusSquared = radius * radius;
+    return queryCells(hash, centre - glm::vec2(radius), centre + glm::vec2(radius), results,
+                      [&](float x, float z) {
+                          float dx = x - centre.x, dz = z - centre.y;
+                          return dx * dx + dz * dz <= radiusSquared;
+                      });
+}
+
+int querySpatialHashBox(const SpatialHash& hash, const glm::vec2& boxMin, const glm::vec2& boxMax,
+                        std::vector<uint32_t>& results) {
+    return queryCells(hash, boxMin, boxMax, results, [&](float x, float z) {
+        return x >= boxMin.x && x <= boxMax.x && z >= boxMin.y && z <= boxMax.y;
+    });
+}
@@ -0,0 +1,290 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <textures.hpp>
+#include <hash.hpp>
+#include <memory_stats.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifndef TEXTURE_CACHE_DIR
+#define TEXTURE_CACHE_DIR "texture_cache"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const uint32_t cacheMagic = 0x58455447; // "GTEX"
+const uint32_t cacheVersion = 1;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t levels;
+};
+
+// Filtering happens in linear light so mips do not darken
+struct SrgbTable {
+    float toLinear[256];
+    SrgbTable() {
+        for (int i = 0; i < 256; ++i) {
+            float c = i / 255.0f;
+            toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+    }
+};
+const SrgbTable srgb;
+
+uint8_t toSrgb(float linear) {
+    linear = std::min(std::max(linear, 0.0f), 1.0f);
+    float c = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+    return static_cast<uint8_t>(c * 255.0f + 0.5f);
+}
+
+// Channel `c` of an RGBA8 texel in linear light (alpha stays linear)
+float linearAt(const uint8_t* pixels, int width, int x, int y, int c) {
+    uint8_t value = pixels[(y * width + x) * 4 + c];
+    return c == 3 ? value / 255.0f : srgb.toLinear[value];
+}
+
+uint8_t encode(float value, int c) {
+    return c == 3 ? static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f) : toSrgb(value);
+}
+
+// Bilinear resample of a width x height RGBA8 image to size x size
+std::vector<uint8_t> resample(const uint8_t* pixels, int width, int height, int size) {
+    std::vector<uint8_t> out(size * size * 4);
+    for (int y = 0; y < size; ++y) {
+        float sy = std::min(std::max((y + 0.5f) * height / size - 0.5f, 0.0f), height - 1.0f);
+        int y0 = static_cast<int>(sy);
+        int y1 = std::min(y0 + 1, height - 1);
+        float fy = sy - y0;
+        for (int x = 0; x < size; ++x) {
+            float sx = std::min(std::max((x + 0.5f) * width / size - 0.5f, 0.0f), width - 1.0f);
+            int x0 = static_cast<int>(sx);
+            int x1 = std::min(x0 + 1, width - 1);
+            float fx = sx - x0;
+            for (int c = 0; c < 4; ++c) {
+                float top = linearAt(pixels, width, x0, y0, c) * (1 - fx) + linearAt(pixels, width, x1, y0, c) * fx;
+                float bottom = linearAt(pixels, width, x0, y1, c) * (1 - fx) + linearAt(pixels, width, x1, y1, c) * fx;
+                out[(y * size + x) * 4 + c] = encode(top * (1 - fy) + bottom * fy, c);
+            }
+        }
+    }
+    return out;
+}
+
+// 2x2 box filter down to 1x1
+void buildMips(TextureImage& image) {
+    image.levels.resize(1);
+    for (int size = image.size; size > 1; size /= 2) {
+        const std::vector<uint8_t>& src = image.levels.back();
+        int half = size / 2;
+        std::vector<uint8_t> dst(half * half * 4);
+        for (int y = 0; y < half; ++y) {
+            for (int x = 0; x < half; ++x) {
+                for (int c = 0; c < 4; ++c) {
+                    float sum = linearAt(src.data(), size, 2 * x, 2 * y, c) +
+                                linearAt(src.data(), size, 2 * x + 1, 2 * y, c) +
+                                linearAt(src.data(), size, 2 * x, 2 * y + 1, c) +
+                                linearAt(src.data(), size, 2 * x + 1, 2 * y + 1, c);
+                    dst[(y * half + x) * 4 + c] = encode(sum * 0.25f, c);
+                }
+            }
+        }
+        image.levels.push_back(std::move(dst));
+    }
+}
+
+void checkerboard(TextureImage& image, int size) {
+    image.size = size;
+    image.levels.assign(1, std::vector<uint8_t>(size * size * 4));
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            uint8_t value = ((x / 16 + y / 16) & 1) ? 200 : 60;
+            uint8_t* texel = &image.levels[0][(y * size + x) * 4];
+            texel[0] = value;
+            texel[1] = 0;
+            texel[2] = value;
+            texel[3] = 255;
+        }
+    }
+    buildMips(image);
+}
+
+std::string cacheFileFor(const std::string& path, int size) {
+    std::error_code ec;
+    uintmax_t fileSize = fs::file_size(path, ec);
+    auto modified = fs::last_write_time(path, ec).time_since_epoch().count();
+
+    uint64_t key = hashBytes(path);
+    key = hashBytes(&fileSize, sizeof(fileSize), key);
+    key = hashBytes(&modified, sizeof(modified), key);
+    key = hashBytes(&size, sizeof(size), key);
+    char keyName[32];
+    std::snprintf(keyName, sizeof(keyName), "%016llx.tex", static_cast<unsigned long long>(key));
+    return std::string(TEXTURE_CACHE_DIR) + "/" + keyName;
+}
+
+bool readCache(const std::string& cacheFile, int size, TextureImage& image) {
+    std::ifstream in(cacheFile, std::ios::binary);
+    if (!in)
+        return false;
+    CacheHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != cacheMagic ||
+        header.version != cacheVersion || header.size != static_cast<uint32_t>(size))
+        return false;
+
+    image.size = size;
+    image.levels.clear();
+    int levelSize = size;
+    for (uint32_t level = 0; level < header.levels; ++level, levelSize = std::max(levelSize / 2, 1)) {
+        std::vector<uint8_t> data(levelSize * levelSize * 4);
+        if (!in.read(reinterpret_cast<char*>(data.data()), data.size()))
+            return false;
+        image.levels.push_back(std::move(data));
+    }
+    return true;
+}
+
+void writeCache(const std::string& cacheFile, const TextureImage& image) {
+    std::error_code ec;
+    fs::create_directories(fs::path(cacheFile).parent_path(), ec);
+    // write to a temporary first so a crash never leaves a truncated entry
+    std::string tmpFile = cacheFile + ".tmp";
+    {
+        std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return;
+        CacheHeader header = {cacheMagic, cacheVersion, static_cast<uint32_t>(image.size),
+                              static_cast<uint32_t>(image.levels.size())};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const std::vector<uint8_t>& level : image.levels)
+            out.write(reinterpret_cast<const char*>(level.data()), level.size());
+        if (!out)
+            return;
+    }
+    fs::rename(tmpFile, cacheFile, ec);
+}
+
+} // namespace
+
+std::string texturePath(const std::string& name) {
+    return std::string(PROJECT_SOURCE_DIR) + "/textures/" + name;
+}
+
+void loadTextureImage(const std::string& path, int size, TextureImage& image, bool& fromCache) {
+    fromCache = false;
+    std::string cacheFile = cacheFileFor(path, size);
+    if (readCache(cacheFile, size, image)) {
+        fromCache = true;
+        return;
+    }
+
+    int width, height, channels;
+    stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (!pixels) {
+        std::cout << "ERROR::TEXTURE::LOAD_FAILED " << path << "\n" << stbi_failure_reason() << std::endl;
+        checkerboard(image, size);
+        return;
+    }
+    image.size = size;
+    image.levels.assign(1, resample(pixels, width, height, size));
+    stbi_image_free(pixels);
+    buildMips(image);
+    writeCache(cacheFile, image);
+}
+
+void startTextureArrayLoad(TextureArrayLoad& load, JobSystem* jobs, const std::vector<std::string>& paths, int size) {
+    load.jobs = jobs;
+    load.paths = paths;
+    load.images.assign(paths.size(), TextureImage());
+    load.fromCache = 0;
+
+    auto loadLayer = [&load, size](size_t layer) {
+        bool fromCache = false;
+        loadTextureImage(load.paths[layer], size, load.images[layer], fromCache);
+        if (fromCache)
+            ++load.fromCache;
+    };
+
+    if (!jobs) {
+        for (size_t layer = 0; layer < paths.size(); ++layer)
+            loadLayer(layer);
+        return;
+    }
+    load.done = createJob(nullptr);
+    for (size_t layer = 0; layer < paths.size(); ++layer)
+        runJob(*jobs, createJob([loadLayer, layer] { loadLayer(layer); }, load.done));
+    // the parent has no work of its own; it completes with its last layer
+    runJob(*jobs, load.done);
+}
+
+bool textureArrayLoadFinished(const TextureArrayLoad& load) {
+    return !load.images.empty() && (!load.done || jobFinished(load.done));
+}
+
+void uploadTextureArray(TextureArrayLoad& load, TextureArray& array) {
+    if (load.images.empty())
+        return;
+    int size = load.images[0].size;
+    GLsizei layers = static_cast<GLsizei>(load.images.size());
+    GLsizei levels = static_cast<GLsizei>(load.images[0].levels.size());
+
+    if (!array.id)
+        glGenTextures(1, &array.id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.id);
+    int levelSize = size;
+    size_t bytes = 0;
+    for (GLsizei level = 0; level < levels; ++level, levelSize = std::max(levelSize / 2, 1)) {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, levelSize, levelSize, layers, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, nullptr);
+        bytes += static_cast<size_t>(levelSize) * levelSize * layers * texelBytes(GL_RGBA8);
+        for (GLsizei layer = 0; layer < layers; ++layer)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, levelSize, levelSize, 1, GL_RGBA,
+                            GL_UNSIGNED_BYTE, load.images[layer].levels[level].data());
+    }
+    trackTextureMemory(MEMORY_TEXTURES, array.id, bytes);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    array.layers = layers;
+    array.size = size;
+    std::cout << "Loaded " << layers << " texture layers (" << load.fromCache.load() << " from cache)" << std::endl;
+    load.images.clear();
+    load.done.reset();
+}
+
+void cancelTextureArrayLoad(TextureArrayLoad& load) {
+    if (load.done && load.jobs)
+        waitForJob(*load.jobs, load.done);
+    load.images.clear();
+    load.done.reset();
+}
+
+void bindTextureArray(GLuint program, const TextureArray& array, const char* sampler, const char* layersUniform,
+                      int unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.id);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(glGetUniformLocation(program, sampler), unit);
+    glUniform1i(glGetUniformLocation(program, layersUniform), array.id ? array.layers : 0);
+}
+
+void deleteTextureArray(TextureArray& array) {
+    untrackTextureMemory(array.id);
+    glDeleteTextures(1, &array.id);
+    array.id = 0;
+    array.layers = 0;
+}